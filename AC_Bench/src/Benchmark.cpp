@@ -0,0 +1,129 @@
+#include "Benchmark.hpp"
+#include "BranchCounter.hpp"
+#include "MemoryCounter.hpp"
+
+#include "AdaptiveScalingCoder.hpp"
+#include "BinaryCoder.hpp"
+#include "BlockCoder.hpp"
+#include "BwtCoder.hpp"
+#include "ContextMixingCoder.hpp"
+#include "InterleavedCoder.hpp"
+#include "LzCoder.hpp"
+#include "Order1Coder.hpp"
+#include "PPMCoder.hpp"
+#include "RansCoder.hpp"
+#include "RunLengthCoder.hpp"
+#include "StaticCoder.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+std::vector<BenchmarkedCoder> benchmarkedCoders()
+{
+	std::vector<BenchmarkedCoder> coders;
+
+	coders.push_back({ "adaptive", false, [](unsigned) {
+		return std::make_unique<AdaptiveScalingCoder>();
+	} });
+
+	coders.push_back({ "adaptive-blocks", true, [](unsigned threads) {
+		auto factory = []() { return std::make_unique<AdaptiveScalingCoder>(); };
+		return std::make_unique<BlockCoder>(factory, threads);
+	} });
+
+	coders.push_back({ "adaptive-x4", false, [](unsigned) {
+		return std::make_unique<InterleavedCoder>(4);
+	} });
+
+	coders.push_back({ "adaptive-runs", false, [](unsigned) {
+		return std::make_unique<RunLengthCoder>();
+	} });
+
+	coders.push_back({ "binary", false, [](unsigned) {
+		return std::make_unique<BinaryCoder>();
+	} });
+
+	coders.push_back({ "static", true, [](unsigned threads) {
+		return std::make_unique<StaticCoder>(threads);
+	} });
+
+	coders.push_back({ "rans", false, [](unsigned) {
+		return std::make_unique<RansCoder>();
+	} });
+
+	coders.push_back({ "lz", false, [](unsigned) {
+		return std::make_unique<LzCoder>();
+	} });
+
+	coders.push_back({ "bwt", false, [](unsigned) {
+		return std::make_unique<BwtCoder>();
+	} });
+
+	coders.push_back({ "order1", false, [](unsigned) {
+		return std::make_unique<Order1Coder>();
+	} });
+
+	coders.push_back({ "ppm", false, [](unsigned) {
+		return std::make_unique<PPMCoder>();
+	} });
+
+	coders.push_back({ "cm", false, [](unsigned) {
+		return std::make_unique<ContextMixingCoder>();
+	} });
+
+	return coders;
+}
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	double secondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+}
+
+BenchmarkResult runBenchmark(const BenchmarkedCoder& coder, const Corpus& corpus, unsigned threads, unsigned repetitions)
+{
+	BenchmarkResult result;
+	result.coder = coder.name;
+	result.corpus = corpus.name;
+	result.threads = threads;
+	result.inputBytes = corpus.data.size();
+
+	BranchCounter branchMisses;
+	result.branchMissesCounted = branchMisses.available();
+
+	for (unsigned i = 0; i < std::max(repetitions, 1u); i++)
+	{
+		std::vector<uint8_t> encoded;
+		std::vector<uint8_t> decoded;
+
+		size_t baseline = MemoryCounter::current();
+		MemoryCounter::resetPeak();
+		auto start = Clock::now();
+		branchMisses.start();
+		coder.create(threads)->encode(corpus.data.data(), corpus.data.size(), encoded);
+		result.encodeBranchMisses = std::min(result.encodeBranchMisses, branchMisses.stop());
+		result.encodeSeconds = std::min(result.encodeSeconds, secondsSince(start));
+		result.encodePeakMemory = std::max(result.encodePeakMemory, MemoryCounter::peak() - baseline - encoded.capacity());
+
+		decoded.reserve(corpus.data.size());	// output is not a part of the decoder's memory
+		baseline = MemoryCounter::current();
+		MemoryCounter::resetPeak();
+		start = Clock::now();
+		branchMisses.start();
+		coder.create(threads)->decode(encoded.data(), encoded.size(), decoded);
+		result.decodeBranchMisses = std::min(result.decodeBranchMisses, branchMisses.stop());
+		result.decodeSeconds = std::min(result.decodeSeconds, secondsSince(start));
+		result.decodePeakMemory = std::max(result.decodePeakMemory, MemoryCounter::peak() - baseline);
+
+		if (decoded != corpus.data)
+			throw std::runtime_error(coder.name + " decoded " + corpus.name + " incorrectly");
+		result.encodedBytes = encoded.size();
+	}
+
+	return result;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ArithmeticCoder.hpp"
+#include "Corpus.hpp"
+
+// A coder measured by the benchmark. New coders are added in benchmarkedCoders().
+struct BenchmarkedCoder
+{
+	std::string name;
+	bool multithreaded;		// whether it makes sense to run it with more than one thread
+	std::function<std::unique_ptr<ArithmeticCoder>(unsigned threads)> create;
+};
+
+std::vector<BenchmarkedCoder> benchmarkedCoders();
+
+struct BenchmarkResult
+{
+	std::string coder;
+	std::string corpus;
+	unsigned threads = 1;
+	size_t inputBytes = 0;
+	size_t encodedBytes = 0;
+	double encodeSeconds = 1e300;		// the best of all repetitions
+	double decodeSeconds = 1e300;
+	size_t encodePeakMemory = 0;	// heap bytes allocated on top of input and output
+	size_t decodePeakMemory = 0;
+	bool branchMissesCounted = false;	// whether the processor counter was available
+	uint64_t encodeBranchMisses = UINT64_MAX;	// mispredicted branches, the lowest of all repetitions
+	uint64_t decodeBranchMisses = UINT64_MAX;
+
+	double bitsPerByte() const { return inputBytes ? 8.0 * encodedBytes / inputBytes : 0; }
+	double encodeMBps() const { return inputBytes / encodeSeconds / 1e6; }
+	double decodeMBps() const { return inputBytes / decodeSeconds / 1e6; }
+	double encodeMissesPerByte() const { return inputBytes ? (double)encodeBranchMisses / inputBytes : 0; }
+	double decodeMissesPerByte() const { return inputBytes ? (double)decodeBranchMisses / inputBytes : 0; }
+};
+
+// Encodes and decodes the corpus in memory. Throws if decoded data differs from the input.
+BenchmarkResult runBenchmark(const BenchmarkedCoder& coder, const Corpus& corpus, unsigned threads, unsigned repetitions);
@@ -0,0 +1,56 @@
+#include "BranchCounter.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+
+BranchCounter::BranchCounter()
+{
+	perf_event_attr attributes;
+	std::memset(&attributes, 0, sizeof(attributes));
+	attributes.type = PERF_TYPE_HARDWARE;
+	attributes.size = sizeof(attributes);
+	attributes.config = PERF_COUNT_HW_BRANCH_MISSES;
+	attributes.disabled = 1;
+	attributes.exclude_kernel = 1;
+	attributes.exclude_hv = 1;
+	attributes.inherit = 1;		// threads started by coders (counted when they finish)
+	descriptor = (int)syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+}
+
+BranchCounter::~BranchCounter()
+{
+	if (available())
+		close(descriptor);
+}
+
+void BranchCounter::start()
+{
+	if (available()) {
+		ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+		ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+	}
+}
+
+uint64_t BranchCounter::stop()
+{
+	uint64_t count = 0;
+	if (available()) {
+		ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+		if (read(descriptor, &count, sizeof(count)) != sizeof(count))
+			count = 0;
+	}
+	return count;
+}
+
+#else
+
+BranchCounter::BranchCounter() {}
+BranchCounter::~BranchCounter() {}
+void BranchCounter::start() {}
+uint64_t BranchCounter::stop() { return 0; }
+
+#endif
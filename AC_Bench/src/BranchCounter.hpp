@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+// Counts mispredicted branches of this thread and threads it starts with
+// a hardware performance counter (perf_event_open on Linux). Where no counter is available - other
+// systems, virtual machines, restricted perf_event_paranoid - available()
+// is false and the results are not printed.
+class BranchCounter
+{
+public:
+	BranchCounter();
+	~BranchCounter();
+	BranchCounter(const BranchCounter&) = delete;
+	BranchCounter& operator=(const BranchCounter&) = delete;
+
+	bool available() const { return descriptor >= 0; }
+
+	void start();
+	uint64_t stop();	// mispredicted branches since start()
+
+private:
+	int descriptor = -1;
+};
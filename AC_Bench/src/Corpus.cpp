@@ -0,0 +1,221 @@
+#include "Corpus.hpp"
+#include "IO/FileIO.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+
+namespace
+{
+	// xorshift64* - small, fast and identical everywhere.
+	class Random
+	{
+	public:
+		Random(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ull | 1) {}
+
+		uint64_t next()
+		{
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			return state * 0x2545F4914F6CDD1Dull;
+		}
+
+		uint32_t below(uint32_t n)	// [0, n)
+		{
+			return (uint32_t)(((next() >> 32) * n) >> 32);
+		}
+
+		double uniform()	// [0, 1)
+		{
+			return (next() >> 11) * (1.0 / 9007199254740992.0);
+		}
+
+	private:
+		uint64_t state;
+	};
+
+	// Picks indices [0, n) with probability proportional to 1 / (i + 1)^exponent.
+	class ZipfTable
+	{
+	public:
+		ZipfTable(size_t n, double exponent)
+			: cumulative(n)
+		{
+			double sum = 0;
+			for (size_t i = 0; i < n; i++)
+				cumulative[i] = sum += 1.0 / std::pow((double)(i + 1), exponent);
+			for (double& c : cumulative)
+				c /= sum;
+		}
+
+		size_t pick(Random& random) const
+		{
+			auto it = std::upper_bound(cumulative.begin(), cumulative.end(), random.uniform());
+			return std::min((size_t)(it - cumulative.begin()), cumulative.size() - 1);
+		}
+
+	private:
+		std::vector<double> cumulative;
+	};
+
+	std::vector<uint8_t> uniform(size_t size, Random& random)
+	{
+		static const char ALPHABET[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789+/";
+		std::vector<uint8_t> data(size);
+		for (uint8_t& byte : data)
+			byte = ALPHABET[random.below(64)];
+		return data;
+	}
+
+	std::vector<uint8_t> zipf(size_t size, Random& random)
+	{
+		ZipfTable table(256, 1.1);
+		uint8_t permutation[256];	// popular symbols are spread over the byte range
+		for (int i = 0; i < 256; i++)
+			permutation[i] = (uint8_t)(i * 167 + 13);
+
+		std::vector<uint8_t> data(size);
+		for (uint8_t& byte : data)
+			byte = permutation[table.pick(random)];
+		return data;
+	}
+
+	std::vector<uint8_t> text(size_t size, Random& random)
+	{
+		static const char* SYLLABLES[] = {
+			"the", "an", "of", "in", "re", "ta", "con", "ing", "er", "pro", "is", "at", "ex", "ly", "de", "on",
+			"to", "com", "ble", "ment", "st", "or", "ca", "si", "ver", "al", "ti", "ma", "un", "po", "ed", "es"
+		};
+		static const char* PUNCTUATION[] = { ", ", ". ", "; ", ": ", "! ", "? " };
+
+		std::vector<std::string> vocabulary(4096);
+		for (std::string& word : vocabulary) {
+			size_t syllables = 1 + random.below(3) + random.below(2);
+			for (size_t i = 0; i < syllables; i++)
+				word += SYLLABLES[random.below(32)];
+		}
+
+		ZipfTable words(vocabulary.size(), 1.0);
+		std::vector<uint8_t> data;
+		data.reserve(size + 64);
+		size_t lineLength = 0;
+		bool capital = true;
+		while (data.size() < size)
+		{
+			std::string word = vocabulary[words.pick(random)];
+			if (capital)
+				word[0] = (char)(word[0] - 'a' + 'A');
+			data.insert(data.end(), word.begin(), word.end());
+			lineLength += word.size();
+
+			uint32_t separator = random.below(100);
+			capital = separator < 8;
+			if (separator < 8) {
+				const char* mark = PUNCTUATION[1 + random.below(5)];
+				data.insert(data.end(), mark, mark + 2);
+			}
+			else if (separator < 14) {
+				const char* mark = PUNCTUATION[0];
+				data.insert(data.end(), mark, mark + 2);
+			}
+			else
+				data.push_back(' ');
+
+			if (lineLength > 72) {
+				data.back() = '\n';
+				lineLength = 0;
+			}
+		}
+		data.resize(size);
+		return data;
+	}
+
+	std::vector<uint8_t> runs(size_t size, Random& random)
+	{
+		std::vector<uint8_t> data;
+		data.reserve(size);
+		while (data.size() < size)
+		{
+			uint8_t byte = (uint8_t)random.below(16);
+			size_t length = 1 + random.below(2000);
+			data.insert(data.end(), std::min(length, size - data.size()), byte);
+		}
+		return data;
+	}
+
+	std::vector<uint8_t> logs(size_t size, Random& random)
+	{
+		static const char* LEVELS[] = { "INFO ", "INFO ", "INFO ", "DEBUG", "WARN ", "ERROR" };
+		static const char* MESSAGES[] = {
+			"Request GET /api/items/%u completed in %u ms",
+			"Request POST /api/orders completed in %u ms with status %u",
+			"Cache miss for key session:%u, loading from database (%u rows)",
+			"Connection pool: %u active, %u idle connections",
+			"User %u logged in from 10.0.%u.17",
+			"Retrying job %u after timeout (attempt %u of 5)",
+			"Scheduled task cleanup finished, removed %u files in %u ms",
+			"Slow query detected: SELECT * FROM items WHERE owner = %u took %u ms"
+		};
+
+		std::vector<uint8_t> data;
+		data.reserve(size + 256);
+		uint32_t seconds = 43200;
+		char line[256];
+		while (data.size() < size)
+		{
+			// drawn one by one, the order of evaluating arguments is unspecified
+			seconds += random.below(3);
+			uint32_t milliseconds = random.below(1000);
+			const char* level = LEVELS[random.below(6)];
+			uint32_t worker = random.below(8);
+			const char* message = MESSAGES[random.below(8)];
+			uint32_t first = random.below(5000);
+			uint32_t second = random.below(200);
+
+			int length = snprintf(line, sizeof(line), "2020-05-14 %02u:%02u:%02u.%03u %s [worker-%u] ",
+				seconds / 3600 % 24, seconds / 60 % 60, seconds % 60, milliseconds, level, worker);
+			length += snprintf(line + length, sizeof(line) - length, message, first, second);
+			line[length++] = '\n';
+			data.insert(data.end(), line, line + length);
+		}
+		data.resize(size);
+		return data;
+	}
+
+	std::vector<uint8_t> incompressible(size_t size, Random& random)
+	{
+		std::vector<uint8_t> data(size);
+		for (size_t i = 0; i < size; i += 8) {
+			uint64_t bits = random.next();
+			for (size_t j = i; j < std::min(i + 8, size); j++, bits >>= 8)
+				data[j] = (uint8_t)bits;
+		}
+		return data;
+	}
+}
+
+std::vector<Corpus> syntheticCorpora(size_t size, uint64_t seed)
+{
+	std::vector<Corpus> corpora;
+	Random random(seed);
+	corpora.push_back({ "uniform", uniform(size, random) });
+	corpora.push_back({ "zipf", zipf(size, random) });
+	corpora.push_back({ "text", text(size, random) });
+	corpora.push_back({ "runs", runs(size, random) });
+	corpora.push_back({ "logs", logs(size, random) });
+	corpora.push_back({ "random", incompressible(size, random) });
+	return corpora;
+}
+
+Corpus fileCorpus(const std::string& path)
+{
+	Corpus corpus{ std::filesystem::path(path).filename().string(), {} };
+
+	auto source = openFileSource(path, FileBackend::Mapped);
+	const uint8_t* chunk;
+	while (size_t size = source->next(chunk))
+		corpus.data.insert(corpus.data.end(), chunk, chunk + size);
+	return corpus;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Named input for benchmarks.
+struct Corpus
+{
+	std::string name;
+	std::vector<uint8_t> data;
+};
+
+// Synthetic corpora of the given size. The same seed always gives
+// the same bytes on every platform (no std:: distributions are used).
+//
+//   uniform  - uniformly random symbols from a 64-letter alphabet (6 bits/byte)
+//   zipf     - all 256 byte values with Zipf-distributed frequencies
+//   text     - words of Zipf-distributed popularity, spaces, punctuation and lines
+//   runs     - long runs of the same byte
+//   logs     - log lines from a few templates with varying numbers and times
+//   random   - uniformly random bytes (incompressible)
+std::vector<Corpus> syntheticCorpora(size_t size, uint64_t seed = 1);
+
+// Reads a file into memory. Name of the corpus is the file name.
+Corpus fileCorpus(const std::string& path);
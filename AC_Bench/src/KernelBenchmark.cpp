@@ -0,0 +1,114 @@
+#include "KernelBenchmark.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "SimdKernels.hpp"
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+	using InstructionSet = SimdKernels::InstructionSet;
+
+	constexpr double MIN_SECONDS = 0.05;	// of one measurement
+
+	struct Kernel
+	{
+		std::string name;
+		size_t size;					// elements processed by one call
+		std::function<void()> run;		// one call
+	};
+
+	// Best time of one call, in seconds.
+	double measure(const Kernel& kernel, unsigned repetitions)
+	{
+		double best = 1e300;
+		for (unsigned r = 0; r < std::max(repetitions, 1u); r++)
+		{
+			size_t calls = 0;
+			double seconds = 0;
+			auto start = Clock::now();
+			while (seconds < MIN_SECONDS) {
+				for (int i = 0; i < 256; i++)
+					kernel.run();
+				calls += 256;
+				seconds = std::chrono::duration<double>(Clock::now() - start).count();
+			}
+			best = std::min(best, seconds / calls);
+		}
+		return best;
+	}
+
+	std::vector<uint32_t> counters32(size_t size)
+	{
+		std::vector<uint32_t> values(size);
+		uint32_t state = 2020;
+		for (uint32_t& value : values) {
+			state = state * 1103515245 + 12345;
+			value = (state >> 16) % 64;		// mostly small counts, like in a rescaled model
+		}
+		return values;
+	}
+}
+
+void runKernelBenchmarks(unsigned repetitions, std::ostream& out)
+{
+	// Halving restores the counters first, so it doesn't run on ones only.
+	std::vector<uint32_t> original32 = counters32(1 << 16);
+	std::vector<uint16_t> original16(original32.begin(), original32.end());
+	std::vector<uint32_t> values32 = original32;
+	std::vector<uint16_t> values16 = original16;
+	std::vector<uint64_t> totals(256);
+
+	auto halve32 = [&](size_t n) {
+		std::copy(original32.begin(), original32.begin() + n, values32.begin());
+		SimdKernels::halve(values32.data(), n);
+	};
+	auto halve16 = [&](size_t n) {
+		std::copy(original16.begin(), original16.begin() + n, values16.begin());
+		SimdKernels::halve(values16.data(), n);
+	};
+
+	const std::vector<Kernel> kernels = {
+		{ "halve 32-bit", 257, [&] { halve32(257); } },					// AdaptiveModel, FenwickModel
+		{ "halve 16-bit", 257, [&] { halve16(257); } },					// Order1Model context
+		{ "prefix sum 32-bit", 257, [&] { SimdKernels::prefixSum(values32.data(), 257); } },	// AdaptiveModel
+		{ "prefix sum 32-bit", 1 << 16, [&] { SimdKernels::prefixSum(values32.data(), 1 << 16); } },
+		{ "prefix sum 16-bit", 257, [&] { SimdKernels::prefixSum(values16.data(), 257); } },
+		{ "prefix sum 16-bit", 1 << 16, [&] { SimdKernels::prefixSum(values16.data(), 1 << 16); } },
+		{ "merge histogram", 256, [&] { SimdKernels::addCounts(totals.data(), original32.data(), 256); } },	// StaticModel
+	};
+
+	std::vector<InstructionSet> sets = { InstructionSet::Scalar };
+	if (SimdKernels::supported() >= InstructionSet::SSE2)
+		sets.push_back(InstructionSet::SSE2);
+	if (SimdKernels::supported() >= InstructionSet::AVX2)
+		sets.push_back(InstructionSet::AVX2);
+
+	out << std::left << std::setw(20) << "kernel" << std::right << std::setw(8) << "size"
+		<< std::setw(8) << "set" << std::setw(14) << "M elem/s" << std::setw(10) << "speedup" << std::endl;
+
+	InstructionSet previous = SimdKernels::active();
+	out << std::fixed << std::setprecision(2);
+	for (const Kernel& kernel : kernels)
+	{
+		double scalarSeconds = 0;
+		for (InstructionSet set : sets)
+		{
+			SimdKernels::setActive(set);
+			double seconds = measure(kernel, repetitions);
+			if (set == InstructionSet::Scalar)
+				scalarSeconds = seconds;
+
+			out << std::left << std::setw(20) << kernel.name << std::right << std::setw(8) << kernel.size
+				<< std::setw(8) << SimdKernels::name(set) << std::setw(14) << kernel.size / seconds / 1e6
+				<< std::setw(9) << scalarSeconds / seconds << "x" << std::endl;
+		}
+	}
+	out << std::defaultfloat;
+	SimdKernels::setActive(previous);
+}
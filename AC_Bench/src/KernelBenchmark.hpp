@@ -0,0 +1,8 @@
+#pragma once
+
+#include <ostream>
+
+// Microbenchmarks of SimdKernels: every kernel on array sizes used by the
+// models, with every instruction set the processor supports. Prints a table
+// of millions of elements per second and the speedup over the scalar version.
+void runKernelBenchmarks(unsigned repetitions, std::ostream& out);
@@ -0,0 +1,107 @@
+#include <CLI/CLI11.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "Corpus.hpp"
+#include "KernelBenchmark.hpp"
+#include "Report.hpp"
+#include "SimdKernels.hpp"
+
+int main(int argc, char** argv)
+{
+	CLI::App app{ "End-to-end throughput and compression benchmark of the coders." };
+
+	size_t corpus_size{ 8 << 20 };
+	uint64_t seed{ 1 };
+	std::vector<std::string> files;
+	std::vector<std::string> coder_names;
+	std::vector<unsigned> thread_counts{ 1 };
+	unsigned repetitions{ 3 };
+	std::string json_path;
+	bool no_synthetic{ false };
+	bool kernels{ false };
+	SimdKernels::InstructionSet simd{ SimdKernels::supported() };
+
+	app.add_option("files", files, "Additional files to benchmark on.")
+		->check(CLI::ExistingFile);
+	app.add_option("-n,--size", corpus_size, "Size of every synthetic corpus, e.g. 512K, 16M.", true)
+		->transform(CLI::AsSizeValue(false));
+	app.add_option("--seed", seed, "Seed of synthetic corpora.", true);
+	app.add_flag("--no-synthetic", no_synthetic, "Benchmark only the given files.");
+	app.add_option("-c,--coder", coder_names, "Coders to run (all by default).");
+	app.add_option("-T,--threads", thread_counts, "Thread counts for multithreaded coders, e.g. -T 1 2 4.", true)
+		->check(CLI::Range(1u, 1024u));
+	app.add_option("-r,--repeat", repetitions, "Repetitions of every measurement (the best one counts).", true)
+		->check(CLI::Range(1u, 1000u));
+	app.add_option("-j,--json", json_path, "Write results to a JSON file.");
+	app.add_flag("--kernels", kernels, "Benchmark SIMD kernels of the models instead of the coders.");
+	std::map<std::string, SimdKernels::InstructionSet> instructionSets{
+		{ "scalar", SimdKernels::InstructionSet::Scalar },
+		{ "sse2", SimdKernels::InstructionSet::SSE2 },
+		{ "avx2", SimdKernels::InstructionSet::AVX2 }
+	};
+	app.add_option("--simd", simd, "Instruction set of the models (the best supported one by default), "
+		"e.g. scalar to compare branch misses.")
+		->transform(CLI::CheckedTransformer(instructionSets, CLI::ignore_case));
+
+	CLI11_PARSE(app, argc, argv);
+	SimdKernels::setActive(simd);
+
+	if (kernels) {
+		runKernelBenchmarks(repetitions, std::cout);
+		return 0;
+	}
+
+	std::vector<Corpus> corpora;
+	if (!no_synthetic)
+		corpora = syntheticCorpora(corpus_size, seed);
+	for (const std::string& path : files)
+		corpora.push_back(fileCorpus(path));
+
+	std::vector<BenchmarkedCoder> coders;
+	for (BenchmarkedCoder& coder : benchmarkedCoders())
+		if (coder_names.empty() || std::find(coder_names.begin(), coder_names.end(), coder.name) != coder_names.end())
+			coders.push_back(coder);
+
+	if (coders.empty()) {
+		std::cerr << "No coder matches. Available coders:";
+		for (const BenchmarkedCoder& coder : benchmarkedCoders())
+			std::cerr << " " << coder.name;
+		std::cerr << std::endl;
+		return -1;
+	}
+
+	std::vector<BenchmarkResult> results;
+	printTableHeader(std::cout);
+	try {
+		for (const BenchmarkedCoder& coder : coders)
+			for (unsigned threads : thread_counts)
+			{
+				if (!coder.multithreaded && threads != thread_counts.front())
+					continue;	// the result would not change
+				for (const Corpus& corpus : corpora)
+				{
+					results.push_back(runBenchmark(coder, corpus, coder.multithreaded ? threads : 1, repetitions));
+					printTableRow(results.back(), std::cout);
+				}
+			}
+	}
+	catch (const std::exception& e) {
+		std::cerr << "error: " << e.what() << std::endl;
+		return -1;
+	}
+
+	if (!json_path.empty()) {
+		std::ofstream json(json_path);
+		writeJson(results, json);
+		if (!json)
+			std::cerr << "Cannot write " << json_path << std::endl;
+	}
+
+	return 0;
+}
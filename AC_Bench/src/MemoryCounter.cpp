@@ -0,0 +1,78 @@
+#include "MemoryCounter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<size_t> currentBytes{ 0 };
+	std::atomic<size_t> peakBytes{ 0 };
+
+	// Every block starts with its size. The header keeps the alignment of malloc().
+	constexpr size_t HEADER_SIZE = alignof(std::max_align_t);
+
+	void* allocate(size_t size)
+	{
+		void* block = std::malloc(size + HEADER_SIZE);
+		if (block == nullptr)
+			throw std::bad_alloc();
+
+		*(size_t*)block = size;
+		size_t now = currentBytes += size;
+		size_t peak = peakBytes.load();
+		while (now > peak && !peakBytes.compare_exchange_weak(peak, now)) {}
+
+		return (char*)block + HEADER_SIZE;
+	}
+
+	void release(void* data) noexcept
+	{
+		if (data == nullptr)
+			return;
+
+		void* block = (char*)data - HEADER_SIZE;
+		currentBytes -= *(size_t*)block;
+		std::free(block);
+	}
+}
+
+size_t MemoryCounter::current()
+{
+	return currentBytes;
+}
+
+size_t MemoryCounter::peak()
+{
+	return peakBytes;
+}
+
+void MemoryCounter::resetPeak()
+{
+	peakBytes = currentBytes.load();
+}
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void operator delete(void* data) noexcept { release(data); }
+void operator delete[](void* data) noexcept { release(data); }
+void operator delete(void* data, size_t) noexcept { release(data); }
+void operator delete[](void* data, size_t) noexcept { release(data); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	try {
+		return allocate(size);
+	}
+	catch (const std::bad_alloc&) {
+		return nullptr;
+	}
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept
+{
+	return operator new(size, tag);
+}
+
+void operator delete(void* data, const std::nothrow_t&) noexcept { release(data); }
+void operator delete[](void* data, const std::nothrow_t&) noexcept { release(data); }
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+// Counts heap memory allocated with operator new in this program
+// (global operators are replaced in MemoryCounter.cpp). Memory mapped
+// files and malloc() calls made by the runtime are not counted.
+namespace MemoryCounter
+{
+	// Bytes allocated right now.
+	size_t current();
+
+	// The highest value of current() since the last call to resetPeak().
+	size_t peak();
+
+	// Starts measuring the peak from the current usage.
+	void resetPeak();
+}
@@ -0,0 +1,77 @@
+#include "Report.hpp"
+
+#include <iomanip>
+
+namespace
+{
+	std::string jsonString(const std::string& text)
+	{
+		std::string quoted = "\"";
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+				quoted += '\\';
+			if ((unsigned char)c < 0x20) {
+				const char* HEX = "0123456789abcdef";
+				quoted += "\\u00";
+				quoted += HEX[c >> 4];
+				quoted += HEX[c & 15];
+				continue;
+			}
+			quoted += c;
+		}
+		return quoted + "\"";
+	}
+}
+
+void printTableHeader(std::ostream& out)
+{
+	out << std::left << std::setw(18) << "coder" << std::setw(14) << "corpus" << std::right
+		<< std::setw(4) << "T" << std::setw(12) << "bytes" << std::setw(10) << "bits/B"
+		<< std::setw(11) << "enc MB/s" << std::setw(11) << "dec MB/s"
+		<< std::setw(11) << "enc KiB" << std::setw(11) << "dec KiB"
+		<< std::setw(12) << "enc miss/B" << std::setw(12) << "dec miss/B" << std::endl;
+}
+
+void printTableRow(const BenchmarkResult& r, std::ostream& out)
+{
+	out << std::fixed;
+	out << std::left << std::setw(18) << r.coder << std::setw(14) << r.corpus << std::right
+		<< std::setw(4) << r.threads << std::setw(12) << r.inputBytes
+		<< std::setprecision(3) << std::setw(10) << r.bitsPerByte()
+		<< std::setprecision(2) << std::setw(11) << r.encodeMBps() << std::setw(11) << r.decodeMBps()
+		<< std::setw(11) << r.encodePeakMemory / 1024 << std::setw(11) << r.decodePeakMemory / 1024;
+	if (r.branchMissesCounted)
+		out << std::setprecision(3) << std::setw(12) << r.encodeMissesPerByte() << std::setw(12) << r.decodeMissesPerByte();
+	else
+		out << std::setw(12) << "n/a" << std::setw(12) << "n/a";
+	out << std::endl << std::defaultfloat;
+}
+
+void writeJson(const std::vector<BenchmarkResult>& results, std::ostream& out)
+{
+	out << "{\n  \"benchmark\": \"ac_bench\",\n  \"version\": 1,\n  \"results\": [";
+	out << std::setprecision(6);
+
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchmarkResult& r = results[i];
+		out << (i ? "," : "") << "\n    {"
+			<< "\"coder\": " << jsonString(r.coder)
+			<< ", \"corpus\": " << jsonString(r.corpus)
+			<< ", \"threads\": " << r.threads
+			<< ", \"input_bytes\": " << r.inputBytes
+			<< ", \"encoded_bytes\": " << r.encodedBytes
+			<< ", \"bits_per_byte\": " << r.bitsPerByte()
+			<< ", \"encode_mb_per_s\": " << r.encodeMBps()
+			<< ", \"decode_mb_per_s\": " << r.decodeMBps()
+			<< ", \"encode_peak_memory\": " << r.encodePeakMemory
+			<< ", \"decode_peak_memory\": " << r.decodePeakMemory;
+		if (r.branchMissesCounted)
+			out << ", \"encode_branch_misses\": " << r.encodeBranchMisses
+				<< ", \"decode_branch_misses\": " << r.decodeBranchMisses;
+		out << "}";
+	}
+
+	out << "\n  ]\n}\n";
+}
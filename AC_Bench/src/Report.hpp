@@ -0,0 +1,14 @@
+#pragma once
+
+#include <ostream>
+#include <vector>
+
+#include "Benchmark.hpp"
+
+// Human-readable table, one line per result (printed as soon as it is ready).
+void printTableHeader(std::ostream& out);
+void printTableRow(const BenchmarkResult& result, std::ostream& out);
+
+// Machine-readable results for comparing releases:
+// { "benchmark": "ac_bench", "version": 1, "results": [ { "coder": ..., "corpus": ..., ... } ] }
+void writeJson(const std::vector<BenchmarkResult>& results, std::ostream& out);
@@ -2,8 +2,11 @@
 #include <iostream>
 #include <string>
 #include <filesystem>
+#include <map>
+#include <memory>
 
-#include "AdaptiveScalingCoder.hpp"
+#include "Codec.hpp"
+#include "IO/FileIO.hpp"
 
 bool endsWith(std::string const& fullString, std::string const& ending) {
     if (fullString.length() >= ending.length()) {
@@ -14,7 +17,9 @@ bool endsWith(std::string const& fullString, std::string const& ending) {
     }
 }
 
-void printStats(Statistics stats);
+void printStats(Statistics stats, std::ostream& out);
+
+const std::string STANDARD_STREAM = "-";  // stands for stdin (source) or stdout (dest)
 
 int main(int argc, char** argv)
 {
@@ -27,6 +32,20 @@ int main(int argc, char** argv)
     std::string path_out;
     bool file_override{ false };
     bool print_stats{ false };
+    bool legacy{ false };
+    ModelType model{ ModelType::Order0 };
+    int level{ 0 };
+    int ppm_order{ 4 };
+    size_t model_memory{ 64 << 20 };
+    int rans_states{ 4 };
+    int streams{ 1 };
+    bool runs{ false };
+    int window_bits{ 20 };
+    size_t bwt_block{ 1 << 20 };
+    unsigned threads{ 1 };
+    size_t block_size{ 0 };
+    std::vector<uint64_t> range;
+    bool use_mmap{ false };
 
     // encode | decode option group.
     auto action = app.add_option_group("Action type", "What action on a file should be performed.");
@@ -36,12 +55,12 @@ int main(int argc, char** argv)
     action->required(true);
 
     // input_file option.
-    app.add_option("source", path_in, "Path to a file you want to encode or decode.")
+    app.add_option("source", path_in, "Path to a file you want to encode or decode ('-' for stdin).")
         ->required(true)
-        ->check(CLI::ExistingFile);
+        ->check(CLI::ExistingFile | CLI::IsMember({ STANDARD_STREAM }));
 
     // output_file option.
-    app.add_option("dest", path_out, "Path to a result file.")
+    app.add_option("dest", path_out, "Path to a result file ('-' for stdout).")
         ->required(false)
         ->default_str("<source>.ac");
 
@@ -51,16 +70,78 @@ int main(int argc, char** argv)
     // print stats after encoding process
     app.add_flag("-s,--stats", print_stats, "Print stats during and after encoding process.");
 
+    // encode with floating-point arithmetic (format of the previous versions)
+    app.add_flag("--legacy", legacy, "Encode in the legacy floating-point format (readable by older versions).");
+
+    // model of the data
+    std::map<std::string, ModelType> models{ { "order0", ModelType::Order0 }, { "order1", ModelType::Order1 }, { "ppm", ModelType::PPM }, { "binary", ModelType::Binary }, { "cm", ModelType::ContextMixing }, { "static", ModelType::Static }, { "rans", ModelType::Rans }, { "lz", ModelType::Lz }, { "bwt", ModelType::Bwt } };
+    auto model_option = app.add_option("-m,--model", model, "Model used for encoding: order0 (default), order1, ppm, cm (better for text), binary, static or rans (faster), lz (repetitive data), bwt (large text).")
+        ->transform(CLI::CheckedTransformer(models, CLI::ignore_case))
+        ->excludes("--legacy");
+    auto order_option = app.add_option("--order", ppm_order, "Maximum context length of the ppm model (default 4).")
+        ->check(CLI::Range(1, 16));
+    auto memory_option = app.add_option("--memory", model_memory, "Memory limit of the ppm or cm model, e.g. 16M, 1G (default 64M).")
+        ->transform(CLI::AsSizeValue(false))
+        ->check(CLI::Range((size_t)1 << 20, (size_t)1 << 31));
+    auto streams_option = app.add_option("--streams", streams, "Code order0 in 2, 4 or 8 interleaved streams (faster decoding).")
+        ->check(CLI::IsMember({ 1, 2, 4, 8 }))
+        ->excludes("--legacy");
+    auto runs_option = app.add_flag("--runs", runs, "Code runs of the same byte in order0 as their length (fast on sparse data).")
+        ->excludes(streams_option)
+        ->excludes("--legacy");
+    auto states_option = app.add_option("--states", rans_states, "Number of interleaved states of the rans model (default 4).")
+        ->check(CLI::Range(2, 8));
+    auto window_option = app.add_option("--window", window_bits, "Window of the lz model as log2 of its size, 10 to 24 (default 20, 1 MiB).")
+        ->check(CLI::Range(10, 24));
+    auto bwt_block_option = app.add_option("--bwt-block", bwt_block, "Block of the bwt model, 1K to 16M (default 1M).")
+        ->transform(CLI::AsSizeValue(false))
+        ->check(CLI::Range((size_t)1 << 10, (size_t)1 << 24));
+
+    // compression level: presets of the options above
+    app.add_option("-l,--level", level, "Compression level: 1 (binary, fastest) to 6 (cm, best).")
+        ->check(CLI::Range(1, 6))
+        ->excludes(model_option)
+        ->excludes(order_option)
+        ->excludes(memory_option)
+        ->excludes(states_option)
+        ->excludes(streams_option)
+        ->excludes(runs_option)
+        ->excludes(window_option)
+        ->excludes(bwt_block_option)
+        ->excludes("--legacy");
+
+    // block mode: independently coded blocks on many threads
+    app.add_option("-T,--threads", threads, "Number of threads for block mode (enables blocks if > 1; with -m static and no --block-size, threads counting bytes).")
+        ->check(CLI::Range(1u, 1024u));
+    app.add_option("--block-size", block_size, "Block size for block mode, e.g. 256K, 4M (default 1M if -T is set).")
+        ->transform(CLI::AsSizeValue(false))
+        ->check(CLI::Range((size_t)1, (size_t)0xFFFFFFFF));
+
+    // memory-mapped files instead of buffered reads and writes
+    app.add_flag("--mmap", use_mmap, "Map source and dest files into memory.");
+
+    // partial decoding
+    app.add_option("--range", range, "Decode only LENGTH bytes starting at OFFSET (fast for block mode files).")
+        ->expected(2)
+        ->allow_extra_args(false)
+        ->type_name("OFFSET LENGTH")
+        ->excludes(action->get_option("--encode"));
+
     app.get_formatter()->label("Positionals", "Files");
     app.get_formatter()->label("TEXT", "PATH");
     app.get_formatter()->label("TEXT:FILE", "PATH");
+    app.get_formatter()->label("TEXT:(FILE) OR ({-})", "PATH");
 
 
     // Parse input parameters.
     CLI11_PARSE(app, argc, argv);
 
     // Generate output path if not specified.
-    if (path_out.empty())
+    if (path_out.empty() && path_in == STANDARD_STREAM)
+    {
+        path_out = STANDARD_STREAM;                 // pipe in, pipe out
+    }
+    else if (path_out.empty())
     {
         if (encode)                                 // add *.ac extension
             path_out = path_in + ".ac";
@@ -68,19 +149,33 @@ int main(int argc, char** argv)
             path_out = path_in.substr(0, path_in.find_last_of("."));
     }
 
+    // Only the order-0 model is split into interleaved streams or has the run-length path.
+    if (streams > 1 && model != ModelType::Order0)
+    {
+        std::cerr << "--streams can be used only with the order0 model!" << std::endl;
+        return -1;
+    }
+    if (runs && model != ModelType::Order0)
+    {
+        std::cerr << "--runs can be used only with the order0 model!" << std::endl;
+        return -1;
+    }
+
     // 'source' and 'dest' cannot be the same (letter case should be ignored)
-    if (path_in == path_out)
+    if (path_in == path_out && path_in != STANDARD_STREAM)
     {
         std::cerr << "source and dest paths cannot be the same!" << std::endl;
         return -1;
     }
 
+    bool to_stdout = path_out == STANDARD_STREAM;
+
     // Remove existing file if -o,--override flag is set.
-    if (file_override) 
+    if (file_override && !to_stdout) 
         std::filesystem::remove(path_out);
 
     // File 'path_out' should not exist at this point.
-    if (std::filesystem::exists(path_out))
+    if (!to_stdout && std::filesystem::exists(path_out))
     {
         std::cerr << "dest: Path already exists: " << path_out << std::endl;
         std::cerr << "Specify different name or consider using -o,--override option." << std::endl;
@@ -88,27 +183,82 @@ int main(int argc, char** argv)
         return -1;
     }
 
-    // The meat.
-    AdaptiveScalingCoder coder(print_stats);
+    // Levels 3-5 grow the ppm context and its memory, 6 mixes many contexts.
+    switch (level)
+    {
+    case 1: model = ModelType::Binary; break;
+    case 2: model = ModelType::Order1; break;
+    case 3: model = ModelType::PPM; ppm_order = 3; model_memory = 16 << 20; break;
+    case 4: model = ModelType::PPM; ppm_order = 4; model_memory = 64 << 20; break;
+    case 5: model = ModelType::PPM; ppm_order = 6; model_memory = 256 << 20; break;
+    case 6: model = ModelType::ContextMixing; model_memory = 256 << 20; break;
+    }
+
+    // The meat. Progress bar would mix with the data written to stdout.
+    CodecOptions options;
+    options.model = model;
+    options.ppmOrder = ppm_order;
+    options.ransStates = rans_states;
+    options.streams = streams;
+    options.runs = runs;
+    options.lzWindowBits = window_bits;
+    options.bwtBlockSize = bwt_block;
+    options.modelMemory = model_memory / (1 << 20) * (1 << 20);   // whole MiB
+    options.arithmetic = legacy ? IntervalArithmetic::FloatingPoint : IntervalArithmetic::Integer;
+    options.threads = threads;
+    options.blockSize = block_size;
+    options.printProgress = print_stats && !to_stdout;
+
+    // Standard streams or files.
+    std::unique_ptr<ByteSource> source;
+    std::unique_ptr<ByteSink> sink;
+    try
+    {
+        FileBackend backend = use_mmap ? FileBackend::Mapped : FileBackend::Buffered;
+        if (path_in == STANDARD_STREAM)
+            source = std::make_unique<StandardInputSource>();
+        else
+            source = openFileSource(path_in, backend);
+        if (to_stdout)
+            sink = std::make_unique<StandardOutputSink>();
+        else
+            sink = createFileSink(path_out, backend, source->size() > 0 ? source->size() : 0);
 
-    if (encode) {
-        Statistics stats = coder.encode(path_in, path_out);
-        if (print_stats)
-            printStats(stats);
+        if (encode) {
+            Statistics stats = makeEncoder(options)->encode(*source, *sink);
+            if (print_stats)
+                printStats(stats, to_stdout ? std::cerr : std::cout);
+        }
+        else if (decode) {
+            ByteReader reader(*source);
+            if (range.empty())
+                makeDecoder(reader, options)->decode(reader, *sink);
+            else
+                decodeRange(reader, *sink, range[0], range[1], options);
+        }
     }
-    else if (decode) {
-        coder.decode(path_in, path_out);
+    catch (const std::exception& e)
+    {
+        // Corrupted or truncated input, another format, a failed write...
+        // Close the files first and don't leave a partial result behind.
+        std::cerr << "error: " << e.what() << std::endl;
+        sink.reset();
+        source.reset();
+        std::error_code ignored;
+        if (!to_stdout)
+            std::filesystem::remove(path_out, ignored);
+        return -1;
     }
 
     return 0;
 }
 
-void printStats(Statistics stats)
+void printStats(Statistics stats, std::ostream& out)
 {
-    std::cout.precision(2);
-    std::cout << std::fixed;
-    std::cout << "input entropy:       " << stats.entropy() << std::endl;
-    std::cout << "average code length: " << stats.averageCodingLength() << "   [bits/byte]" << std::endl;
-    std::cout << "compression rate:    " << stats.compressionRatio()*100 << "%" << std::endl;
-    std::cout << std::defaultfloat;
+    out.precision(2);
+    out << std::fixed;
+    out << "input entropy:       " << stats.entropy() << std::endl;
+    out << "average code length: " << stats.averageCodingLength() << "   [bits/byte]" << std::endl;
+    out << "compression rate:    " << stats.compressionRatio()*100 << "%" << std::endl;
+    out << std::defaultfloat;
 }
@@ -4,6 +4,11 @@
 
 #pragma once
 
+#include "SimdKernels.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
 #include <stdexcept>
 #include <vector>
 
@@ -12,10 +17,12 @@ class AdaptiveModel
 public:
 	AdaptiveModel(size_t numberOfSymbols, size_t maxTotalFrequency)
 		: frequencies( numberOfSymbols ), 
-		freqBegin( numberOfSymbols ),
 		freqEnd( numberOfSymbols ),
 		MAX_TOTAL_FREQUENCY(maxTotalFrequency)
 	{
+		if (maxTotalFrequency > std::numeric_limits<uint32_t>::max())
+			throw std::invalid_argument("max frequency does not fit in 32-bit counters");
+
 		reset();
 	}
 
@@ -35,22 +42,21 @@ public:
 	void update(size_t symbol)
 	{
 		if (totalFrequencyCounter >= MAX_TOTAL_FREQUENCY) {		// Check if frequency counter reaches max
-			totalFrequencyCounter = 0;							// If so, halve all counts (keeping them
-			for (auto& freq : frequencies) {					// positive).
-				freq = freq / 2 != 0 ? freq / 2 : 1;			
-				totalFrequencyCounter += freq;
-			}
+			// If so, halve all counts (keeping them positive).
+			totalFrequencyCounter = (size_t)SimdKernels::halve(frequencies.data(), frequencies.size());
+			updateFrequencies();
 		}
 
 		frequencies.at(symbol)++;
 		totalFrequencyCounter++;
 
-		updateFrequencies();
+		for (size_t i = symbol; i < freqEnd.size(); i++)	// ends of this and the following symbols
+			freqEnd[i]++;
 	}
 
 	size_t frequencyBegin(size_t symbol)
 	{
-		return freqBegin.at(symbol);
+		return freqEnd.at(symbol) - frequencies[symbol];
 	}
 
 	size_t frequencyEnd(size_t symbol)
@@ -58,6 +64,19 @@ public:
 		return freqEnd.at(symbol);
 	}
 
+	size_t frequency(size_t symbol)
+	{
+		return frequencies.at(symbol);
+	}
+
+	// Returns the symbol for which frequencyBegin(symbol) <= count < frequencyEnd(symbol).
+	// It is the number of symbols that end at or before 'count'; with SIMD they
+	// are all compared at once instead of a binary search with unpredictable branches.
+	size_t findSymbol(size_t count)
+	{
+		return SimdKernels::upperBound(freqEnd.data(), freqEnd.size(), (uint32_t)count);
+	}
+
 	size_t totalFrequency()
 	{
 		return totalFrequencyCounter;
@@ -69,21 +88,15 @@ public:
 	}
 
 private:
-	std::vector<size_t> frequencies;
-	std::vector<size_t> freqBegin;
-	std::vector<size_t> freqEnd;
+	std::vector<uint32_t> frequencies;
+	std::vector<uint32_t> freqEnd;	// cumulative frequencies; begin = end - frequency
 
 	size_t totalFrequencyCounter;	// total number of symbols appearance.
 	const size_t MAX_TOTAL_FREQUENCY;
 
 	void updateFrequencies()
 	{
-		size_t prevFrequency = 0;
-		for (size_t symbol = 0; symbol < frequencies.size(); symbol++)
-		{
-			freqBegin[symbol] = prevFrequency;
-			prevFrequency += frequencies[symbol];
-			freqEnd[symbol] = prevFrequency;		// end = begin + frequency
-		}
+		std::copy(frequencies.begin(), frequencies.end(), freqEnd.begin());
+		SimdKernels::prefixSum(freqEnd.data(), freqEnd.size());
 	}
 };
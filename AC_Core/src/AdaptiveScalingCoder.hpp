@@ -1,22 +1,12 @@
 #pragma once
-#include "ArithmeticCoder.hpp"
-#include "Statistics.hpp"
+#include "BasicArithmeticCoder.hpp"
+#include "FenwickModel.hpp"
+#include "GroupedModel.hpp"
 
-#include <string>
+// The default coder: adaptive order-0 model of bytes, 32-bit interval.
+// The decoder finds symbols with vector comparisons (GroupedModel), the
+// encoder only updates the model, which is cheaper in a Fenwick tree.
+using AdaptiveScalingCoder = BasicArithmeticCoder<FenwickModel, 32, 256, StreamFormat::AdaptiveScaling, GroupedModel>;
 
-class AdaptiveScalingCoder : public ArithmeticCoder
-{
-public:
-	AdaptiveScalingCoder(bool printProgress = false)
-		: printProgress(printProgress) {}
-	Statistics encode(std::string path_in, std::string path_out) override;
-	void decode(std::string path_in, std::string path_out) override;
-
-private:
-	bool printProgress;
-	int currentProgress = 0;
-	const size_t progressbarWidth = 70;
-
-	inline void updateProgress(double progress);
-	inline void clearProgress();
-};
+// Compiled once in AdaptiveScalingCoder.cpp.
+extern template class BasicArithmeticCoder<FenwickModel, 32, 256, StreamFormat::AdaptiveScaling, GroupedModel>;
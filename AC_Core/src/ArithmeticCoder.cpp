@@ -0,0 +1,30 @@
+#include "ArithmeticCoder.hpp"
+#include "IO/FileIO.hpp"
+
+Statistics ArithmeticCoder::encode(std::string path_in, std::string path_out)
+{
+	FileSource in(path_in);
+	FileSink out(path_out);
+	return encode(in, out);
+}
+
+void ArithmeticCoder::decode(std::string path_in, std::string path_out)
+{
+	FileSource in(path_in);
+	FileSink out(path_out);
+	decode(in, out);
+}
+
+Statistics ArithmeticCoder::encode(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+{
+	MemorySource source(data, size);
+	MemorySink sink(out);
+	return encode(source, sink);
+}
+
+void ArithmeticCoder::decode(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+{
+	MemorySource source(data, size);
+	MemorySink sink(out);
+	decode(source, sink);
+}
@@ -1,11 +1,56 @@
 #pragma once
+#include <cstdint>
 #include <string>
+#include <vector>
 
+#include "ProgressBar.hpp"
 #include "Statistics.hpp"
+#include "IO/ByteSource.hpp"
+#include "IO/ByteSink.hpp"
 
 class ArithmeticCoder
 {
 public:
-	virtual Statistics encode(std::string path_in, std::string path_out) = 0;
-	virtual void decode(std::string path_in, std::string path_out) = 0;
+	virtual Statistics encode(ByteSource& in, ByteSink& out) = 0;
+	virtual void decode(ByteSource& in, ByteSink& out) = 0;
+
+	// File to file. Output file must not exist.
+	Statistics encode(std::string path_in, std::string path_out);
+	void decode(std::string path_in, std::string path_out);
+
+	// Memory to memory, no filesystem calls. Output is appended to 'out'.
+	Statistics encode(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+	void decode(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+	virtual ~ArithmeticCoder() = default;
+
+protected:
+	// Feeds a push-based encoder (see BasicArithmeticCoder::Encoder) with
+	// the whole source and finishes it.
+	template <typename Encoder>
+	static Statistics encodeWith(ByteSource& in, Encoder& encoder, bool printProgress)
+	{
+		ProgressSource source(in, printProgress);
+		const uint8_t* chunk = nullptr;
+		while (size_t chunkSize = source.next(chunk))
+			encoder.feed(chunk, chunkSize);
+		return encoder.finish();
+	}
+
+	// Feeds a push-based decoder until it has decoded the end of data or the
+	// source ends, then finishes it.
+	template <typename Decoder>
+	static void decodeWith(ByteSource& in, Decoder& decoder, bool printProgress)
+	{
+		ProgressSource source(in, printProgress);
+		const uint8_t* chunk = nullptr;
+		while (!decoder.done())
+		{
+			size_t chunkSize = source.next(chunk);
+			if (chunkSize == 0)
+				break;
+			decoder.feed(chunk, chunkSize);
+		}
+		decoder.finish();
+	}
 };
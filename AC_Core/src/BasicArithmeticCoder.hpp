@@ -0,0 +1,258 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+#include "ArithmeticCoder.hpp"
+#include "IntervalCoder.hpp"
+#include "Statistics.hpp"
+#include "StreamHeader.hpp"
+#include "BitUtils/BitWriter.hpp"
+#include "BitUtils/BitReader.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+
+// Adaptive arithmetic coder with E1/E2/E3 scaling, specialized at compile time
+// for a model, precision of the interval and size of the alphabet, so the
+// whole hot loop (model included) is inlined into feed().
+//
+// Model is any class with this interface (see FenwickModel, AdaptiveModel):
+//
+//   Model(size_t numberOfSymbols, size_t maxTotalFrequency);
+//   size_t frequencyBegin(size_t symbol);    // sum of frequencies of symbols [0, symbol)
+//   size_t frequency(size_t symbol);         // > 0 for every symbol
+//   size_t totalFrequency();                 // <= maxTotalFrequency
+//   size_t findSymbol(size_t count);         // symbol with begin <= count < begin + frequency
+//   void update(size_t symbol);              // called after every coded symbol
+//
+// The model has AlphabetSize + 1 symbols; the last one marks the end of data.
+// Input bytes must be smaller than AlphabetSize.
+//
+// DecoderModel replaces Model in the decoder, e.g. one that is faster at
+// findSymbol(), which the encoder never calls. It must keep exactly the same
+// frequencies as Model.
+//
+// Precision is the number of bits of the interval [a, b) (see IntervalCoder.hpp). Streams do not
+// record it (nor the model), they are identified only by Format in the
+// header, so every instantiation written to files needs its own StreamFormat.
+template <typename Model, unsigned Precision = 32, size_t AlphabetSize = 256, StreamFormat Format = StreamFormat::AdaptiveScaling,
+	typename DecoderModel = Model>
+class BasicArithmeticCoder : public ArithmeticCoder
+{
+	static_assert(AlphabetSize >= 1 && AlphabetSize <= 256, "symbols are bytes");
+
+public:
+	static constexpr uint64_t PRECISION = Precision;
+
+	/* Parameters for data model */
+	static constexpr size_t MODEL_SIZE = AlphabetSize + 1;			// + 1 for EOF symbol
+	static constexpr size_t MODEL_EOF_SYMBOL = AlphabetSize;		// last symbol in model is EOF symbol
+	static constexpr size_t MODEL_MAX_FREQUENCY = IntervalBounds<Precision>::MAX_TOTAL_FREQUENCY;
+	static_assert(MODEL_SIZE < MODEL_MAX_FREQUENCY, "precision is too low for the alphabet");
+
+	class Encoder;
+	class Decoder;
+
+	BasicArithmeticCoder(bool printProgress = false, IntervalArithmetic arithmetic = IntervalArithmetic::Integer)
+		: printProgress(printProgress), arithmetic(arithmetic) {}
+	using ArithmeticCoder::encode;
+	using ArithmeticCoder::decode;
+
+	Statistics encode(ByteSource& in, ByteSink& out) override
+	{
+		Encoder encoder(out, arithmetic);
+		return encodeWith(in, encoder, printProgress);
+	}
+
+	void decode(ByteSource& in, ByteSink& out) override
+	{
+		Decoder decoder(out);
+		decodeWith(in, decoder, printProgress);
+	}
+
+private:
+	bool printProgress;
+	IntervalArithmetic arithmetic;	// used for encoding; decoding reads it from the header
+};
+
+// Push-based encoder. Data can be fed in chunks of any size and the
+// interval state is kept between calls, so memory usage is constant.
+// Encoded bytes are passed to the sink as soon as a block is ready.
+template <typename Model, unsigned Precision, size_t AlphabetSize, StreamFormat Format, typename DecoderModel>
+class BasicArithmeticCoder<Model, Precision, AlphabetSize, Format, DecoderModel>::Encoder
+{
+public:
+	Encoder(ByteSink& sink, IntervalArithmetic arithmetic = IntervalArithmetic::Integer)
+		: out(sink), interval(out, arithmetic), model(MODEL_SIZE, MODEL_MAX_FREQUENCY)
+	{
+		if (arithmetic != IntervalArithmetic::FloatingPoint) {	// legacy streams have no header
+			StreamHeader header;
+			header.format = Format;
+			header.arithmetic = arithmetic;
+			uint8_t bytes[StreamHeader::SIZE];
+			header.serialize(bytes);
+			for (uint8_t byte : bytes)
+				out.writeByte(byte);
+		}
+	}
+
+	void feed(const uint8_t* data, size_t size)
+	{
+		if (finished)
+			throw std::logic_error("cannot feed finished encoder");
+
+		for (size_t i = 0; i < size; i++)
+		{
+			if constexpr (AlphabetSize < 256) {
+				if (data[i] >= AlphabetSize)
+					throw std::invalid_argument("symbol does not belong to the alphabet");
+			}
+
+			out.beginByte(data[i]);		// for statistics purposes
+			encodeSymbol(data[i]);
+		}
+	}
+
+	Statistics finish()		// encodes EOF symbol and flushes the sink
+	{
+		if (!finished)
+		{
+			encodeSymbol(MODEL_EOF_SYMBOL);
+			interval.finish();
+			out.flush();
+			finished = true;
+		}
+		return Statistics(out.getStats());
+	}
+
+private:
+	BitWriter out;
+	IntervalEncoder<Precision> interval;
+	Model model;
+	bool finished = false;
+
+	void encodeSymbol(size_t symbol)
+	{
+		size_t freqBegin = model.frequencyBegin(symbol);
+		interval.encode(freqBegin, freqBegin + model.frequency(symbol), model.totalFrequency());
+		model.update(symbol);
+	}
+};
+
+// Push-based decoder. It decodes as many symbols as the fed data allows
+// and keeps the rest of the state (including 'z') for the next call.
+// Decoded bytes are passed to the sink before feed() returns.
+template <typename Model, unsigned Precision, size_t AlphabetSize, StreamFormat Format, typename DecoderModel>
+class BasicArithmeticCoder<Model, Precision, AlphabetSize, Format, DecoderModel>::Decoder
+{
+public:
+	Decoder(ByteSink& sink)
+		: in(source), interval(in), out(sink), model(MODEL_SIZE, MODEL_MAX_FREQUENCY)
+	{
+	}
+
+	void feed(const uint8_t* data, size_t size)
+	{
+		if (endOfStream || bits.isFinished())
+			return;		// everything after EOF symbol is ignored
+
+		source.push(data, size);
+		bits.feed(size);
+		decodeAvailable();
+		out.flush();
+	}
+
+	void finish()	// no more data: decodes the rest assuming '0' bits after the end
+	{
+		bits.finish();
+		decodeAvailable();
+		out.flush();
+	}
+
+	bool done() const { return endOfStream; }	// EOF symbol was decoded
+
+private:
+	QueueSource source;
+	BitReader in;
+	IntervalDecoder<Precision> interval;
+	ByteWriter out;
+	DecoderModel model;
+	IntervalArithmetic arithmetic = IntervalArithmetic::Integer;
+
+	BitBudget<Precision> bits;
+	uint64_t headerBits = 0;
+	bool started = false;		// header was read and 'z' initialized
+	bool endOfStream = false;
+
+	uint64_t bitsTaken() const { return headerBits + interval.bitsTaken(); }
+
+	void decodeAvailable()
+	{
+		if (!started)
+		{
+			// header and 'z' need 32 + PRECISION bits
+			if (!bits.canStart(8 * StreamHeader::SIZE))
+				return;
+
+			StreamHeader header;
+			uint8_t bytes[StreamHeader::SIZE];
+			in.peekBytes(bytes, StreamHeader::SIZE);
+
+			if (header.deserialize(bytes)) {
+				if (header.format != Format)
+					throw std::runtime_error("data was encoded in a different format");
+				headerBits = 8 * StreamHeader::SIZE;
+				in.consumeBits((int)headerBits);
+			}
+			else	// legacy stream: no header, these bits are already the code
+				header.arithmetic = IntervalArithmetic::FloatingPoint;
+			arithmetic = header.arithmetic;
+
+			interval.start(arithmetic);
+			started = true;
+		}
+
+		// A symbol takes at most PRECISION bits.
+		while (!endOfStream && bits.canDecode(bitsTaken()))
+		{
+			decodeSymbol();
+			bits.checkTaken(bitsTaken());
+		}
+	}
+
+	void decodeSymbol()
+	{
+		// decode a symbol: scale 'z' back to a frequency count once
+		// and find the symbol whose [begin, end) range contains it.
+		size_t total = model.totalFrequency();
+		size_t symbol = model.findSymbol((size_t)interval.count(total));
+
+		if (arithmetic == IntervalArithmetic::FloatingPoint)
+		{
+			// rounding can move a bound by one, so a neighbour may be the symbol
+			while (true)
+			{
+				size_t freqBegin = model.frequencyBegin(symbol);
+				int where = interval.locate(freqBegin, freqBegin + model.frequency(symbol), total);
+				if (where < 0 && symbol > 0)
+					symbol--;
+				else if (where > 0 && symbol + 1 < MODEL_SIZE)
+					symbol++;
+				else
+					break;
+			}
+		}
+
+		if (symbol == MODEL_EOF_SYMBOL) { // End Of File symbol
+			endOfStream = true;
+			return;
+		}
+
+		out.put((uint8_t)symbol);
+
+		size_t freqBegin = model.frequencyBegin(symbol);
+		interval.decode(freqBegin, freqBegin + model.frequency(symbol), total);
+		model.update(symbol);
+	}
+};
@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#include "BinaryCoder.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+Statistics BinaryCoder::encode(ByteSource& in, ByteSink& out)
+{
+	Encoder encoder(out);
+	return encodeWith(in, encoder, printProgress);
+}
+
+void BinaryCoder::decode(ByteSource& in, ByteSink& out)
+{
+	Decoder decoder(out);
+	decodeWith(in, decoder, printProgress);
+}
+
+BinaryCoder::Encoder::Encoder(ByteSink& sink)
+	: sink(sink), out(sink), range(out), stats(256)
+{
+	std::fill(tree, tree + TREE_SIZE, BinaryProbability::INITIAL);
+
+	StreamHeader header;
+	header.format = StreamFormat::Binary;
+	uint8_t bytes[StreamHeader::SIZE];
+	header.serialize(bytes);
+	for (uint8_t byte : bytes)
+		out.put(byte);
+}
+
+Statistics BinaryCoder::Encoder::finish()
+{
+	if (!finished)
+	{
+		range.encodeRare(1, END_SHIFT);
+		range.finish();
+		out.flush();
+		sink.flush();
+		finished = true;
+	}
+	return Statistics(stats);
+}
+
+BinaryCoder::Decoder::Decoder(ByteSink& sink)
+	: out(sink)
+{
+	std::fill(tree, tree + TREE_SIZE, BinaryProbability::INITIAL);
+}
+
+void BinaryCoder::Decoder::feed(const uint8_t* data, size_t size)
+{
+	if (endOfStream || input.isFinished())
+		return;		// everything after the end is ignored
+
+	input.feed(data, size);
+	decodeAvailable();
+	out.flush();
+}
+
+void BinaryCoder::Decoder::finish()
+{
+	if (endOfStream || input.isFinished())
+		return;
+
+	input.finish(StreamHeader::SIZE + MAX_BYTES_PER_SYMBOL);
+	decodeAvailable();
+	out.flush();
+
+	if (!endOfStream)
+		throw std::runtime_error("encoded data is truncated or corrupted");
+}
+
+void BinaryCoder::Decoder::decodeAvailable()
+{
+	const uint8_t* in = input.begin();
+	const uint8_t* end = input.end();
+
+	if (!started)
+	{
+		if (end - in < StreamHeader::SIZE + RangeDecoder::START_BYTES)
+			return;
+
+		StreamHeader header;
+		if (!header.deserialize(in) || header.format != StreamFormat::Binary)
+			throw std::runtime_error("data was encoded in a different format");
+		in += StreamHeader::SIZE;
+		range.start(in);
+		started = true;
+	}
+
+	while (!endOfStream && end - in >= (ptrdiff_t)MAX_BYTES_PER_SYMBOL)
+	{
+		if (range.decodeRare(END_SHIFT, in)) {
+			endOfStream = true;
+			break;
+		}
+
+		size_t node = 1;
+		while (node < TREE_SIZE)
+			node = 2 * node + range.decodeBit(tree[node], in);
+		out.put((uint8_t)(node - TREE_SIZE));
+	}
+
+	input.consume(in);
+}
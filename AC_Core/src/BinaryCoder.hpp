@@ -0,0 +1,103 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+#include "ArithmeticCoder.hpp"
+#include "RangeCoder.hpp"
+#include "Statistics.hpp"
+#include "StreamHeader.hpp"
+
+#include <vector>
+
+// Fast order-0 coder: a byte is coded as 8 binary decisions, walking down
+// a binary tree from the most significant bit. Every node of the tree has
+// its own adaptive probability (see RangeCoder.hpp), so there is no
+// cumulative frequency search and no division at all.
+//
+// Before every byte a rare bit tells whether the data ends there.
+class BinaryCoder : public ArithmeticCoder
+{
+public:
+	static constexpr int END_SHIFT = 16;	// the end costs 16 bits, every byte ~0.00002 bits
+	static constexpr size_t TREE_SIZE = 256;	// nodes 1..255
+	static constexpr size_t MAX_BYTES_PER_SYMBOL = 9 * RangeDecoder::MAX_BYTES_PER_BIT;
+
+	class Encoder;
+	class Decoder;
+
+	BinaryCoder(bool printProgress = false)
+		: printProgress(printProgress) {}
+	using ArithmeticCoder::encode;
+	using ArithmeticCoder::decode;
+
+	Statistics encode(ByteSource& in, ByteSink& out) override;
+	void decode(ByteSource& in, ByteSink& out) override;
+
+private:
+	bool printProgress;
+};
+
+// Push-based encoder. The range coder keeps back only the byte that a carry
+// can still change, so everything else reaches the sink as it is coded.
+class BinaryCoder::Encoder
+{
+public:
+	Encoder(ByteSink& sink);
+
+	void feed(const uint8_t* data, size_t size)
+	{
+		if (finished)
+			throw std::logic_error("cannot feed finished encoder");
+
+		for (size_t i = 0; i < size; i++)
+		{
+			range.encodeRare(0, END_SHIFT);
+
+			size_t node = 1;
+			for (int bit = 7; bit >= 0; bit--) {
+				int value = (data[i] >> bit) & 1;
+				range.encodeBit(tree[node], value);
+				node = 2 * node + value;
+			}
+
+			// for statistics purposes
+			stats[data[i]].readCounter += 8;
+			stats[data[i]].writeCounter += 8 * (range.bytesWritten() - statsWritten);
+			statsWritten = range.bytesWritten();
+		}
+	}
+
+	Statistics finish();	// encodes the end and flushes the sink
+
+private:
+	ByteSink& sink;
+	ByteWriter out;
+	RangeEncoder range;
+	uint16_t tree[TREE_SIZE];
+	std::vector<BitStat> stats;
+	uint64_t statsWritten = 0;
+	bool finished = false;
+};
+
+// Push-based decoder. A byte is decoded only when MAX_BYTES_PER_SYMBOL
+// bytes are fed, and the rest is kept for the next call.
+class BinaryCoder::Decoder
+{
+public:
+	Decoder(ByteSink& sink);
+
+	void feed(const uint8_t* data, size_t size);
+	void finish();		// no more data: decodes the rest, throws if the end is missing
+	bool done() const { return endOfStream; }
+
+private:
+	ByteWriter out;
+	RangeDecoder range;
+	uint16_t tree[TREE_SIZE];
+	RangeDecoderInput input;
+	bool started = false;
+	bool endOfStream = false;
+
+	void decodeAvailable();
+};
@@ -1,55 +1,71 @@
 #include "BitReader.hpp"
+#include "../IO/FileIO.hpp"
 
-#include <filesystem>
+#include <array>
+
+// Bytes keep their first bit in the least significant position,
+// while the window keeps it in the most significant one.
+static constexpr std::array<byte_t, 256> REVERSED_BITS = [] {
+	std::array<byte_t, 256> table{};
+	for (int byte = 0; byte < 256; byte++)
+		for (int i = 0; i < 8; i++)
+			if (byte & (1 << i))
+				table[byte] |= 0x80 >> i;
+	return table;
+}();
 
 BitReader::BitReader(std::string path)
-	: m_bitBuffer(BIT_BUFFER_CAPACITY)
+	: m_ownedSource(std::make_unique<FileSource>(path)), m_source(*m_ownedSource)
 {
-	if (!std::filesystem::exists(path))
-		throw std::runtime_error("file does not exists");
-
-	m_fileStream.open(path, std::istream::binary);
-	if (!m_fileStream.is_open())
-		throw std::runtime_error("Cannot open file");
+	refill();
+}
 
-	m_endOfFile = false;
+BitReader::BitReader(ByteSource& source)
+	: m_source(source)
+{
+	refill();
+}
 
-	fetchData();
+BitReader& BitReader::operator>> (bool& bit)
+{
+	bit = read();
+	return *this;
 }
 
-bool BitReader::read() 
+byte_t BitReader::readByte()
 {
-	if (m_bitBuffer.size() == 0 && !m_endOfFile)	// buffer is empty
+	byte_t byte{ 0 };
+	for (int i = 0; i < 8; i++)
 	{
-		fetchData();	// fetch next block of bytes to the buffer
+		if (read())
+			byte |= (1 << i);
 	}
-
-	if (eof()) // when whole file is read, then return 0 bits
-		return 0;
-	else
-		return m_bitBuffer.read();
+	return byte;
 }
 
-BitReader& BitReader::operator>> (bool& bit)
+void BitReader::peekBytes(byte_t* bytes, int n)
 {
-	bit = read();
-	return *this;
+	uint32_t bits = peekBits(8 * n);
+	for (int i = 0; i < n; i++)
+		bytes[i] = REVERSED_BITS[(bits >> (8 * (n - 1 - i))) & 0xFF];
 }
 
-void BitReader::fetchData()
+void BitReader::refill()
 {
-	size_t numOfBits = m_bitBuffer.capacity - m_bitBuffer.size();
-	size_t numOfBytesToFetch = numOfBits / 8;
-	
-	for (size_t i = 0; i < numOfBytesToFetch; i++)
+	while (m_windowBits <= 56)
 	{
-		int byte = m_fileStream.get();
-		if (byte == EOF)
-		{
-			m_endOfFile = true;
-			return;
-		}
-
-		m_bitBuffer.writeByte(byte);
+		if (m_inputPosition == m_inputSize && !fetchData())
+			return;		// end of file, missing bits stay '0'
+
+		uint64_t bits = REVERSED_BITS[m_input[m_inputPosition++]];
+		m_window |= bits << (56 - m_windowBits);
+		m_windowBits += 8;
 	}
-}
\ No newline at end of file
+}
+
+bool BitReader::fetchData()
+{
+	m_inputSize = m_source.next(m_input);
+	m_inputPosition = 0;
+	return m_inputSize > 0;
+}
@@ -1,24 +1,68 @@
 #pragma once
+#include <cstdint>
+#include <memory>
 #include <string>
-#include <fstream>
 #include "BitBuffer.hpp"
+#include "../IO/ByteSource.hpp"
 
+// Reads bits from a source, least significant bit of every byte first.
+// When the whole input is read, it returns '0' bits.
+//
+// The source hands out big blocks of bytes. Bits are served from a 64-bit
+// window that keeps the next bit as its most significant one, so several
+// bits can be taken at once with peekBits() and consumeBits().
 class BitReader 
 {
 public:
-	BitReader(std::string filename);
+	BitReader(std::string filename);	// reads an existing file
+	BitReader(ByteSource& source);
 	
-	bool read();
+	inline bool read()
+	{
+		if (m_windowBits == 0)
+			refill();
+
+		bool bit = m_window >> 63;
+		m_window <<= 1;
+		m_windowBits -= m_windowBits > 0;
+		return bit;
+	}
 	BitReader& operator>> (bool & bit);
+	byte_t readByte();	// 8 bits, least significant first
+	void peekBytes(byte_t* bytes, int n);	// next n <= 4 bytes, not consumed
+
+	// Returns next n bits (n <= 32) without consuming them. The first bit
+	// is the most significant one in the result.
+	inline uint32_t peekBits(int n)
+	{
+		if (m_windowBits < n)
+			refill();
+		return n == 0 ? 0 : (uint32_t)(m_window >> (64 - n));
+	}
+
+	inline void consumeBits(int n)	// n <= 32
+	{
+		if (m_windowBits < n)
+			refill();
+		m_window <<= n;
+		m_windowBits = m_windowBits > n ? m_windowBits - n : 0;
+	}
 
 	inline bool eof() {
-		return m_endOfFile && m_bitBuffer.size() == 0; 
+		if (m_windowBits == 0)
+			refill();
+		return m_windowBits == 0;
 	}
 private:
-	const int BIT_BUFFER_CAPACITY = 8 * 1024;
-	bool m_endOfFile;
-	std::ifstream m_fileStream;
-	BitBuffer m_bitBuffer;
+	std::unique_ptr<ByteSource> m_ownedSource;
+	ByteSource& m_source;
+	const uint8_t* m_input = nullptr;	// current chunk of the source
+	size_t m_inputPosition = 0;
+	size_t m_inputSize = 0;
+
+	uint64_t m_window = 0;	// next bit is the most significant one
+	int m_windowBits = 0;	// number of valid bits in the window
 
-	void fetchData();
-};
\ No newline at end of file
+	void refill();
+	bool fetchData();
+};
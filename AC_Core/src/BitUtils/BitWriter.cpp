@@ -1,29 +1,17 @@
 #include "BitWriter.hpp"
+#include "../IO/FileIO.hpp"
 
-#include <filesystem>
+#include <stdexcept>
 
 BitWriter::BitWriter(std::string path)
-	: m_bitBuffer(BIT_BUFFER_CAPACITY), m_stats(256)
+	: m_ownedSink(std::make_unique<FileSink>(path)), m_sink(*m_ownedSink),
+	m_outputBuffer(OUTPUT_BUFFER_SIZE), m_stats(256)
 {
-	if (std::filesystem::exists(path))
-		throw std::runtime_error("File with this name already exists");
-
-	m_fileStream.open(path, std::ios_base::binary);
-	if (!m_fileStream.is_open())
-		throw std::runtime_error("Cannot open file");
 }
 
-void BitWriter::write(bool bit)
+BitWriter::BitWriter(ByteSink& sink)
+	: m_sink(sink), m_outputBuffer(OUTPUT_BUFFER_SIZE), m_stats(256)
 {
-	if (m_currentByte >= 0 && m_currentByte < m_stats.size())
-		m_stats[m_currentByte].writeCounter++;
-
-	m_bitBuffer << bit;
-	if (m_bitBuffer.size() >= BIT_BUFFER_CAPACITY)
-	{
-		byte_t byte = m_bitBuffer.readByte();
-		m_fileStream << byte;
-	}
 }
 
 void BitWriter::write(int bit)
@@ -48,43 +36,84 @@ BitWriter& BitWriter::operator<<(int bit)
 	return *this;
 }
 
-void BitWriter::writeN(bool bit, int n)
+void BitWriter::writeN(int bit, int n)
+{
+	writeN(bit == 0 ? false : true, n);
+}
+
+void BitWriter::writeByte(byte_t byte)
 {
-	while (n--) {
-		write(bit);
+	for (int i = 0; i < 8; i++)
+	{
+		write((bool)(byte & 0x01));
+		byte >>= 1;
 	}
 }
 
-void BitWriter::writeN(int bit, int n)
+void BitWriter::flushWord()
 {
-	writeN(bit == 0 ? false : true, n);
+	if (m_outputSize + 8 > m_outputBuffer.size())
+		flushBuffer();
+
+	for (int i = 0; i < 8; i++)		// little-endian, so bits keep their order
+		m_outputBuffer[m_outputSize++] = (byte_t)(m_bits >> (8 * i));
+
+	m_bits = 0;
+	m_bitCount = 0;
+	m_totalBits += 64;
+}
+
+void BitWriter::flushBuffer()
+{
+	if (m_outputSize > 0)
+		m_sink.write(m_outputBuffer.data(), m_outputSize);
+	m_outputSize = 0;
 }
 
 void BitWriter::flush()
 {
-	auto bytes = m_bitBuffer.readAllBytes(0);
-	for (auto byte : bytes)
-		m_fileStream << byte;
+	int numOfBytes = (m_bitCount + 7) / 8;	// last byte is padded with '0' bits
+	if (m_outputSize + numOfBytes > m_outputBuffer.size())
+		flushBuffer();
+
+	for (int i = 0; i < numOfBytes; i++)
+		m_outputBuffer[m_outputSize++] = (byte_t)(m_bits >> (8 * i));
 
-	m_fileStream.flush();
+	m_totalBits += m_bitCount;
+	m_bits = 0;
+	m_bitCount = 0;
+
+	flushBuffer();
+	m_sink.flush();
 }
 
-void BitWriter::beginByte(int byte)
+void BitWriter::settleStats()
+{
+	uint64_t written = m_totalBits + m_bitCount;
+	if (m_currentByte >= 0)
+		m_stats[m_currentByte].writeCounter += written - m_currentByteStart;
+	m_currentByteStart = written;
+}
+
+void BitWriter::beginByte(int byte, uint64_t count)
 {
 	if (byte >= 0 && byte < m_stats.size())
 	{
+		settleStats();
 		m_currentByte = byte;
-		m_stats[m_currentByte].readCounter += 8;
+		m_stats[m_currentByte].readCounter += 8 * count;
 	}
 }
 
 std::vector<BitStat> BitWriter::getStats()
 {
+	settleStats();
 	return m_stats;
 }
 
 BitWriter::~BitWriter()
 {
-	flush();
+	// when unwinding from an error the sink may throw again, which would terminate
+	if (std::uncaught_exceptions() == m_uncaughtExceptions)
+		flush();
 }
-
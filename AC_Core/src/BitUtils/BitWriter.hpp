@@ -1,34 +1,82 @@
-#include <fstream>
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <memory>
 #include <string>
 #include <vector>
 #include "BitBuffer.hpp"
 #include "BitStat.hpp"
+#include "../IO/ByteSink.hpp"
 
+// Writes bits to a sink, least significant bit of every byte first.
+//
+// Bits are collected in a 64-bit register and whole words are moved to
+// a large byte buffer, which is passed to the sink in big blocks.
+// Hot methods are defined here so they can be inlined into the coder.
 class BitWriter
 {
 public:
-	BitWriter(std::string path);
+	BitWriter(std::string path);	// writes to a new file
+	BitWriter(ByteSink& sink);
 
-	void write(bool bit);
+	inline void write(bool bit)
+	{
+		m_bits |= (uint64_t)bit << m_bitCount;
+		if (++m_bitCount == 64)
+			flushWord();
+	}
 	void write(int bit);
 	BitWriter& operator<< (bool bit);
 	BitWriter& operator<< (int bit);
 
-	void writeN(bool bit, int n);
+	// Writes a run of n identical bits with at most a few shifts per word.
+	inline void writeN(bool bit, int n)
+	{
+		while (n > 0)
+		{
+			int chunk = std::min(n, 64 - m_bitCount);
+			if (bit)
+				m_bits |= lowMask(chunk) << m_bitCount;
+			m_bitCount += chunk;
+			n -= chunk;
+			if (m_bitCount == 64)
+				flushWord();
+		}
+	}
 	void writeN(int bit, int n);
+	void writeByte(byte_t byte);	// 8 bits, least significant first
 
 	void flush();
 
-	void beginByte(int byte);
+	void beginByte(int byte, uint64_t count = 1);	// count: the same byte repeated
 	std::vector<BitStat> getStats();
 
 	virtual ~BitWriter();
 
 private:
-	const int BIT_BUFFER_CAPACITY = 8;
+	static constexpr size_t OUTPUT_BUFFER_SIZE = 64 * 1024;
+
+	std::unique_ptr<ByteSink> m_ownedSink;
+	ByteSink& m_sink;
+	std::vector<byte_t> m_outputBuffer;
+	size_t m_outputSize = 0;
+
+	uint64_t m_bits = 0;		// pending bits, the oldest one is the least significant
+	int m_bitCount = 0;
+	uint64_t m_totalBits = 0;	// bits moved out of the register so far
 
-	std::ofstream m_fileStream;
-	BitBuffer m_bitBuffer;
 	int m_currentByte = -1;
+	uint64_t m_currentByteStart = 0;	// m_totalBits when current byte has begun
 	std::vector<BitStat> m_stats;
-};
\ No newline at end of file
+	int m_uncaughtExceptions = std::uncaught_exceptions();	// to skip flushing in the destructor while unwinding
+
+	static inline uint64_t lowMask(int n)
+	{
+		return n >= 64 ? ~0uLL : (1uLL << n) - 1;
+	}
+
+	void flushWord();
+	void flushBuffer();
+	void settleStats();
+};
@@ -0,0 +1,419 @@
+#include "BlockCoder.hpp"
+#include "StreamHeader.hpp"
+#include "ThreadPool.hpp"
+#include "IO/LittleEndian.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+static constexpr size_t CONTAINER_HEADER_SIZE = StreamHeader::SIZE + 1 + 4 + 8;
+static constexpr size_t BLOCK_HEADER_SIZE = 4 + 4;
+static constexpr size_t INDEX_ENTRY_SIZE = 8 + 8;
+static constexpr size_t FOOTER_SIZE = 8 + 8 + 8 + 4;
+static constexpr uint8_t FOOTER_MAGIC[4] = { 'A', 'C', 'I', 'X' };
+static constexpr uint64_t UNKNOWN_SIZE = std::numeric_limits<uint64_t>::max();
+static constexpr size_t SAMPLE_SLICES = 16;
+static constexpr size_t SAMPLE_SLICE_SIZE = 4 * 1024;
+static constexpr size_t CODING_SLICE_SIZE = 64 * 1024;
+
+// Counts every byte as 8 input bits (and as 8 output bits if stored).
+static void countBytes(const uint8_t* data, size_t size, std::vector<BitStat>& stats, bool stored)
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		stats[data[i]].readCounter += 8;
+		if (stored)
+			stats[data[i]].writeCounter += 8;
+	}
+}
+
+// Compares order-0 entropy of a few slices spread over the block with that
+// of random bytes. A sample of n random bytes misses some values, so its
+// entropy is about 8 - 255 / (2 n ln 2) bits per byte: 7.955 for 4 KiB.
+static bool looksRandom(const std::vector<uint8_t>& block)
+{
+	std::vector<BitStat> stats(256);
+	size_t sampleSize = std::min(block.size(), SAMPLE_SLICES * SAMPLE_SLICE_SIZE);
+	if (block.size() <= SAMPLE_SLICES * SAMPLE_SLICE_SIZE)
+		countBytes(block.data(), block.size(), stats, false);
+	else
+		for (size_t i = 0; i < SAMPLE_SLICES; i++)
+			countBytes(&block[i * (block.size() - SAMPLE_SLICE_SIZE) / (SAMPLE_SLICES - 1)], SAMPLE_SLICE_SIZE, stats, false);
+
+	double randomEntropy = 8.0 - 255.0 / (2.0 * (double)sampleSize * std::log(2.0));
+	return Statistics(stats).entropy() > randomEntropy - BlockCoder::STORED_ENTROPY_MARGIN;
+}
+
+// Hands out a block to the inner coder in slices and ends it early when
+// the output has grown past the input taken so far: such a block is
+// stored anyway, so the rest of it would be coded for nothing.
+class BlockSource : public ByteSource
+{
+public:
+	BlockSource(const std::vector<uint8_t>& block, const std::vector<uint8_t>& output)
+		: m_block(block), m_output(output) {}
+
+	size_t next(const uint8_t*& data) override
+	{
+		if (m_given > 0 && m_output.size() > m_given)
+		{
+			m_expanded = true;
+			return 0;
+		}
+		data = m_block.data() + m_given;
+		size_t size = std::min(CODING_SLICE_SIZE, m_block.size() - m_given);
+		m_given += size;
+		return size;
+	}
+
+	long long size() const override { return (long long)m_block.size(); }
+
+	bool seekable() const override { return true; }
+	size_t readAt(uint64_t offset, uint8_t* data, size_t size) override
+	{
+		return MemorySource(m_block.data(), m_block.size()).readAt(offset, data, size);
+	}
+
+	bool expanded() const { return m_expanded; }
+
+private:
+	const std::vector<uint8_t>& m_block;
+	const std::vector<uint8_t>& m_output;
+	size_t m_given = 0;
+	bool m_expanded = false;
+};
+
+static void readExactlyAt(ByteSource& in, uint64_t offset, uint8_t* data, size_t size)
+{
+	if (in.readAt(offset, data, size) != size)
+		throw std::runtime_error("block container is truncated");
+}
+
+struct ContainerHeader
+{
+	size_t blockSize;
+	uint64_t originalSize;
+
+	void parse(const uint8_t bytes[CONTAINER_HEADER_SIZE])
+	{
+		StreamHeader header;
+		if (!header.deserialize(bytes) || header.format != StreamFormat::BlockContainer)
+			throw std::runtime_error("data is not a block container");
+		if (bytes[StreamHeader::SIZE] == 0 || bytes[StreamHeader::SIZE] > BlockCoder::CONTAINER_VERSION)
+			throw std::runtime_error("unsupported block container version");
+
+		blockSize = getLittleEndian<uint32_t>(bytes + StreamHeader::SIZE + 1);
+		originalSize = getLittleEndian<uint64_t>(bytes + StreamHeader::SIZE + 5);
+		if (blockSize == 0)
+			throw std::runtime_error("block container is corrupted");
+	}
+
+	size_t maxEncodedSize() const	// sanity limit for corrupted data
+	{
+		return 2 * blockSize + 1024;
+	}
+};
+
+struct EncodedBlock
+{
+	uint32_t originalSize;
+	bool stored = false;
+	std::vector<uint8_t> data;
+	Statistics stats;
+};
+
+BlockCoder::BlockCoder(CoderFactory factory, unsigned threads, size_t blockSize)
+	: factory(factory), threads(threads), blockSize(blockSize)
+{
+	if (blockSize == 0 || blockSize > std::numeric_limits<uint32_t>::max())
+		throw std::invalid_argument("block size must be between 1 byte and 4 GiB");
+}
+
+Statistics BlockCoder::encode(ByteSource& source, ByteSink& sink)
+{
+	ByteReader in(source);
+	ThreadPool pool(threads > 1 ? threads : 0);
+	const size_t maxBlocksInFlight = 2 * pool.size() + 1;
+	std::deque<std::future<EncodedBlock>> blocksInFlight;
+	Statistics stats;
+
+	uint64_t originalOffset = 0;
+	uint64_t encodedOffset = 0;
+	std::vector<uint8_t> index;
+
+	auto write = [&](const uint8_t* data, size_t size) {
+		sink.write(data, size);
+		encodedOffset += size;
+	};
+
+	uint8_t header[CONTAINER_HEADER_SIZE];
+	StreamHeader streamHeader;
+	streamHeader.format = StreamFormat::BlockContainer;
+	streamHeader.serialize(header);
+	header[StreamHeader::SIZE] = CONTAINER_VERSION;
+	putLittleEndian<uint32_t>(header + StreamHeader::SIZE + 1, (uint32_t)blockSize);
+	putLittleEndian<uint64_t>(header + StreamHeader::SIZE + 5, source.size() >= 0 ? (uint64_t)source.size() : UNKNOWN_SIZE);
+	write(header, CONTAINER_HEADER_SIZE);
+
+	auto writeOldestBlock = [&]() {
+		EncodedBlock block = blocksInFlight.front().get();
+		blocksInFlight.pop_front();
+
+		uint8_t entry[INDEX_ENTRY_SIZE];
+		putLittleEndian<uint64_t>(entry, originalOffset);
+		putLittleEndian<uint64_t>(entry + 8, encodedOffset);
+		index.insert(index.end(), entry, entry + INDEX_ENTRY_SIZE);
+
+		uint8_t blockHeader[BLOCK_HEADER_SIZE];
+		putLittleEndian<uint32_t>(blockHeader, block.originalSize);
+		putLittleEndian<uint32_t>(blockHeader + 4, block.stored ? 0 : (uint32_t)block.data.size());
+		write(blockHeader, BLOCK_HEADER_SIZE);
+		write(block.data.data(), block.data.size());
+
+		originalOffset += block.originalSize;
+		stats.add(block.stats);
+	};
+
+	while (true)
+	{
+		std::vector<uint8_t> block(blockSize);
+		block.resize(in.read(block.data(), blockSize));
+		if (block.empty())
+			break;
+
+		if (blocksInFlight.size() >= maxBlocksInFlight)
+			writeOldestBlock();
+
+		blocksInFlight.push_back(pool.submit([this, block = std::move(block)]() mutable {
+			EncodedBlock encoded;
+			encoded.originalSize = (uint32_t)block.size();
+			encoded.stored = looksRandom(block);
+			if (!encoded.stored)
+			{
+				BlockSource source(block, encoded.data);
+				MemorySink sink(encoded.data);
+				encoded.stats = factory()->encode(source, sink);
+				encoded.stored = source.expanded() || encoded.data.size() >= block.size();
+			}
+			if (encoded.stored)
+			{
+				std::vector<BitStat> stats(256);
+				countBytes(block.data(), block.size(), stats, true);
+				encoded.stats = Statistics(stats);
+				encoded.data = std::move(block);
+			}
+			return encoded;
+		}));
+	}
+
+	while (!blocksInFlight.empty())
+		writeOldestBlock();
+
+	uint8_t endMarker[4] = {};
+	write(endMarker, 4);
+
+	uint64_t indexOffset = encodedOffset;
+	write(index.data(), index.size());
+
+	uint8_t footer[FOOTER_SIZE];
+	putLittleEndian<uint64_t>(footer, indexOffset);
+	putLittleEndian<uint64_t>(footer + 8, index.size() / INDEX_ENTRY_SIZE);
+	putLittleEndian<uint64_t>(footer + 16, originalOffset);
+	std::copy(FOOTER_MAGIC, FOOTER_MAGIC + 4, footer + 24);
+	write(footer, FOOTER_SIZE);
+
+	sink.flush();
+	return stats;
+}
+
+void BlockCoder::decode(ByteSource& source, ByteSink& out)
+{
+	ByteReader in(source);
+	ThreadPool pool(threads > 1 ? threads : 0);
+	const size_t maxBlocksInFlight = 2 * pool.size() + 1;
+	std::deque<std::future<std::vector<uint8_t>>> blocksInFlight;
+
+	uint8_t bytes[CONTAINER_HEADER_SIZE];
+	if (in.read(bytes, CONTAINER_HEADER_SIZE) != CONTAINER_HEADER_SIZE)
+		throw std::runtime_error("data is not a block container");
+	ContainerHeader header;
+	header.parse(bytes);
+
+	uint64_t decodedSize = 0;
+	uint64_t numberOfBlocks = 0;
+
+	auto writeOldestBlock = [&]() {
+		std::vector<uint8_t> block = blocksInFlight.front().get();
+		blocksInFlight.pop_front();
+		out.write(block.data(), block.size());
+	};
+
+	while (true)
+	{
+		uint8_t blockHeader[BLOCK_HEADER_SIZE];
+		readExactly(in, blockHeader, 4);
+		size_t originalSize = getLittleEndian<uint32_t>(blockHeader);
+		if (originalSize == 0)
+			break;	// end marker
+
+		readExactly(in, blockHeader + 4, 4);
+		size_t encodedSize = getLittleEndian<uint32_t>(blockHeader + 4);
+		if (originalSize > header.blockSize || encodedSize > header.maxEncodedSize())
+			throw std::runtime_error("block container is corrupted");
+
+		bool stored = encodedSize == 0;
+		std::vector<uint8_t> encoded(stored ? originalSize : encodedSize);
+		readExactly(in, encoded.data(), encoded.size());
+
+		if (blocksInFlight.size() >= maxBlocksInFlight)
+			writeOldestBlock();
+
+		blocksInFlight.push_back(pool.submit([this, originalSize, stored, encoded = std::move(encoded)]() mutable {
+			return decodeBlock(std::move(encoded), originalSize, stored);
+		}));
+
+		decodedSize += originalSize;
+		numberOfBlocks++;
+	}
+
+	while (!blocksInFlight.empty())
+		writeOldestBlock();
+
+	// Index is not needed for sequential decoding, but the footer
+	// confirms that nothing is missing.
+	std::vector<uint8_t> index(numberOfBlocks * INDEX_ENTRY_SIZE);
+	uint8_t footer[FOOTER_SIZE];
+	readExactly(in, index.data(), index.size());
+	readExactly(in, footer, FOOTER_SIZE);
+	if (!std::equal(FOOTER_MAGIC, FOOTER_MAGIC + 4, footer + 24)
+		|| getLittleEndian<uint64_t>(footer + 8) != numberOfBlocks || getLittleEndian<uint64_t>(footer + 16) != decodedSize)
+		throw std::runtime_error("block container is corrupted");
+
+	out.flush();
+}
+
+void BlockCoder::decodeRange(ByteSource& in, ByteSink& out, uint64_t offset, uint64_t length)
+{
+	if (!in.seekable() || in.size() < 0)
+		throw std::runtime_error("partial decoding requires a seekable source");
+
+	const uint64_t containerSize = (uint64_t)in.size();
+	if (containerSize < CONTAINER_HEADER_SIZE + FOOTER_SIZE)
+		throw std::runtime_error("block container is truncated");
+
+	uint8_t bytes[CONTAINER_HEADER_SIZE];
+	readExactlyAt(in, 0, bytes, CONTAINER_HEADER_SIZE);
+	ContainerHeader header;
+	header.parse(bytes);
+
+	uint8_t footer[FOOTER_SIZE];
+	readExactlyAt(in, containerSize - FOOTER_SIZE, footer, FOOTER_SIZE);
+	if (!std::equal(FOOTER_MAGIC, FOOTER_MAGIC + 4, footer + 24))
+		throw std::runtime_error("block container has no index");
+
+	const uint64_t indexOffset = getLittleEndian<uint64_t>(footer);
+	const uint64_t numberOfBlocks = getLittleEndian<uint64_t>(footer + 8);
+	const uint64_t originalSize = getLittleEndian<uint64_t>(footer + 16);
+	if (indexOffset > containerSize || numberOfBlocks > (containerSize - indexOffset) / INDEX_ENTRY_SIZE)
+		throw std::runtime_error("block container is corrupted");
+
+	std::vector<uint8_t> index(numberOfBlocks * INDEX_ENTRY_SIZE);
+	readExactlyAt(in, indexOffset, index.data(), index.size());
+	auto originalOffsetOf = [&](uint64_t block) { return getLittleEndian<uint64_t>(&index[block * INDEX_ENTRY_SIZE]); };
+	auto encodedOffsetOf = [&](uint64_t block) { return getLittleEndian<uint64_t>(&index[block * INDEX_ENTRY_SIZE + 8]); };
+	auto originalEndOf = [&](uint64_t block) { return block + 1 < numberOfBlocks ? originalOffsetOf(block + 1) : originalSize; };
+
+	// offsets must ascend from 0 and stay inside the data, so block i covers [offset i, offset i+1)
+	if ((numberOfBlocks == 0) != (originalSize == 0) || (numberOfBlocks > 0 && originalOffsetOf(0) != 0))
+		throw std::runtime_error("block container is corrupted");
+	for (uint64_t block = 0; block < numberOfBlocks; block++)
+	{
+		if (originalOffsetOf(block) >= originalEndOf(block) || encodedOffsetOf(block) >= indexOffset
+			|| (block > 0 && encodedOffsetOf(block) <= encodedOffsetOf(block - 1)))
+			throw std::runtime_error("block container is corrupted");
+	}
+
+	// clamp the range to the original data
+	const uint64_t begin = std::min(offset, originalSize);
+	const uint64_t end = begin + std::min(length, originalSize - begin);
+	if (begin == end)
+		return;
+
+	// the last block starting at or before 'begin' (original offsets are ascending)
+	uint64_t first = 0, last = numberOfBlocks;
+	while (last - first > 1) {
+		uint64_t middle = (first + last) / 2;
+		if (originalOffsetOf(middle) <= begin)
+			first = middle;
+		else
+			last = middle;
+	}
+
+	ThreadPool pool(threads > 1 ? threads : 0);
+	const size_t maxBlocksInFlight = 2 * pool.size() + 1;
+	struct DecodedBlock { uint64_t originalOffset; uint64_t originalEnd; std::vector<uint8_t> data; };
+	std::deque<std::future<DecodedBlock>> blocksInFlight;
+
+	auto writeOldestBlock = [&]() {
+		DecodedBlock block = blocksInFlight.front().get();
+		blocksInFlight.pop_front();
+		if (block.data.size() != block.originalEnd - block.originalOffset)
+			throw std::runtime_error("encoded data is corrupted");
+
+		uint64_t from = std::max(begin, block.originalOffset);
+		uint64_t to = std::min(end, block.originalOffset + block.data.size());
+		out.write(block.data.data() + (from - block.originalOffset), (size_t)(to - from));
+	};
+
+	for (uint64_t block = first; block < numberOfBlocks && originalOffsetOf(block) < end; block++)
+	{
+		uint8_t blockHeader[BLOCK_HEADER_SIZE];
+		readExactlyAt(in, encodedOffsetOf(block), blockHeader, BLOCK_HEADER_SIZE);
+		size_t blockOriginalSize = getLittleEndian<uint32_t>(blockHeader);
+		size_t encodedSize = getLittleEndian<uint32_t>(blockHeader + 4);
+		if (blockOriginalSize == 0 || blockOriginalSize > header.blockSize || encodedSize > header.maxEncodedSize())
+			throw std::runtime_error("block container is corrupted");
+
+		bool stored = encodedSize == 0;
+		std::vector<uint8_t> encoded(stored ? blockOriginalSize : encodedSize);
+		readExactlyAt(in, encodedOffsetOf(block) + BLOCK_HEADER_SIZE, encoded.data(), encoded.size());
+
+		if (blocksInFlight.size() >= maxBlocksInFlight)
+			writeOldestBlock();
+
+		uint64_t blockOriginalOffset = originalOffsetOf(block);
+		uint64_t blockOriginalEnd = originalEndOf(block);
+		blocksInFlight.push_back(pool.submit([this, blockOriginalOffset, blockOriginalEnd, blockOriginalSize, stored, encoded = std::move(encoded)]() mutable {
+			return DecodedBlock{ blockOriginalOffset, blockOriginalEnd, decodeBlock(std::move(encoded), blockOriginalSize, stored) };
+		}));
+	}
+
+	while (!blocksInFlight.empty())
+		writeOldestBlock();
+
+	out.flush();
+}
+
+std::vector<uint8_t> BlockCoder::decodeBlock(std::vector<uint8_t>&& encoded, size_t originalSize, bool stored) const
+{
+	if (stored)
+		return std::move(encoded);		// read as long as the original block
+
+	std::vector<uint8_t> decoded;
+	decoded.reserve(originalSize);
+	factory()->decode(encoded.data(), encoded.size(), decoded);
+	if (decoded.size() != originalSize)
+		throw std::runtime_error("block container is corrupted");
+	return decoded;
+}
+
+void BlockCoder::decodeRange(const uint8_t* data, size_t size, uint64_t offset, uint64_t length, std::vector<uint8_t>& out)
+{
+	MemorySource source(data, size);
+	MemorySink sink(out);
+	decodeRange(source, sink, offset, length);
+}
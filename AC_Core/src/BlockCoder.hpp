@@ -0,0 +1,65 @@
+#pragma once
+#include "ArithmeticCoder.hpp"
+#include "Statistics.hpp"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Splits input into blocks of fixed size and codes every block independently
+// (with a fresh model) using coders created by the factory. Blocks are coded
+// on a thread pool, but the output does not depend on the number of threads.
+// Memory is bounded by the number of blocks in flight (2 per thread).
+//
+// Blocks that don't compress (e.g. already compressed media) are stored as
+// they are: a block is not coded at all if a sample of it looks random,
+// and coding stops as soon as the output grows past the input it took.
+//
+// The container ends with an index of blocks, so a seekable source can be
+// decoded partially (see decodeRange). Layout (integers are little-endian):
+//
+//   StreamHeader            "AC", StreamFormat::BlockContainer, flags
+//   container version       uint8
+//   block size              uint32
+//   original size           uint64 (all ones if unknown when encoding started)
+//   for every block:
+//     original size         uint32 (1 .. block size)
+//     encoded size          uint32 (0 if the block is stored)
+//     encoded data          stream produced by the inner coder, or the
+//                           original bytes of a stored block
+//   end marker              uint32 equal to 0
+//   index, for every block:
+//     original offset       uint64
+//     encoded offset        uint64 (of the block, from the beginning of the container)
+//   footer:
+//     index offset          uint64
+//     number of blocks      uint64
+//     original size         uint64
+//     magic                 "ACIX"
+class BlockCoder : public ArithmeticCoder
+{
+public:
+	using CoderFactory = std::function<std::unique_ptr<ArithmeticCoder>()>;
+	static constexpr size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+	static constexpr uint8_t CONTAINER_VERSION = 2;		// 1 has no stored blocks
+	static constexpr double STORED_ENTROPY_MARGIN = 0.03;	// a block is stored if its sample is this close to random (bits per byte)
+
+	BlockCoder(CoderFactory factory, unsigned threads = 1, size_t blockSize = DEFAULT_BLOCK_SIZE);
+	using ArithmeticCoder::encode;
+	using ArithmeticCoder::decode;
+
+	Statistics encode(ByteSource& in, ByteSink& out) override;
+	void decode(ByteSource& in, ByteSink& out) override;
+
+	// Decodes original bytes [offset, offset + length) using the index, so
+	// only the blocks overlapping the range are read. Source must be seekable.
+	void decodeRange(ByteSource& in, ByteSink& out, uint64_t offset, uint64_t length);
+	void decodeRange(const uint8_t* data, size_t size, uint64_t offset, uint64_t length, std::vector<uint8_t>& out);
+
+private:
+	CoderFactory factory;
+	unsigned threads;
+	size_t blockSize;
+
+	std::vector<uint8_t> decodeBlock(std::vector<uint8_t>&& encoded, size_t originalSize, bool stored) const;
+};
@@ -0,0 +1,253 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#include "BwtCoder.hpp"
+#include "SuffixArray.hpp"
+#include "IO/LittleEndian.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+BwtCoder::BwtCoder(size_t blockSize, bool printProgress)
+	: blockSize(blockSize), printProgress(printProgress)
+{
+	if (blockSize < MIN_BLOCK_SIZE || blockSize > MAX_BLOCK_SIZE)
+		throw std::invalid_argument("BWT block size must be 1 KiB to 16 MiB");
+}
+
+Statistics BwtCoder::encode(ByteSource& in, ByteSink& out)
+{
+	Encoder encoder(out, blockSize);
+	return encodeWith(in, encoder, printProgress);
+}
+
+void BwtCoder::decode(ByteSource& in, ByteSink& out)
+{
+	Decoder decoder(out);
+	decodeWith(in, decoder, printProgress);
+}
+
+uint32_t BwtCoder::transform(const uint8_t* block, size_t size, uint8_t* last, std::vector<int32_t>& sa)
+{
+	suffixArray(block, size, sa);
+
+	// Row 0 is the sentinel followed by the block, so it ends with the last byte.
+	uint32_t primary = 0;
+	size_t j = 0;
+	if (size > 0)
+		last[j++] = block[size - 1];
+	for (size_t row = 1; row <= size; row++)
+	{
+		if (sa[row] == 0)
+			primary = (uint32_t)row;	// ends with the sentinel
+		else
+			last[j++] = block[sa[row] - 1];
+	}
+	return primary;
+}
+
+void BwtCoder::inverseTransform(const uint8_t* last, size_t size, uint32_t primary, uint8_t* block, std::vector<uint32_t>& next)
+{
+	if (size == 0)
+		return;
+	if (primary == 0 || primary > size)
+		throw std::runtime_error("encoded data is corrupted");
+
+	// Rows starting with every byte come after the row starting with the sentinel.
+	uint32_t starts[256] = {};
+	for (size_t i = 0; i < size; i++)
+		starts[last[i]]++;
+	uint32_t sum = 1;
+	for (uint32_t& start : starts) {
+		uint32_t count = start;
+		start = sum;
+		sum += count;
+	}
+
+	// next[row]: the row of the rotation that starts with the last byte of row;
+	// the n-th occurrence of a byte in the last column is its n-th row in the first one.
+	next.resize(size + 1);
+	next[primary] = 0;
+	for (size_t row = 0; row <= size; row++)
+		if (row != primary)
+			next[row] = starts[last[row - (row > primary)]]++;
+
+	uint32_t row = 0;
+	for (size_t i = size; i-- > 0; ) {
+		block[i] = last[row - (row >= primary)];	// never the sentinel in valid data
+		row = next[row];
+	}
+}
+
+void BwtCoder::moveToFront(uint8_t* data, size_t size)
+{
+	uint8_t order[256];
+	for (int i = 0; i < 256; i++)
+		order[i] = (uint8_t)i;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		uint8_t byte = data[i];
+		int rank = 0;
+		while (order[rank] != byte)
+			rank++;
+		std::memmove(order + 1, order, rank);
+		order[0] = byte;
+		data[i] = (uint8_t)rank;
+	}
+}
+
+void BwtCoder::inverseMoveToFront(uint8_t* data, size_t size)
+{
+	uint8_t order[256];
+	for (int i = 0; i < 256; i++)
+		order[i] = (uint8_t)i;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		int rank = data[i];
+		uint8_t byte = order[rank];
+		std::memmove(order + 1, order, rank);
+		order[0] = byte;
+		data[i] = byte;
+	}
+}
+
+BwtCoder::Encoder::Encoder(ByteSink& sink, size_t blockSize)
+	: block(blockSize), transformed(BLOCK_HEADER_SIZE + blockSize)
+{
+	StreamHeader header;
+	header.format = StreamFormat::Bwt;
+	uint8_t bytes[StreamHeader::SIZE + PARAMETERS_SIZE];
+	header.serialize(bytes);
+	putLittleEndian<uint32_t>(bytes + StreamHeader::SIZE, (uint32_t)blockSize);
+	sink.write(bytes, sizeof(bytes));
+
+	coder = std::make_unique<AdaptiveScalingCoder::Encoder>(sink);
+}
+
+void BwtCoder::Encoder::feed(const uint8_t* data, size_t size)
+{
+	if (finished)
+		throw std::logic_error("cannot feed finished encoder");
+
+	while (size > 0)
+	{
+		size_t count = std::min(size, block.size() - filled);
+		std::memcpy(&block[filled], data, count);
+		filled += count;
+		data += count;
+		size -= count;
+
+		if (filled == block.size())
+			codeBlock();
+	}
+}
+
+Statistics BwtCoder::Encoder::finish()
+{
+	if (!finished)
+	{
+		if (filled > 0)
+			codeBlock();
+		finished = true;
+	}
+	return coder->finish();
+}
+
+void BwtCoder::Encoder::codeBlock()
+{
+	uint8_t* ranks = &transformed[BLOCK_HEADER_SIZE];
+	uint32_t primary = transform(block.data(), filled, ranks, sa);
+	moveToFront(ranks, filled);
+
+	putLittleEndian<uint32_t>(&transformed[0], (uint32_t)filled);
+	putLittleEndian<uint32_t>(&transformed[4], primary);
+	coder->feed(transformed.data(), BLOCK_HEADER_SIZE + filled);
+	filled = 0;
+}
+
+BwtCoder::Decoder::Decoder(ByteSink& sink)
+	: sink(sink)
+{
+}
+
+void BwtCoder::Decoder::feed(const uint8_t* data, size_t size)
+{
+	if (!coder)
+	{
+		size_t count = std::min(size, sizeof(header) - headerFilled);
+		std::memcpy(header + headerFilled, data, count);
+		headerFilled += count;
+		data += count;
+		size -= count;
+		if (headerFilled < sizeof(header))
+			return;
+
+		StreamHeader streamHeader;
+		if (!streamHeader.deserialize(header) || streamHeader.format != StreamFormat::Bwt)
+			throw std::runtime_error("data was encoded in a different format");
+		blockSize = getLittleEndian<uint32_t>(header + StreamHeader::SIZE);
+		if (blockSize < MIN_BLOCK_SIZE || blockSize > MAX_BLOCK_SIZE)
+			throw std::runtime_error("encoded data has an invalid BWT block size");
+
+		coder = std::make_unique<AdaptiveScalingCoder::Decoder>(static_cast<ByteSink&>(*this));
+	}
+
+	if (size > 0)
+		coder->feed(data, size);
+}
+
+void BwtCoder::Decoder::finish()
+{
+	if (!coder)
+		throw std::runtime_error("encoded data is truncated or corrupted");
+
+	coder->finish();
+	if (!coder->done() || blockHeaderFilled > 0)
+		throw std::runtime_error("encoded data is truncated or corrupted");
+}
+
+void BwtCoder::Decoder::write(const uint8_t* data, size_t size)
+{
+	while (size > 0)
+	{
+		if (blockHeaderFilled < BLOCK_HEADER_SIZE)
+		{
+			size_t count = std::min(size, BLOCK_HEADER_SIZE - blockHeaderFilled);
+			std::memcpy(blockHeader + blockHeaderFilled, data, count);
+			blockHeaderFilled += count;
+			data += count;
+			size -= count;
+			if (blockHeaderFilled < BLOCK_HEADER_SIZE)
+				return;
+
+			size_t length = getLittleEndian<uint32_t>(blockHeader);
+			primary = getLittleEndian<uint32_t>(blockHeader + 4);
+			if (length == 0 || length > blockSize || primary == 0 || primary > length)
+				throw std::runtime_error("encoded data is corrupted");
+			last.resize(length);	// at most the block size
+			lastFilled = 0;
+			continue;
+		}
+
+		size_t count = std::min(size, last.size() - lastFilled);
+		std::memcpy(&last[lastFilled], data, count);
+		lastFilled += count;
+		data += count;
+		size -= count;
+		if (lastFilled == last.size())
+			decodeBlock();
+	}
+}
+
+void BwtCoder::Decoder::decodeBlock()
+{
+	inverseMoveToFront(last.data(), last.size());
+	block.resize(last.size());
+	inverseTransform(last.data(), last.size(), primary, block.data(), next);
+	sink.write(block.data(), block.size());
+	blockHeaderFilled = 0;
+}
@@ -0,0 +1,110 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+#include "AdaptiveScalingCoder.hpp"
+#include "ArithmeticCoder.hpp"
+#include "Statistics.hpp"
+#include "StreamHeader.hpp"
+
+#include <memory>
+#include <vector>
+
+// Block-sorting coder: every block of the input is transformed with the
+// Burrows-Wheeler transform (suffixes sorted by SuffixArray) and move-to-front,
+// which turn repeated contexts into runs of small numbers. The result is
+// coded with the adaptive order-0 model of AdaptiveScalingCoder.
+//
+// Memory depends only on the block size: about 10 bytes per byte of a
+// block to encode and 6 to decode.
+//
+//   byte 4-7: block size (little endian)
+//   byte 8-:  AdaptiveScalingCoder stream of the transformed blocks
+//
+// A transformed block is its length and primary index (4 bytes each, little
+// endian), followed by the move-to-front ranks of its transform.
+class BwtCoder : public ArithmeticCoder
+{
+public:
+	static constexpr int PARAMETERS_SIZE = 4;
+	static constexpr int BLOCK_HEADER_SIZE = 8;
+	static constexpr size_t MIN_BLOCK_SIZE = 1 << 10;
+	static constexpr size_t MAX_BLOCK_SIZE = 1 << 24;
+	static constexpr size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+
+	class Encoder;
+	class Decoder;
+
+	// Decoding ignores the block size, it is read from the data.
+	BwtCoder(size_t blockSize = DEFAULT_BLOCK_SIZE, bool printProgress = false);
+	using ArithmeticCoder::encode;
+	using ArithmeticCoder::decode;
+
+	Statistics encode(ByteSource& in, ByteSink& out) override;
+	void decode(ByteSource& in, ByteSink& out) override;
+
+	// Writes the last column of the sorted rotations of block (with a sentinel
+	// after it) without the sentinel and returns the row where the sentinel was.
+	static uint32_t transform(const uint8_t* block, size_t size, uint8_t* last, std::vector<int32_t>& sa);
+	static void inverseTransform(const uint8_t* last, size_t size, uint32_t primary, uint8_t* block, std::vector<uint32_t>& next);
+
+	static void moveToFront(uint8_t* data, size_t size);
+	static void inverseMoveToFront(uint8_t* data, size_t size);
+
+private:
+	size_t blockSize;
+	bool printProgress;
+};
+
+// Push-based encoder. Data is collected until a block is full; the block
+// is then transformed and fed to the order-0 encoder as a whole.
+class BwtCoder::Encoder
+{
+public:
+	Encoder(ByteSink& sink, size_t blockSize);
+
+	void feed(const uint8_t* data, size_t size);
+	Statistics finish();	// codes the last block and flushes the sink; statistics are of transformed bytes
+
+private:
+	std::unique_ptr<AdaptiveScalingCoder::Encoder> coder;	// after the header
+	std::vector<uint8_t> block;
+	size_t filled = 0;
+	std::vector<uint8_t> transformed;
+	std::vector<int32_t> sa;
+	bool finished = false;
+
+	void codeBlock();
+};
+
+// Push-based decoder. It is the sink of the order-0 decoder, and restores
+// a block as soon as that one has given all of its bytes.
+class BwtCoder::Decoder : private ByteSink
+{
+public:
+	Decoder(ByteSink& sink);
+
+	void feed(const uint8_t* data, size_t size);
+	void finish();		// no more data: throws if the last block is incomplete
+	bool done() const { return coder && coder->done(); }
+
+private:
+	ByteSink& sink;
+	uint8_t header[StreamHeader::SIZE + PARAMETERS_SIZE];
+	size_t headerFilled = 0;
+	size_t blockSize = 0;
+	std::unique_ptr<AdaptiveScalingCoder::Decoder> coder;
+
+	// the block being received from the order-0 decoder
+	uint8_t blockHeader[BLOCK_HEADER_SIZE];
+	size_t blockHeaderFilled = 0;
+	std::vector<uint8_t> last;
+	size_t lastFilled = 0;
+	uint32_t primary = 0;
+	std::vector<uint8_t> block;
+	std::vector<uint32_t> next;
+
+	void write(const uint8_t* data, size_t size) override;	// bytes decoded by coder
+	void decodeBlock();
+};
@@ -0,0 +1,136 @@
+#include "Codec.hpp"
+#include "AdaptiveScalingCoder.hpp"
+#include "BinaryCoder.hpp"
+#include "BlockCoder.hpp"
+#include "BwtCoder.hpp"
+#include "ContextMixingCoder.hpp"
+#include "Order1Coder.hpp"
+#include "InterleavedCoder.hpp"
+#include "LzCoder.hpp"
+#include "PPMCoder.hpp"
+#include "RansCoder.hpp"
+#include "RunLengthCoder.hpp"
+#include "StaticCoder.hpp"
+
+#include <stdexcept>
+
+namespace
+{
+	std::unique_ptr<ArithmeticCoder> makeStreamEncoder(const CodecOptions& options, bool printProgress)
+	{
+		switch (options.model)
+		{
+		case ModelType::Order1:
+			return std::make_unique<Order1Coder>(printProgress, options.arithmetic);
+		case ModelType::PPM:
+			return std::make_unique<PPMCoder>(options.ppmOrder, options.modelMemory, printProgress);
+		case ModelType::Binary:
+			return std::make_unique<BinaryCoder>(printProgress);
+		case ModelType::ContextMixing:
+			return std::make_unique<ContextMixingCoder>(options.modelMemory, printProgress);
+		case ModelType::Static:
+			return std::make_unique<StaticCoder>(options.threads, printProgress);
+		case ModelType::Rans:
+			return std::make_unique<RansCoder>(options.ransStates, printProgress);
+		case ModelType::Lz:
+			return std::make_unique<LzCoder>(options.lzWindowBits, printProgress);
+		case ModelType::Bwt:
+			return std::make_unique<BwtCoder>(options.bwtBlockSize, printProgress);
+		default:
+			if (options.streams > 1)
+				return std::make_unique<InterleavedCoder>(options.streams, printProgress);
+			if (options.runs)
+				return std::make_unique<RunLengthCoder>(printProgress);
+			return std::make_unique<AdaptiveScalingCoder>(printProgress, options.arithmetic);
+		}
+	}
+
+	// Decodes data of any format, the coder is chosen by the header.
+	// Used for blocks of a container, as they may be coded with any model.
+	class AnyFormatDecoder : public ArithmeticCoder
+	{
+	public:
+		Statistics encode(ByteSource&, ByteSink&) override
+		{
+			throw std::logic_error("AnyFormatDecoder cannot encode");
+		}
+
+		void decode(ByteSource& source, ByteSink& out) override
+		{
+			ByteReader in(source);
+			makeDecoder(in, CodecOptions())->decode(in, out);
+		}
+	};
+}
+
+std::unique_ptr<ArithmeticCoder> makeEncoder(const CodecOptions& options)
+{
+	if (options.model != ModelType::Order0 && options.arithmetic == IntervalArithmetic::FloatingPoint)
+		throw std::invalid_argument("legacy floating-point streams support only the order-0 model");
+	if (options.streams > 1 && (options.model != ModelType::Order0 || options.arithmetic == IntervalArithmetic::FloatingPoint))
+		throw std::invalid_argument("interleaved streams support only the order-0 model");
+	if (options.runs && (options.model != ModelType::Order0 || options.arithmetic == IntervalArithmetic::FloatingPoint || options.streams > 1))
+		throw std::invalid_argument("run-length coding supports only the order-0 model in a single stream");
+
+	if (options.blockSize == 0 && (options.threads <= 1 || options.model == ModelType::Static))
+		return makeStreamEncoder(options, options.printProgress);
+
+	CodecOptions blockOptions = options;
+	blockOptions.threads = 1;		// blocks are already coded in parallel
+	auto factory = [blockOptions]() { return makeStreamEncoder(blockOptions, false); };
+	size_t blockSize = options.blockSize != 0 ? options.blockSize : BlockCoder::DEFAULT_BLOCK_SIZE;
+	return std::make_unique<BlockCoder>(factory, options.threads, blockSize);
+}
+
+std::unique_ptr<ArithmeticCoder> makeDecoder(ByteReader& in, const CodecOptions& options)
+{
+	uint8_t bytes[StreamHeader::SIZE] = {};
+	in.peek(bytes, StreamHeader::SIZE);
+
+	StreamHeader header;
+	if (!header.deserialize(bytes))
+		return std::make_unique<AdaptiveScalingCoder>(options.printProgress);	// legacy stream
+
+	switch (header.format)
+	{
+	case StreamFormat::BlockContainer:
+		return std::make_unique<BlockCoder>([]() { return std::make_unique<AnyFormatDecoder>(); }, options.threads);
+	case StreamFormat::Order1:
+		return std::make_unique<Order1Coder>(options.printProgress);
+	case StreamFormat::PPM:
+		return std::make_unique<PPMCoder>(PPMCoder::DEFAULT_ORDER, PPMCoder::DEFAULT_MEMORY, options.printProgress);
+	case StreamFormat::Binary:
+		return std::make_unique<BinaryCoder>(options.printProgress);
+	case StreamFormat::ContextMixing:
+		return std::make_unique<ContextMixingCoder>(ContextMixingCoder::DEFAULT_MEMORY, options.printProgress);
+	case StreamFormat::Static:
+		return std::make_unique<StaticCoder>(options.threads, options.printProgress);
+	case StreamFormat::Rans:
+		return std::make_unique<RansCoder>(RansCoder::DEFAULT_STATES, options.printProgress);
+	case StreamFormat::Interleaved:
+		return std::make_unique<InterleavedCoder>(InterleavedCoder::DEFAULT_STREAMS, options.printProgress);
+	case StreamFormat::Lz:
+		return std::make_unique<LzCoder>(LzCoder::DEFAULT_WINDOW_BITS, options.printProgress);
+	case StreamFormat::Bwt:
+		return std::make_unique<BwtCoder>(BwtCoder::DEFAULT_BLOCK_SIZE, options.printProgress);
+	case StreamFormat::RunLength:
+		return std::make_unique<RunLengthCoder>(options.printProgress);
+	default:
+		return std::make_unique<AdaptiveScalingCoder>(options.printProgress);
+	}
+}
+
+void decodeRange(ByteReader& in, ByteSink& out, uint64_t offset, uint64_t length, const CodecOptions& options)
+{
+	std::unique_ptr<ArithmeticCoder> coder = makeDecoder(in, options);
+
+	BlockCoder* blockCoder = dynamic_cast<BlockCoder*>(coder.get());
+	if (blockCoder != nullptr && in.seekable())
+	{
+		blockCoder->decodeRange(in, out, offset, length);
+		return;
+	}
+
+	RangeSink range(out, offset, length);
+	coder->decode(in, range);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "ArithmeticCoder.hpp"
+#include "StreamHeader.hpp"
+
+#include <memory>
+
+// Model of a single stream.
+enum class ModelType
+{
+	Order0,		// AdaptiveScalingCoder
+	Order1,		// Order1Coder
+	PPM,		// PPMCoder
+	Binary,		// BinaryCoder
+	ContextMixing,	// ContextMixingCoder
+	Static,		// StaticCoder
+	Rans,		// RansCoder
+	Lz,			// LzCoder
+	Bwt			// BwtCoder
+};
+
+// What the user asked for when encoding. Decoding takes the format
+// from the data, only the execution options (threads) are used.
+struct CodecOptions
+{
+	ModelType model = ModelType::Order0;
+	IntervalArithmetic arithmetic = IntervalArithmetic::Integer;	// floating-point only for Order0
+	int ppmOrder = 4;
+	size_t modelMemory = 64 << 20;	// PPM and ContextMixing, bytes (per thread in block mode)
+	int ransStates = 4;
+	int lzWindowBits = 20;		// log2 of the LZ window
+	size_t bwtBlockSize = 1 << 20;	// block of the BWT, not of the block mode
+	int streams = 1;			// Order0 interleaved in 2, 4 or 8 streams (see InterleavedCoder)
+	bool runs = false;			// Order0 with runs of a byte coded as their length (see RunLengthCoder)
+	unsigned threads = 1;		// Static without blocks: threads of the counting pass
+	size_t blockSize = 0;		// 0 means a single stream without blocks
+	bool printProgress = false;	// single stream only
+};
+
+// Creates the coder producing the format described by options.
+std::unique_ptr<ArithmeticCoder> makeEncoder(const CodecOptions& options);
+
+// Peeks the header of encoded data and creates the coder for its format.
+// The same reader must be passed to decode() afterwards.
+std::unique_ptr<ArithmeticCoder> makeDecoder(ByteReader& in, const CodecOptions& options);
+
+// Decodes only original bytes [offset, offset + length). Block containers in
+// seekable sources are decoded partially using their index, anything else
+// is decoded from the beginning and the rest is dropped.
+void decodeRange(ByteReader& in, ByteSink& out, uint64_t offset, uint64_t length, const CodecOptions& options);
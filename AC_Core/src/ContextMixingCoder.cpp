@@ -0,0 +1,118 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#include "ContextMixingCoder.hpp"
+
+#include <stdexcept>
+
+ContextMixingCoder::ContextMixingCoder(size_t memoryLimit, bool printProgress)
+	: memoryBits(0), printProgress(printProgress)
+{
+	while (memoryBits < ContextMixingModel::MAX_MEMORY_BITS && (size_t(2) << memoryBits) <= memoryLimit)
+		memoryBits++;
+	if (memoryBits < ContextMixingModel::MIN_MEMORY_BITS)
+		throw std::invalid_argument("context mixing memory must be at least 1 MiB");
+}
+
+Statistics ContextMixingCoder::encode(ByteSource& in, ByteSink& out)
+{
+	Encoder encoder(out, memoryBits);
+	return encodeWith(in, encoder, printProgress);
+}
+
+void ContextMixingCoder::decode(ByteSource& in, ByteSink& out)
+{
+	Decoder decoder(out);
+	decodeWith(in, decoder, printProgress);
+}
+
+ContextMixingCoder::Encoder::Encoder(ByteSink& sink, int memoryBits)
+	: sink(sink), out(sink), range(out), model(memoryBits), stats(256)
+{
+	StreamHeader header;
+	header.format = StreamFormat::ContextMixing;
+	uint8_t bytes[StreamHeader::SIZE];
+	header.serialize(bytes);
+	for (uint8_t byte : bytes)
+		out.put(byte);
+	out.put((uint8_t)memoryBits);
+}
+
+Statistics ContextMixingCoder::Encoder::finish()
+{
+	if (!finished)
+	{
+		range.encodeRare(1, END_SHIFT);
+		range.finish();
+		out.flush();
+		sink.flush();
+		finished = true;
+	}
+	return Statistics(stats);
+}
+
+ContextMixingCoder::Decoder::Decoder(ByteSink& sink)
+	: out(sink)
+{
+}
+
+void ContextMixingCoder::Decoder::feed(const uint8_t* data, size_t size)
+{
+	if (endOfStream || input.isFinished())
+		return;		// everything after the end is ignored
+
+	input.feed(data, size);
+	decodeAvailable();
+	out.flush();
+}
+
+void ContextMixingCoder::Decoder::finish()
+{
+	if (endOfStream || input.isFinished())
+		return;
+
+	input.finish(StreamHeader::SIZE + PARAMETERS_SIZE + MAX_BYTES_PER_SYMBOL);
+	decodeAvailable();
+	out.flush();
+
+	if (!endOfStream)
+		throw std::runtime_error("encoded data is truncated or corrupted");
+}
+
+void ContextMixingCoder::Decoder::decodeAvailable()
+{
+	const uint8_t* in = input.begin();
+	const uint8_t* end = input.end();
+
+	if (!model)
+	{
+		if (end - in < StreamHeader::SIZE + PARAMETERS_SIZE + RangeDecoder::START_BYTES)
+			return;
+
+		StreamHeader header;
+		if (!header.deserialize(in) || header.format != StreamFormat::ContextMixing)
+			throw std::runtime_error("data was encoded in a different format");
+		in += StreamHeader::SIZE;
+		model = std::make_unique<ContextMixingModel>(*in++);	// throws on invalid memory
+		range.start(in);
+	}
+
+	while (!endOfStream && end - in >= (ptrdiff_t)MAX_BYTES_PER_SYMBOL)
+	{
+		if (range.decodeRare(END_SHIFT, in)) {
+			endOfStream = true;
+			break;
+		}
+
+		uint32_t byte = 0;
+		for (int bit = 0; bit < 8; bit++) {
+			int value = range.decode(BinaryProbability::ONE - model->predictOne(), in);
+			model->update(value);
+			byte = 2 * byte + value;
+		}
+		out.put((uint8_t)byte);
+	}
+
+	input.consume(in);
+}
@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+#include "ArithmeticCoder.hpp"
+#include "ContextMixingModel.hpp"
+#include "RangeCoder.hpp"
+#include "Statistics.hpp"
+#include "StreamHeader.hpp"
+
+#include <vector>
+
+// The best and the slowest coder: bits are predicted by ContextMixingModel
+// and coded with the range coder of BinaryCoder (the end of data is marked
+// the same way too).
+//
+// The memory of the model is stored after the stream header:
+//
+//   byte 4: log2 of memory in bytes
+class ContextMixingCoder : public ArithmeticCoder
+{
+public:
+	static constexpr int END_SHIFT = 16;
+	static constexpr int PARAMETERS_SIZE = 1;
+	static constexpr size_t MAX_BYTES_PER_SYMBOL = 9 * RangeDecoder::MAX_BYTES_PER_BIT;
+	static constexpr size_t DEFAULT_MEMORY = 64 << 20;
+
+	class Encoder;
+	class Decoder;
+
+	// Memory is rounded down to a power of two. Decoding ignores it, as it is read from the data.
+	ContextMixingCoder(size_t memoryLimit = DEFAULT_MEMORY, bool printProgress = false);
+	using ArithmeticCoder::encode;
+	using ArithmeticCoder::decode;
+
+	Statistics encode(ByteSource& in, ByteSink& out) override;
+	void decode(ByteSource& in, ByteSink& out) override;
+
+private:
+	int memoryBits;
+	bool printProgress;
+};
+
+// Push-based encoder. Every bit is coded with the mixed prediction, and the
+// model learns from it before the next one.
+class ContextMixingCoder::Encoder
+{
+public:
+	Encoder(ByteSink& sink, int memoryBits);
+
+	void feed(const uint8_t* data, size_t size)
+	{
+		if (finished)
+			throw std::logic_error("cannot feed finished encoder");
+
+		for (size_t i = 0; i < size; i++)
+		{
+			range.encodeRare(0, END_SHIFT);
+
+			for (int bit = 7; bit >= 0; bit--) {
+				int value = (data[i] >> bit) & 1;
+				range.encode(value, BinaryProbability::ONE - model.predictOne());
+				model.update(value);
+			}
+
+			// for statistics purposes
+			stats[data[i]].readCounter += 8;
+			stats[data[i]].writeCounter += 8 * (range.bytesWritten() - statsWritten);
+			statsWritten = range.bytesWritten();
+		}
+	}
+
+	Statistics finish();	// encodes the end and flushes the sink
+
+private:
+	ByteSink& sink;
+	ByteWriter out;
+	RangeEncoder range;
+	ContextMixingModel model;
+	std::vector<BitStat> stats;
+	uint64_t statsWritten = 0;
+	bool finished = false;
+};
+
+// Push-based decoder. The model is created when the header gives its
+// memory, and a byte is decoded only when MAX_BYTES_PER_SYMBOL bytes are fed.
+class ContextMixingCoder::Decoder
+{
+public:
+	Decoder(ByteSink& sink);
+
+	void feed(const uint8_t* data, size_t size);
+	void finish();		// no more data: decodes the rest, throws if the end is missing
+	bool done() const { return endOfStream; }
+
+private:
+	ByteWriter out;
+	RangeDecoder range;
+	std::unique_ptr<ContextMixingModel> model;
+	RangeDecoderInput input;
+	bool endOfStream = false;
+
+	void decodeAvailable();
+};
@@ -0,0 +1,161 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#include "ContextMixingModel.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <stdexcept>
+
+int16_t ContextMixingModel::stretchTable[4096];
+uint16_t ContextMixingModel::squashTable[4095];
+int32_t ContextMixingModel::reciprocalTable[COUNTER_LIMIT + 1];
+
+ContextMixingModel::ContextMixingModel(int memoryBits)
+{
+	if (memoryBits < MIN_MEMORY_BITS || memoryBits > MAX_MEMORY_BITS)
+		throw std::invalid_argument("context mixing memory must be between 1 MiB and 2 GiB");
+
+	static std::once_flag tablesReady;
+	std::call_once(tablesReady, initializeTables);
+
+	// every hashed table takes 1/8 of memory
+	hashedBits = memoryBits - 5;
+	for (auto& table : hashed) {
+		table.reset(new uint32_t[size_t(1) << hashedBits]);
+		std::fill(table.get(), table.get() + (size_t(1) << hashedBits), NEW_COUNTER);
+	}
+
+	// history and its index take 1/4 each
+	historyMask = (uint32_t)((size_t(1) << (memoryBits - 2)) - 1);
+	history.reset(new uint8_t[size_t(historyMask) + 1]());
+	matchIndexBits = memoryBits - 4;
+	matchIndex.reset(new uint32_t[size_t(1) << matchIndexBits]());
+
+	std::fill(order0, order0 + 256, NEW_COUNTER);
+	order1.reset(new uint32_t[65536]);
+	std::fill(order1.get(), order1.get() + 65536, NEW_COUNTER);
+	for (auto& counters : matchCounters) {
+		counters[0] = NEW_COUNTER;
+		counters[1] = NEW_COUNTER;
+	}
+
+	weights.reset(new int32_t[WEIGHT_SETS * INPUTS]);
+	for (int set = 0; set < WEIGHT_SETS; set++) {
+		std::fill(&weights[set * INPUTS], &weights[set * INPUTS] + INPUTS - 1, (1 << 16) / 4);
+		weights[set * INPUTS + INPUTS - 1] = 0;
+	}
+	inputs[INPUTS - 1] = 256;	// bias
+
+	for (int context = 0; context < 256; context++)		// no change at first
+		for (int i = 0; i < 33; i++)
+			refinement[context * 33 + i] = (uint16_t)(squash((i - 16) * 128) * 16);
+
+	std::fill(byteHashes, byteHashes + HASHED_ORDERS, 0);
+	selectCounters();
+}
+
+int32_t ContextMixingModel::largestWeight() const
+{
+	int32_t largest = 0;
+	for (int i = 0; i < WEIGHT_SETS * INPUTS; i++)
+		largest = std::max(largest, std::abs(weights[i]));
+	return largest;
+}
+
+// Tables are computed in integers only, so every platform codes the same way.
+void ContextMixingModel::initializeTables()
+{
+	// 4096 / (1 + e^(-x / 256)) for x = -2048, -1920, ..., 2048
+	static const int SAMPLES[33] = {
+		1, 2, 3, 6, 10, 16, 27, 45, 73, 120, 194, 310, 488, 747, 1101, 1546,
+		2047, 2549, 2994, 3348, 3607, 3785, 3901, 3975, 4022, 4050, 4068, 4079, 4085, 4089, 4092, 4093, 4094
+	};
+
+	for (int x = -2047; x <= 2047; x++) {	// linear interpolation between samples
+		int i = (x + 2048) >> 7, w = (x + 2048) & 127;
+		int p = (SAMPLES[i] * (128 - w) + SAMPLES[i + 1] * w + 64) >> 7;
+		squashTable[x + 2047] = (uint16_t)std::min(std::max(p, 1), BinaryProbability::ONE - 1);
+	}
+
+	int p = 0;
+	for (int x = -2047; x <= 2047; x++) {	// the smallest x that gives at least p
+		int squashed = squashTable[x + 2047];
+		for (; p <= squashed; p++)
+			stretchTable[p] = (int16_t)x;
+	}
+	for (; p < 4096; p++)
+		stretchTable[p] = 2047;
+
+	for (int n = 0; n <= COUNTER_LIMIT; n++)
+		reciprocalTable[n] = 2 * 65536 / (2 * n + 3);
+}
+
+void ContextMixingModel::endOfByte()
+{
+	uint8_t byte = (uint8_t)partial;
+	partial = 1;
+	bitsSeen = 0;
+
+	history[position & historyMask] = byte;
+	position++;
+	lastBytes = (lastBytes << 8) | byte;
+
+	// hashes of orders 2, 3 and 4, different for every order
+	for (int k = 0; k < HASHED_ORDERS; k++) {
+		uint32_t context = (uint32_t)(lastBytes & ((uint64_t(1) << (8 * (k + 2))) - 1));
+		byteHashes[k] = (context + (uint32_t)k * 0x3C6EF372u) * 0x9E3779B1u;
+	}
+
+	// follow the match or look for a new one
+	if (matchLength > 0 && history[matchPointer & historyMask] == byte) {
+		matchPointer++;
+		if (matchLength < MAX_MATCH)
+			matchLength++;
+	}
+	else
+		matchLength = 0;
+
+	if (position >= MIN_MATCH)
+	{
+		uint64_t context = lastBytes & ((uint64_t(1) << (8 * MIN_MATCH)) - 1);
+		uint32_t& indexed = matchIndex[(context * 0x9E3779B97F4A7C15ull) >> (64 - matchIndexBits)];
+		if (matchLength == 0 && indexed != 0 && position - indexed <= historyMask)
+		{
+			uint32_t length = 0;	// verify the candidate (the index has collisions)
+			while (length < MAX_MATCH && length < indexed
+				&& history[(indexed - 1 - length) & historyMask] == history[(position - 1 - length) & historyMask])
+				length++;
+			if (length >= MIN_MATCH) {
+				matchPointer = indexed;
+				matchLength = length;
+			}
+		}
+		indexed = position;
+	}
+}
+
+void ContextMixingModel::selectCounters()
+{
+	counters[0] = &order0[partial];
+	counters[1] = &order1[(lastBytes & 0xFF) << 8 | partial];
+	for (int k = 0; k < HASHED_ORDERS; k++)
+		counters[2 + k] = &hashed[k][((byteHashes[k] + partial) * 0x9E3779B1u) >> (32 - hashedBits)];
+
+	// the match predicts only while the expected byte agrees with the bits seen
+	int matchState = 0;
+	counters[INPUTS - 2] = nullptr;
+	if (matchLength > 0)
+	{
+		uint32_t expected = history[matchPointer & historyMask] | 0x100;
+		if ((expected >> (8 - bitsSeen)) == partial) {
+			int expectedBit = (expected >> (7 - bitsSeen)) & 1;
+			counters[INPUTS - 2] = &matchCounters[matchLength][expectedBit];
+			matchState = matchLength < 16 ? 1 : 2;
+		}
+	}
+
+	selectedWeights = &weights[(matchState * 256 + partial) * INPUTS];
+}
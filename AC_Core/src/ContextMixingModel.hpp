@@ -0,0 +1,156 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+#include "RangeCoder.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+
+// Context mixing model of bits: the probability of the next bit is a mix of
+// the predictions of several models, each looking at a different context.
+//
+//  - order 0 and order 1: direct tables of probabilities,
+//  - orders 2, 3 and 4: hashed tables (collisions are not detected),
+//  - match model: the bit that followed the last occurrence of the
+//    previous MIN_MATCH bytes, if they occurred before.
+//
+// Predictions are mixed in the logistic domain, ln(p / (1 - p)), with
+// weights trained online to minimize the coding cost (a single neuron).
+// Weights are selected by the bits of the current byte seen so far and by
+// the length of the match. The mixed prediction is finally refined by what
+// was really coded after similar predictions in the same order-0 context.
+//
+// Memory usage is fixed: 3/8 of it for the hashed tables and 1/2 for the
+// match model (history and its index).
+//
+// Usage for every bit: p = predictOne(), code the bit, update(bit).
+class ContextMixingModel
+{
+public:
+	static constexpr int MIN_MEMORY_BITS = 20;	// 1 MiB
+	static constexpr int MAX_MEMORY_BITS = 31;	// 2 GiB
+	static constexpr int MIN_MATCH = 6;
+
+	ContextMixingModel(int memoryBits);
+
+	// Probability that the next bit is '1', in 1..ONE-1 (see BinaryProbability).
+	inline uint32_t predictOne();
+
+	inline void update(int bit);
+
+	int32_t largestWeight() const;	// magnitude of the largest mixer weight
+
+private:
+	static constexpr int INPUTS = 7;			// orders 0-4, match, bias
+	static constexpr int WEIGHT_SETS = 256 * 3;	// partial byte x match state
+	static constexpr int COUNTER_LIMIT = 255;
+	static constexpr int LEARNING_RATE = 4;
+	static constexpr int32_t MAX_WEIGHT = 1 << 20;	// 16.0, keeps every input * weight in 32 bits
+	static constexpr int MAX_MATCH = 64;
+	static constexpr int HASHED_ORDERS = 3;
+
+	// Counters: probability of '1' in the upper 22 bits, number of updates
+	// (up to COUNTER_LIMIT) in the lower 10 bits. A counter adapts fast when
+	// it is new and gets more stable with every update.
+	static constexpr uint32_t NEW_COUNTER = 1u << 31;
+	uint32_t order0[256];
+	std::unique_ptr<uint32_t[]> order1;			// 65536
+	std::unique_ptr<uint32_t[]> hashed[HASHED_ORDERS];
+	int hashedBits;
+
+	// match model
+	std::unique_ptr<uint8_t[]> history;
+	uint32_t historyMask;
+	std::unique_ptr<uint32_t[]> matchIndex;	// hash of MIN_MATCH bytes -> position after them
+	int matchIndexBits;
+	uint32_t position = 0;		// number of bytes seen
+	uint32_t matchPointer = 0;	// the byte expected next is history[matchPointer]
+	uint32_t matchLength = 0;	// 0 if there is no match
+	uint32_t matchCounters[MAX_MATCH + 1][2];	// by length and expected bit
+
+	// mixer
+	std::unique_ptr<int32_t[]> weights;
+	int32_t* selectedWeights;
+	int32_t inputs[INPUTS];
+	uint32_t mixed;				// prediction of the mixer (12 bits)
+
+	// Final refinement of the prediction in the order-0 context (secondary
+	// estimation): a curve that maps the mixed prediction, 33 points per context.
+	static constexpr int REFINEMENT_SHIFT = 7;
+	uint16_t refinement[256 * 33];
+	uint16_t* refinementPoint;	// the point closer to the last prediction
+
+	// context
+	uint32_t partial = 1;		// bits of the current byte with a leading '1'
+	int bitsSeen = 0;
+	uint64_t lastBytes = 0;
+	uint32_t byteHashes[HASHED_ORDERS];
+	uint32_t* counters[INPUTS - 1];		// counters of the current bit (match: nullptr if none)
+
+	static int16_t stretchTable[4096];
+	static uint16_t squashTable[4095];
+	static int32_t reciprocalTable[COUNTER_LIMIT + 1];	// 2^16 / (n + 1.5)
+
+	// ln(p / (1 - p)) for p in 12 bits, scaled by 256 and limited to +-2047
+	static int stretch(uint32_t p) { return stretchTable[p]; }
+
+	// inverse of stretch(), in 1..ONE-1
+	static uint32_t squash(int x) { return squashTable[std::min(std::max(x, -2047), 2047) + 2047]; }
+	static void initializeTables();
+
+	void endOfByte();
+	void selectCounters();
+};
+
+inline uint32_t ContextMixingModel::predictOne()
+{
+	for (int i = 0; i < INPUTS - 2; i++)
+		inputs[i] = stretch(*counters[i] >> 20);
+	inputs[INPUTS - 2] = counters[INPUTS - 2] != nullptr ? stretch(*counters[INPUTS - 2] >> 20) : 0;
+
+	int64_t dot = 0;
+	for (int i = 0; i < INPUTS; i++)
+		dot += (int64_t)inputs[i] * selectedWeights[i];
+
+	mixed = squash((int)(dot >> 16));
+
+	int x = stretch(mixed) + 2048;
+	int weight = x & 127;
+	uint16_t* point = &refinement[partial * 33 + (x >> 7)];
+	uint32_t refined = (point[0] * (128 - weight) + point[1] * weight) >> 11;
+	refinementPoint = point + (weight >> 6);
+
+	uint32_t p = (mixed + 3 * refined) / 4;
+	return std::min<uint32_t>(std::max<uint32_t>(p, 1), BinaryProbability::ONE - 1);
+}
+
+inline void ContextMixingModel::update(int bit)
+{
+	// train the mixer: gradient of the coding cost
+	int error = ((bit << 12) - (int)mixed) * LEARNING_RATE;
+	// on constant data the error never reaches 0, so weights are limited
+	for (int i = 0; i < INPUTS; i++)
+		selectedWeights[i] = std::min(std::max(selectedWeights[i] + ((inputs[i] * error + (1 << 12)) >> 13), -MAX_WEIGHT), MAX_WEIGHT);
+
+	*refinementPoint += ((bit ? 0xFFFF : 0) - *refinementPoint) >> REFINEMENT_SHIFT;
+
+	int32_t target = bit ? (1 << 22) - 1 : 0;
+	for (int i = 0; i < INPUTS - 1; i++)
+	{
+		if (counters[i] == nullptr)
+			continue;
+		uint32_t& counter = *counters[i];
+		uint32_t n = counter & 1023;
+		int32_t p = (int32_t)(counter >> 10);
+		p += (int32_t)(((int64_t)(target - p) * reciprocalTable[n]) >> 16);
+		counter = (uint32_t)p << 10 | (n < COUNTER_LIMIT ? n + 1 : n);
+	}
+
+	partial = 2 * partial + bit;
+	if (++bitsSeen == 8)
+		endOfByte();
+	selectCounters();
+}
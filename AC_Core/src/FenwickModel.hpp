@@ -0,0 +1,142 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+
+#include "SimdKernels.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+// Adaptive frequency model backed by a binary indexed (Fenwick) tree.
+//
+// It keeps exactly the same frequencies as AdaptiveModel, so both models
+// produce identical intervals, but a cumulative frequency lookup and
+// an update cost O(log n) instead of rebuilding the whole table.
+// Frequencies and tree nodes share one contiguous array of 32-bit counters.
+//
+// Symbols are not bounds-checked here. It is the hot path of the coder
+// and callers are responsible for passing symbols from [0, size()).
+class FenwickModel
+{
+public:
+	FenwickModel(size_t numberOfSymbols, size_t maxTotalFrequency)
+		: numberOfSymbols(numberOfSymbols),
+		counters(new uint32_t[2 * numberOfSymbols + 1]),
+		MAX_TOTAL_FREQUENCY(maxTotalFrequency)
+	{
+		if (maxTotalFrequency > std::numeric_limits<uint32_t>::max())
+			throw std::invalid_argument("max frequency does not fit in 32-bit counters");
+
+		frequencies = counters.get();
+		tree = counters.get() + numberOfSymbols;	// tree[1..n] (tree[0] is unused)
+
+		highestStep = 1;
+		while (highestStep * 2 <= numberOfSymbols)
+			highestStep *= 2;
+
+		reset();
+	}
+
+	void reset()
+	{
+		for (size_t i = 0; i < numberOfSymbols; i++)
+			frequencies[i] = 1u;	// initially every byte is marked as 'appeared once'
+
+		totalFrequencyCounter = numberOfSymbols;
+
+		if (totalFrequencyCounter >= MAX_TOTAL_FREQUENCY)
+			throw std::invalid_argument("max frequency is too low to fit that number of symbols");
+
+		buildTree();
+	}
+
+	void update(size_t symbol)
+	{
+		if (totalFrequencyCounter >= MAX_TOTAL_FREQUENCY) {		// Check if frequency counter reaches max
+			// If so, halve all counts (keeping them positive) and rebuild the tree.
+			totalFrequencyCounter = (size_t)SimdKernels::halve(frequencies, numberOfSymbols);
+			buildTree();
+		}
+
+		frequencies[symbol]++;
+		totalFrequencyCounter++;
+
+		for (size_t i = symbol + 1; i <= numberOfSymbols; i += lowestBit(i))
+			tree[i]++;
+	}
+
+	size_t frequencyBegin(size_t symbol) const
+	{
+		size_t sum = 0;		// sum of frequencies of symbols [0, symbol)
+		for (size_t i = symbol; i > 0; i -= lowestBit(i))
+			sum += tree[i];
+		return sum;
+	}
+
+	size_t frequencyEnd(size_t symbol) const
+	{
+		return frequencyBegin(symbol) + frequencies[symbol];
+	}
+
+	// Returns the symbol for which frequencyBegin(symbol) <= count < frequencyEnd(symbol).
+	// Walks down the tree, so it takes O(log n) integer compares.
+	size_t findSymbol(size_t count) const
+	{
+		size_t position = 0;
+		for (size_t step = highestStep; step > 0; step >>= 1)
+		{
+			size_t next = position + step;
+			if (next <= numberOfSymbols && tree[next] <= count) {
+				position = next;
+				count -= tree[next];
+			}
+		}
+		return position;	// number of symbols that end at or before 'count'
+	}
+
+	size_t frequency(size_t symbol) const
+	{
+		return frequencies[symbol];
+	}
+
+	size_t totalFrequency() const
+	{
+		return totalFrequencyCounter;
+	}
+
+	size_t size() const
+	{
+		return numberOfSymbols;
+	}
+
+private:
+	const size_t numberOfSymbols;
+	std::unique_ptr<uint32_t[]> counters;	// [ frequencies (n) | unused | tree (n) ]
+	uint32_t* frequencies;
+	uint32_t* tree;
+	size_t highestStep;		// the largest power of 2 not greater than numberOfSymbols
+
+	size_t totalFrequencyCounter;	// total number of symbols appearance.
+	const size_t MAX_TOTAL_FREQUENCY;
+
+	static size_t lowestBit(size_t i)
+	{
+		return i & (~i + 1);
+	}
+
+	void buildTree()	// O(n) construction from plain frequencies
+	{
+		for (size_t i = 1; i <= numberOfSymbols; i++)
+			tree[i] = frequencies[i - 1];
+
+		for (size_t i = 1; i <= numberOfSymbols; i++) {
+			size_t parent = i + lowestBit(i);
+			if (parent <= numberOfSymbols)
+				tree[parent] += tree[i];
+		}
+	}
+};
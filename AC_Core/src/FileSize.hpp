@@ -1,11 +0,0 @@
-#pragma once
-
-#include <sys/stat.h>
-#include <string>
-
-long getFileSize(std::string filename)
-{
-	struct stat stat_buf;
-	int rc = stat(filename.c_str(), &stat_buf);
-	return rc == 0 ? stat_buf.st_size : -1;
-}
\ No newline at end of file
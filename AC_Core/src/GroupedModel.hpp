@@ -0,0 +1,136 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+
+#include "SimdKernels.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+// Adaptive frequency model for decoders that find a symbol without a
+// binary search. It keeps exactly the same frequencies as AdaptiveModel
+// and FenwickModel, so all of them produce identical intervals.
+//
+// Symbols are split into groups of GROUP_SIZE. The model keeps where every
+// group starts and, inside a group, where every symbol ends. A symbol is then
+// found by vectorized comparisons (SimdKernels::upperBoundShort): of the count
+// with the starts of all groups and of the rest with the ends in one group.
+// None of them branches on the data, so unlike a binary search or a walk
+// down a Fenwick tree the processor has nothing to mispredict. An update
+// increments the ends in one group and the starts of the following groups,
+// again with vector instructions and masks instead of loops of varying length.
+//
+// Symbols are not bounds-checked here, like in FenwickModel.
+class GroupedModel
+{
+public:
+	static constexpr size_t GROUP_SIZE = 16;
+
+	GroupedModel(size_t numberOfSymbols, size_t maxTotalFrequency)
+		: numberOfSymbols(numberOfSymbols),
+		numberOfGroups((numberOfSymbols + GROUP_SIZE - 1) / GROUP_SIZE),
+		frequencies(numberOfSymbols),
+		ends(numberOfGroups * GROUP_SIZE, PADDING),
+		groupStarts((numberOfGroups + 3) / 4 * 4, PADDING),
+		MAX_TOTAL_FREQUENCY(maxTotalFrequency)
+	{
+		if (maxTotalFrequency >= PADDING)
+			throw std::invalid_argument("max frequency does not fit in 32-bit counters");
+
+		reset();
+	}
+
+	void reset()
+	{
+		std::fill(frequencies.begin(), frequencies.end(), 1u);	// initially every symbol is marked as 'appeared once'
+		totalFrequencyCounter = numberOfSymbols;
+
+		if (totalFrequencyCounter >= MAX_TOTAL_FREQUENCY)
+			throw std::invalid_argument("max frequency is too low to fit that number of symbols");
+
+		rebuild();
+	}
+
+	void update(size_t symbol)
+	{
+		if (totalFrequencyCounter >= MAX_TOTAL_FREQUENCY) {		// Check if frequency counter reaches max
+			// If so, halve all counts (keeping them positive).
+			totalFrequencyCounter = (size_t)SimdKernels::halve(frequencies.data(), numberOfSymbols);
+			rebuild();
+		}
+
+		frequencies[symbol]++;
+		totalFrequencyCounter++;
+
+		int group = (int)(symbol / GROUP_SIZE);
+		int first = group * (int)GROUP_SIZE;
+		SimdKernels::increment(&ends[first], GROUP_SIZE, (int)symbol - first, (int)numberOfSymbols - first);
+		int from = (group + 1) & ~3;	// starts of the following groups, from a multiple of 4 (may be the end)
+		SimdKernels::increment(groupStarts.data() + from, groupStarts.size() - from, group + 1 - from, (int)numberOfGroups - from);
+	}
+
+	size_t frequencyBegin(size_t symbol) const
+	{
+		return groupStarts[symbol / GROUP_SIZE] + ends[symbol] - frequencies[symbol];
+	}
+
+	size_t frequencyEnd(size_t symbol) const
+	{
+		return groupStarts[symbol / GROUP_SIZE] + ends[symbol];
+	}
+
+	// Returns the symbol for which frequencyBegin(symbol) <= count < frequencyEnd(symbol).
+	size_t findSymbol(size_t count) const
+	{
+		// the first group starts at 0, so at least one start is <= count
+		size_t group = SimdKernels::upperBoundShort(groupStarts.data(), groupStarts.size(), (uint32_t)count) - 1;
+
+		uint32_t inGroup = (uint32_t)(count - groupStarts[group]);
+		return group * GROUP_SIZE + SimdKernels::upperBoundShort(&ends[group * GROUP_SIZE], GROUP_SIZE, inGroup);
+	}
+
+	size_t frequency(size_t symbol) const
+	{
+		return frequencies[symbol];
+	}
+
+	size_t totalFrequency() const
+	{
+		return totalFrequencyCounter;
+	}
+
+	size_t size() const
+	{
+		return numberOfSymbols;
+	}
+
+private:
+	static constexpr uint32_t PADDING = std::numeric_limits<uint32_t>::max();	// greater than any count
+
+	const size_t numberOfSymbols;
+	const size_t numberOfGroups;
+	std::vector<uint32_t> frequencies;
+	std::vector<uint32_t> ends;			// inclusive prefix sums within groups; the last group is padded
+	std::vector<uint32_t> groupStarts;	// sum of frequencies of the previous groups; padded to a multiple of 4
+
+	size_t totalFrequencyCounter;	// total number of symbols appearance.
+	const size_t MAX_TOTAL_FREQUENCY;
+
+	void rebuild()
+	{
+		std::copy(frequencies.begin(), frequencies.end(), ends.begin());
+		uint32_t start = 0;
+		for (size_t g = 0; g < numberOfGroups; g++)
+		{
+			size_t groupSize = std::min(GROUP_SIZE, numberOfSymbols - g * GROUP_SIZE);
+			SimdKernels::prefixSum(&ends[g * GROUP_SIZE], groupSize);
+			groupStarts[g] = start;
+			start += ends[g * GROUP_SIZE + groupSize - 1];
+		}
+	}
+};
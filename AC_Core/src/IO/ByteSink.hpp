@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <vector>
+
+// Destination of bytes for coders and BitWriter.
+// Bytes are always passed in blocks, never one by one.
+class ByteSink
+{
+public:
+	virtual void write(const uint8_t* data, size_t size) = 0;
+	virtual void flush() {}
+
+	virtual ~ByteSink() = default;
+};
+
+// Sink appending bytes to a caller-provided vector.
+class MemorySink : public ByteSink
+{
+public:
+	MemorySink(std::vector<uint8_t>& output)
+		: m_output(output) {}
+
+	void write(const uint8_t* data, size_t size) override
+	{
+		m_output.insert(m_output.end(), data, data + size);
+	}
+
+private:
+	std::vector<uint8_t>& m_output;
+};
+
+// Passes on only the bytes in [offset, offset + length) of everything written.
+class RangeSink : public ByteSink
+{
+public:
+	RangeSink(ByteSink& sink, uint64_t offset, uint64_t length)
+		: m_sink(sink), m_begin(offset), m_end(offset + length) {}
+
+	void write(const uint8_t* data, size_t size) override
+	{
+		uint64_t begin = std::max(m_begin, m_position);
+		uint64_t end = std::min(m_end, m_position + size);
+		if (begin < end)
+			m_sink.write(data + (begin - m_position), (size_t)(end - begin));
+		m_position += size;
+	}
+
+	void flush() override { m_sink.flush(); }
+
+private:
+	ByteSink& m_sink;
+	uint64_t m_begin;
+	uint64_t m_end;
+	uint64_t m_position = 0;
+};
+
+// Collects single bytes and passes them to a sink in big blocks.
+class ByteWriter
+{
+public:
+	ByteWriter(ByteSink& sink, size_t bufferSize = 64 * 1024)
+		: m_sink(sink), m_buffer(bufferSize) {}
+
+	inline void put(uint8_t byte)
+	{
+		if (m_size == m_buffer.size())
+			flush();
+		m_buffer[m_size++] = byte;
+	}
+
+	void fill(uint8_t byte, uint64_t count)		// the same byte count times
+	{
+		while (count > 0)
+		{
+			if (m_size == m_buffer.size())
+				flush();
+			size_t chunk = (size_t)std::min<uint64_t>(count, m_buffer.size() - m_size);
+			std::fill_n(m_buffer.begin() + m_size, chunk, byte);
+			m_size += chunk;
+			count -= chunk;
+		}
+	}
+
+	void flush()
+	{
+		if (m_size > 0)
+			m_sink.write(m_buffer.data(), m_size);
+		m_size = 0;
+	}
+
+	~ByteWriter()
+	{
+		// when unwinding from an error the sink may throw again or be gone already
+		if (std::uncaught_exceptions() == m_uncaughtExceptions)
+			flush();
+	}
+
+private:
+	ByteSink& m_sink;
+	std::vector<uint8_t> m_buffer;
+	size_t m_size = 0;
+	int m_uncaughtExceptions = std::uncaught_exceptions();
+};
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <vector>
+
+// Source of bytes for coders and BitReader.
+//
+// Data is handed out in chunks, so the coder walks plain pointers and
+// there is only one virtual call per chunk.
+class ByteSource
+{
+public:
+	// Makes the next chunk of data available. Returns its size (0 at the
+	// end of data). The chunk stays valid until the next call.
+	virtual size_t next(const uint8_t*& data) = 0;
+
+	// Total number of bytes or -1 if unknown.
+	virtual long long size() const { return -1; }
+
+	// Random access, independent of next(). Only for seekable sources
+	// (e.g. files and memory, but not pipes). Returns number of bytes copied.
+	virtual bool seekable() const { return false; }
+	virtual size_t readAt(uint64_t, uint8_t*, size_t)
+	{
+		throw std::runtime_error("source is not seekable");
+	}
+
+	virtual ~ByteSource() = default;
+};
+
+// Source reading from a caller-provided memory buffer (no copy is made).
+class MemorySource : public ByteSource
+{
+public:
+	MemorySource(const uint8_t* data, size_t size)
+		: m_data(data), m_size(size) {}
+
+	size_t next(const uint8_t*& data) override
+	{
+		data = m_data;
+		size_t size = m_consumed ? 0 : m_size;
+		m_consumed = true;
+		return size;
+	}
+
+	long long size() const override { return (long long)m_size; }
+
+	bool seekable() const override { return true; }
+	size_t readAt(uint64_t offset, uint8_t* data, size_t size) override
+	{
+		if (offset >= m_size)
+			return 0;
+		size_t count = (size_t)std::min<uint64_t>(size, m_size - offset);
+		std::memcpy(data, m_data + offset, count);
+		return count;
+	}
+
+private:
+	const uint8_t* m_data;
+	size_t m_size;
+	bool m_consumed = false;
+};
+
+// Source fed with chunks of data from outside (push-based coding).
+// It returns 0 whenever it has no data at the moment, so readers must be
+// ready to ask again after more data is pushed.
+class QueueSource : public ByteSource
+{
+public:
+	void push(const uint8_t* data, size_t size)
+	{
+		if (size > 0)
+			m_chunks.emplace_back(data, data + size);
+	}
+
+	size_t next(const uint8_t*& data) override
+	{
+		if (m_chunks.empty())
+			return 0;
+
+		m_current = std::move(m_chunks.front());	// kept alive until the next call
+		m_chunks.pop_front();
+		data = m_current.data();
+		return m_current.size();
+	}
+
+private:
+	std::deque<std::vector<uint8_t>> m_chunks;
+	std::vector<uint8_t> m_current;
+};
+
+// Reads exact numbers of bytes from a source and allows to look ahead.
+// It is a source itself: next() hands out everything not read yet.
+class ByteReader : public ByteSource
+{
+public:
+	ByteReader(ByteSource& source)
+		: m_source(source) {}
+
+	// Copies n bytes. Returns less only at the end of data.
+	size_t read(uint8_t* data, size_t n)
+	{
+		size_t done = 0;
+		while (done < n)
+		{
+			if (m_position == m_size && !fetch())
+				break;
+
+			size_t count = std::min(n - done, m_size - m_position);
+			std::memcpy(data + done, m_chunk + m_position, count);
+			m_position += count;
+			done += count;
+		}
+		return done;
+	}
+
+	// Like read() but the bytes stay available.
+	size_t peek(uint8_t* data, size_t n)
+	{
+		if (m_size - m_position < n)	// join the rest with the next chunks
+		{
+			std::vector<uint8_t> joined(m_chunk + m_position, m_chunk + m_size);
+			const uint8_t* chunk;
+			while (joined.size() < n)
+			{
+				size_t size = m_source.next(chunk);
+				if (size == 0)
+					break;
+				joined.insert(joined.end(), chunk, chunk + size);
+			}
+			m_joined = std::move(joined);
+			m_chunk = m_joined.data();
+			m_position = 0;
+			m_size = m_joined.size();
+		}
+
+		size_t count = std::min(n, m_size - m_position);
+		std::memcpy(data, m_chunk + m_position, count);
+		return count;
+	}
+
+	size_t next(const uint8_t*& data) override
+	{
+		if (m_position == m_size && !fetch())
+			return 0;
+
+		data = m_chunk + m_position;
+		size_t size = m_size - m_position;
+		m_position = m_size;
+		return size;
+	}
+
+	long long size() const override { return m_source.size(); }
+
+	bool seekable() const override { return m_source.seekable(); }
+	size_t readAt(uint64_t offset, uint8_t* data, size_t size) override
+	{
+		return m_source.readAt(offset, data, size);
+	}
+
+private:
+	ByteSource& m_source;
+	const uint8_t* m_chunk = nullptr;
+	size_t m_position = 0;
+	size_t m_size = 0;
+	std::vector<uint8_t> m_joined;	// owns the chunk after peek() crossed chunks
+
+	bool fetch()
+	{
+		m_size = m_source.next(m_chunk);
+		m_position = 0;
+		return m_size > 0;
+	}
+};
@@ -0,0 +1,403 @@
+#include "FileIO.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Thin layer over the system calls, so the classes below are the same on every platform.
+namespace
+{
+#ifdef _WIN32
+	int openForReading(const std::string& path)
+	{
+		return _open(path.c_str(), _O_RDONLY | _O_BINARY);
+	}
+
+	int createForWriting(const std::string& path, bool forMapping)
+	{
+		return _open(path.c_str(), (forMapping ? _O_RDWR : _O_WRONLY) | _O_CREAT | _O_EXCL | _O_BINARY, _S_IREAD | _S_IWRITE);
+	}
+
+	void closeFile(int fd)
+	{
+		_close(fd);
+	}
+
+	long long regularFileSize(int fd)
+	{
+		struct _stat64 stat_buf;
+		if (_fstat64(fd, &stat_buf) != 0 || (stat_buf.st_mode & _S_IFREG) == 0)
+			return -1;
+		return stat_buf.st_size;
+	}
+
+	long long readSome(int fd, uint8_t* data, size_t size)
+	{
+		return _read(fd, data, (unsigned)std::min<size_t>(size, 1 << 30));
+	}
+
+	long long readSomeAt(int fd, uint64_t offset, uint8_t* data, size_t size)
+	{
+		long long position = _lseeki64(fd, 0, SEEK_CUR);
+		if (position < 0 || _lseeki64(fd, (long long)offset, SEEK_SET) < 0)
+			return -1;
+		long long count = readSome(fd, data, size);
+		_lseeki64(fd, position, SEEK_SET);
+		return count;
+	}
+
+	long long writeSome(int fd, const uint8_t* data, size_t size)
+	{
+		return _write(fd, data, (unsigned)std::min<size_t>(size, 1 << 30));
+	}
+
+	bool resizeFile(int fd, uint64_t size)
+	{
+		return _chsize_s(fd, (long long)size) == 0;
+	}
+
+	uint8_t* mapFile(int fd, uint64_t size, bool writable)
+	{
+		HANDLE file = (HANDLE)_get_osfhandle(fd);
+		HANDLE mapping = CreateFileMappingW(file, NULL, writable ? PAGE_READWRITE : PAGE_READONLY,
+			(DWORD)(size >> 32), (DWORD)size, NULL);
+		if (mapping == NULL)
+			return nullptr;
+
+		void* data = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, (SIZE_T)size);
+		CloseHandle(mapping);	// the view keeps the mapping alive
+		return (uint8_t*)data;
+	}
+
+	void unmapFile(uint8_t* data, uint64_t)
+	{
+		UnmapViewOfFile(data);
+	}
+#else
+	int openForReading(const std::string& path)
+	{
+		return open(path.c_str(), O_RDONLY);
+	}
+
+	int createForWriting(const std::string& path, bool forMapping)
+	{
+		return open(path.c_str(), (forMapping ? O_RDWR : O_WRONLY) | O_CREAT | O_EXCL, 0666);
+	}
+
+	void closeFile(int fd)
+	{
+		close(fd);
+	}
+
+	long long regularFileSize(int fd)
+	{
+		struct stat stat_buf;
+		if (fstat(fd, &stat_buf) != 0 || !S_ISREG(stat_buf.st_mode))
+			return -1;
+		return stat_buf.st_size;
+	}
+
+	long long readSome(int fd, uint8_t* data, size_t size)
+	{
+		ssize_t count;
+		do count = read(fd, data, size);
+		while (count < 0 && errno == EINTR);
+		return count;
+	}
+
+	long long readSomeAt(int fd, uint64_t offset, uint8_t* data, size_t size)
+	{
+		ssize_t count;
+		do count = pread(fd, data, size, (off_t)offset);
+		while (count < 0 && errno == EINTR);
+		return count;
+	}
+
+	long long writeSome(int fd, const uint8_t* data, size_t size)
+	{
+		ssize_t count;
+		do count = ::write(fd, data, size);
+		while (count < 0 && errno == EINTR);
+		return count;
+	}
+
+	bool resizeFile(int fd, uint64_t size)
+	{
+		return ftruncate(fd, (off_t)size) == 0;
+	}
+
+	uint8_t* mapFile(int fd, uint64_t size, bool writable)
+	{
+		void* data = mmap(nullptr, (size_t)size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+		if (data == MAP_FAILED)
+			return nullptr;
+		if (!writable)
+			madvise(data, (size_t)size, MADV_SEQUENTIAL);
+		return (uint8_t*)data;
+	}
+
+	void unmapFile(uint8_t* data, uint64_t size)
+	{
+		munmap(data, (size_t)size);
+	}
+#endif
+
+	int openExisting(const std::string& path)
+	{
+		if (!std::filesystem::exists(path))
+			throw std::runtime_error("file does not exists");
+
+		int fd = openForReading(path);
+		if (fd < 0)
+			throw std::runtime_error("Cannot open file");
+		return fd;
+	}
+
+	int createNew(const std::string& path, bool forMapping)
+	{
+		int fd = createForWriting(path, forMapping);
+		if (fd < 0 && errno == EEXIST)
+			throw std::runtime_error("File with this name already exists");
+		if (fd < 0)
+			throw std::runtime_error("Cannot open file");
+		return fd;
+	}
+
+	void writeAll(int fd, const uint8_t* data, size_t size)
+	{
+		while (size > 0)
+		{
+			long long count = writeSome(fd, data, size);
+			if (count <= 0)
+				throw std::runtime_error("Cannot write to file");
+			data += count;
+			size -= (size_t)count;
+		}
+	}
+}
+
+std::unique_ptr<ByteSource> openFileSource(const std::string& path, FileBackend backend)
+{
+	if (backend == FileBackend::Mapped && std::filesystem::is_regular_file(path))
+		return std::make_unique<MappedFileSource>(path);
+	return std::make_unique<FileSource>(path);
+}
+
+std::unique_ptr<ByteSink> createFileSink(const std::string& path, FileBackend backend, uint64_t sizeHint)
+{
+	if (backend == FileBackend::Mapped)
+		return std::make_unique<MappedFileSink>(path, sizeHint);
+	return std::make_unique<FileSink>(path);
+}
+
+FileSource::FileSource(std::string path)
+	: m_fd(openExisting(path)), m_buffer(BUFFER_SIZE)
+{
+	m_fileSize = regularFileSize(m_fd);
+}
+
+FileSource::~FileSource()
+{
+	closeFile(m_fd);
+}
+
+size_t FileSource::next(const uint8_t*& data)
+{
+	long long count = readSome(m_fd, m_buffer.data(), m_buffer.size());
+	if (count < 0)
+		throw std::runtime_error("Cannot read file");
+
+	data = m_buffer.data();
+	return (size_t)count;
+}
+
+size_t FileSource::readAt(uint64_t offset, uint8_t* data, size_t size)
+{
+	size_t total = 0;
+	while (total < size)
+	{
+		long long count = readSomeAt(m_fd, offset + total, data + total, size - total);
+		if (count < 0)
+			throw std::runtime_error("Cannot read file");
+		if (count == 0)
+			break;	// end of file
+		total += (size_t)count;
+	}
+	return total;
+}
+
+MappedFileSource::MappedFileSource(std::string path)
+	: m_fd(openExisting(path))
+{
+	long long size = regularFileSize(m_fd);
+	if (size < 0 || (unsigned long long)size > SIZE_MAX)
+	{
+		closeFile(m_fd);
+		throw std::runtime_error("Cannot map file");
+	}
+	m_size = (size_t)size;
+
+	if (m_size > 0)		// empty files cannot be mapped
+	{
+		m_data = mapFile(m_fd, m_size, false);
+		if (m_data == nullptr)
+		{
+			closeFile(m_fd);
+			throw std::runtime_error("Cannot map file");
+		}
+	}
+}
+
+MappedFileSource::~MappedFileSource()
+{
+	if (m_data != nullptr)
+		unmapFile(m_data, m_size);
+	closeFile(m_fd);
+}
+
+size_t MappedFileSource::next(const uint8_t*& data)
+{
+	if (m_consumed)
+		return 0;
+
+	m_consumed = true;
+	data = m_data;
+	return m_size;
+}
+
+size_t MappedFileSource::readAt(uint64_t offset, uint8_t* data, size_t size)
+{
+	if (offset >= m_size)
+		return 0;
+	size_t count = (size_t)std::min<uint64_t>(size, m_size - offset);
+	std::memcpy(data, m_data + offset, count);
+	return count;
+}
+
+FileSink::FileSink(std::string path)
+	: m_fd(createNew(path, false)), m_buffer(BUFFER_SIZE)
+{
+}
+
+FileSink::~FileSink()
+{
+	try {
+		flush();
+	}
+	catch (const std::runtime_error&) {}	// nothing more can be done here
+	closeFile(m_fd);
+}
+
+void FileSink::write(const uint8_t* data, size_t size)
+{
+	if (m_buffered + size > m_buffer.size())
+		flush();
+
+	if (size >= m_buffer.size())	// big writes bypass the buffer
+	{
+		writeAll(m_fd, data, size);
+		return;
+	}
+
+	std::memcpy(m_buffer.data() + m_buffered, data, size);
+	m_buffered += size;
+}
+
+void FileSink::flush()
+{
+	size_t buffered = m_buffered;
+	m_buffered = 0;
+	writeAll(m_fd, m_buffer.data(), buffered);
+}
+
+MappedFileSink::MappedFileSink(std::string path, uint64_t sizeHint)
+	: m_fd(createNew(path, true))
+{
+	try {
+		reserve(std::max(sizeHint, MIN_CAPACITY));
+	}
+	catch (const std::runtime_error&) {
+		closeFile(m_fd);
+		throw;
+	}
+}
+
+MappedFileSink::~MappedFileSink()
+{
+	if (m_data != nullptr)
+		unmapFile(m_data, m_capacity);
+	resizeFile(m_fd, m_size);	// cut off preallocated space
+	closeFile(m_fd);
+}
+
+void MappedFileSink::write(const uint8_t* data, size_t size)
+{
+	if (m_size + size > m_capacity)
+		reserve(std::max(2 * m_capacity, m_size + size));
+
+	std::memcpy(m_data + m_size, data, size);
+	m_size += size;
+}
+
+void MappedFileSink::reserve(uint64_t capacity)
+{
+	if (m_data != nullptr)
+		unmapFile(m_data, m_capacity);
+	m_data = nullptr;
+
+	if (capacity > SIZE_MAX || !resizeFile(m_fd, capacity))
+		throw std::runtime_error("Cannot allocate space for file");
+
+	m_data = mapFile(m_fd, capacity, true);
+	if (m_data == nullptr)
+		throw std::runtime_error("Cannot map file");
+	m_capacity = capacity;
+}
+
+StandardInputSource::StandardInputSource()
+	: m_buffer(BUFFER_SIZE)
+{
+#ifdef _WIN32
+	_setmode(_fileno(stdin), _O_BINARY);
+#endif
+}
+
+size_t StandardInputSource::next(const uint8_t*& data)
+{
+	data = m_buffer.data();
+	return std::fread(m_buffer.data(), 1, m_buffer.size(), stdin);
+}
+
+StandardOutputSink::StandardOutputSink()
+{
+#ifdef _WIN32
+	_setmode(_fileno(stdout), _O_BINARY);
+#endif
+}
+
+void StandardOutputSink::write(const uint8_t* data, size_t size)
+{
+	if (std::fwrite(data, 1, size, stdout) != size)
+		throw std::runtime_error("Cannot write to standard output");
+}
+
+void StandardOutputSink::flush()
+{
+	std::fflush(stdout);
+}
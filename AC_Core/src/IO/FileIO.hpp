@@ -0,0 +1,130 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ByteSource.hpp"
+#include "ByteSink.hpp"
+
+// How files are read and written. Both backends give coders big chunks
+// of plain memory, so nothing is done per byte outside of the coder loop.
+enum class FileBackend
+{
+	Buffered,	// read()/write() on a file descriptor through a 64 KiB buffer
+	Mapped		// the whole file is mapped into memory (falls back to Buffered for pipes, devices, etc.)
+};
+
+std::unique_ptr<ByteSource> openFileSource(const std::string& path, FileBackend backend = FileBackend::Buffered);
+
+// sizeHint is the expected size of the output. Mapped sink preallocates it and grows if needed.
+std::unique_ptr<ByteSink> createFileSink(const std::string& path, FileBackend backend = FileBackend::Buffered, uint64_t sizeHint = 0);
+
+// Reads a file in big blocks.
+class FileSource : public ByteSource
+{
+public:
+	FileSource(std::string path);
+	~FileSource();
+	FileSource(const FileSource&) = delete;
+	FileSource& operator=(const FileSource&) = delete;
+
+	size_t next(const uint8_t*& data) override;
+	long long size() const override { return m_fileSize; }
+
+	bool seekable() const override { return m_fileSize >= 0; }
+	size_t readAt(uint64_t offset, uint8_t* data, size_t size) override;
+
+private:
+	static constexpr size_t BUFFER_SIZE = 64 * 1024;
+	int m_fd;
+	std::vector<uint8_t> m_buffer;
+	long long m_fileSize;	// -1 if it is not a regular file
+};
+
+// Maps the whole file into memory and gives it away as a single chunk.
+class MappedFileSource : public ByteSource
+{
+public:
+	MappedFileSource(std::string path);
+	~MappedFileSource();
+	MappedFileSource(const MappedFileSource&) = delete;
+	MappedFileSource& operator=(const MappedFileSource&) = delete;
+
+	size_t next(const uint8_t*& data) override;
+	long long size() const override { return (long long)m_size; }
+
+	bool seekable() const override { return true; }
+	size_t readAt(uint64_t offset, uint8_t* data, size_t size) override;
+
+private:
+	int m_fd;
+	uint8_t* m_data = nullptr;
+	size_t m_size;
+	bool m_consumed = false;
+};
+
+// Reads standard input in big blocks (binary mode).
+class StandardInputSource : public ByteSource
+{
+public:
+	StandardInputSource();
+
+	size_t next(const uint8_t*& data) override;
+
+private:
+	static constexpr size_t BUFFER_SIZE = 64 * 1024;
+	std::vector<uint8_t> m_buffer;
+};
+
+// Writes to a new file through a buffer. It refuses to override an existing one.
+class FileSink : public ByteSink
+{
+public:
+	FileSink(std::string path);
+	~FileSink();
+	FileSink(const FileSink&) = delete;
+	FileSink& operator=(const FileSink&) = delete;
+
+	void write(const uint8_t* data, size_t size) override;
+	void flush() override;
+
+private:
+	static constexpr size_t BUFFER_SIZE = 64 * 1024;
+	int m_fd;
+	std::vector<uint8_t> m_buffer;
+	size_t m_buffered = 0;
+};
+
+// Writes to a new file mapped into memory. Space is preallocated and doubled
+// when it runs out; the file is cut to the written size when the sink is destroyed.
+class MappedFileSink : public ByteSink
+{
+public:
+	MappedFileSink(std::string path, uint64_t sizeHint = 0);
+	~MappedFileSink();
+	MappedFileSink(const MappedFileSink&) = delete;
+	MappedFileSink& operator=(const MappedFileSink&) = delete;
+
+	void write(const uint8_t* data, size_t size) override;
+	void flush() override {}
+
+private:
+	static constexpr uint64_t MIN_CAPACITY = 1 << 20;
+	int m_fd;
+	uint8_t* m_data = nullptr;
+	uint64_t m_capacity = 0;
+	uint64_t m_size = 0;
+
+	void reserve(uint64_t capacity);
+};
+
+// Writes to standard output (binary mode).
+class StandardOutputSink : public ByteSink
+{
+public:
+	StandardOutputSink();
+
+	void write(const uint8_t* data, size_t size) override;
+	void flush() override;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include "ByteSource.hpp"
+
+// Fixed-size integers of stream headers and containers are little-endian.
+template <typename T>
+inline void putLittleEndian(uint8_t* bytes, T value)
+{
+	for (size_t i = 0; i < sizeof(T); i++)
+		bytes[i] = (uint8_t)(value >> (8 * i));
+}
+
+template <typename T>
+inline T getLittleEndian(const uint8_t* bytes)
+{
+	T value = 0;
+	for (size_t i = 0; i < sizeof(T); i++)
+		value |= (T)bytes[i] << (8 * i);
+	return value;
+}
+
+// Copies exactly 'size' bytes; the data must not end before.
+inline void readExactly(ByteReader& in, uint8_t* data, size_t size)
+{
+	if (in.read(data, size) != size)
+		throw std::runtime_error("encoded data is truncated or corrupted");
+}
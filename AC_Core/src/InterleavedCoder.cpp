@@ -0,0 +1,205 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#include "InterleavedCoder.hpp"
+#include "FenwickModel.hpp"
+#include "GroupedModel.hpp"
+#include "IntervalCoder.hpp"
+#include "ProgressBar.hpp"
+#include "StreamHeader.hpp"
+#include "BitUtils/BitWriter.hpp"
+#include "BitUtils/BitReader.hpp"
+#include "IO/LittleEndian.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	constexpr uint64_t PRECISION = InterleavedCoder::PRECISION;
+	constexpr size_t MODEL_SIZE = 257;		// bytes and EOF
+	constexpr size_t EOF_SYMBOL = 256;
+	constexpr size_t MODEL_MAX_FREQUENCY = IntervalBounds<PRECISION>::MAX_TOTAL_FREQUENCY;
+	constexpr size_t SLICE = 4096;			// bytes coded between checks for a full segment
+	constexpr size_t MAX_STREAM_SEGMENT = 1 << 30;	// sanity limit for corrupted data
+
+	struct StreamEncoder
+	{
+		std::vector<uint8_t> ready;		// bytes for the next segment
+		MemorySink sink{ ready };
+		BitWriter out{ sink };
+		IntervalEncoder<PRECISION> interval{ out };
+		FenwickModel model{ MODEL_SIZE, MODEL_MAX_FREQUENCY };
+
+		void encode(size_t symbol)
+		{
+			size_t freqBegin = model.frequencyBegin(symbol);
+			interval.encode(freqBegin, freqBegin + model.frequency(symbol), model.totalFrequency());
+			model.update(symbol);
+		}
+	};
+
+	struct StreamDecoder
+	{
+		QueueSource source;
+		BitReader in{ source };
+		IntervalDecoder<PRECISION> interval{ in };
+		GroupedModel model{ MODEL_SIZE, MODEL_MAX_FREQUENCY };	// same frequencies, faster findSymbol()
+		BitBudget<PRECISION> bits;
+	};
+
+	void writeSegment(std::vector<std::unique_ptr<StreamEncoder>>& streams, bool last, ByteSink& out)
+	{
+		std::vector<uint8_t> header(1 + 4 * streams.size());
+		header[0] = last ? 1 : 0;
+		for (size_t k = 0; k < streams.size(); k++)
+			putLittleEndian<uint32_t>(&header[1 + 4 * k], (uint32_t)streams[k]->ready.size());
+		out.write(header.data(), header.size());
+
+		for (auto& stream : streams) {
+			out.write(stream->ready.data(), stream->ready.size());
+			stream->ready.clear();
+		}
+	}
+}
+
+InterleavedCoder::InterleavedCoder(int streams, bool printProgress)
+	: streams(streams), printProgress(printProgress)
+{
+	if (!validStreams(streams))
+		throw std::invalid_argument("number of interleaved streams must be 2, 4 or 8");
+}
+
+Statistics InterleavedCoder::encode(ByteSource& source, ByteSink& out)
+{
+	ProgressSource in(source, printProgress);
+
+	uint8_t header[StreamHeader::SIZE + 1];
+	StreamHeader streamHeader;
+	streamHeader.format = StreamFormat::Interleaved;
+	streamHeader.serialize(header);
+	header[StreamHeader::SIZE] = (uint8_t)streams;
+	out.write(header, sizeof(header));
+
+	std::vector<std::unique_ptr<StreamEncoder>> encoders;
+	for (int k = 0; k < streams; k++)
+		encoders.push_back(std::make_unique<StreamEncoder>());
+
+	size_t next = 0;	// stream of the next byte
+	const uint8_t* chunk = nullptr;
+	while (size_t chunkSize = in.next(chunk))
+	{
+		for (size_t begin = 0; begin < chunkSize; begin += SLICE)
+		{
+			size_t end = std::min(chunkSize, begin + SLICE);
+			for (size_t i = begin; i < end; i++)
+			{
+				StreamEncoder& stream = *encoders[next];
+				stream.out.beginByte(chunk[i]);		// for statistics purposes
+				stream.encode(chunk[i]);
+				next = next + 1 == encoders.size() ? 0 : next + 1;
+			}
+
+			size_t ready = 0;
+			for (auto& stream : encoders)
+				ready += stream->ready.size();
+			if (ready >= SEGMENT_SIZE)
+				writeSegment(encoders, false, out);
+		}
+	}
+
+	Statistics stats;
+	for (auto& stream : encoders) {
+		stream->encode(EOF_SYMBOL);
+		stream->interval.finish();
+		stream->out.flush();
+		stats.add(Statistics(stream->out.getStats()));
+	}
+	writeSegment(encoders, true, out);
+	out.flush();
+	return stats;
+}
+
+void InterleavedCoder::decode(ByteSource& source, ByteSink& sink)
+{
+	ProgressSource progress(source, printProgress);
+	ByteReader in(progress);
+
+	uint8_t header[StreamHeader::SIZE + 1] = {};
+	in.read(header, sizeof(header));
+	StreamHeader streamHeader;
+	if (!streamHeader.deserialize(header) || streamHeader.format != StreamFormat::Interleaved)
+		throw std::runtime_error("data was encoded in a different format");
+	int streams = header[StreamHeader::SIZE];
+	if (!validStreams(streams))
+		throw std::runtime_error("encoded data is truncated or corrupted");
+
+	std::vector<std::unique_ptr<StreamDecoder>> decoders;
+	for (int k = 0; k < streams; k++)
+		decoders.push_back(std::make_unique<StreamDecoder>());
+
+	bool lastSegment = false;
+	std::vector<uint8_t> sizes(1 + 4 * (size_t)streams);
+	std::vector<uint8_t> data;
+	auto readSegment = [&]() {
+		if (lastSegment)
+			return;
+		readExactly(in, sizes.data(), sizes.size());
+		lastSegment = sizes[0] != 0;
+		for (int k = 0; k < streams; k++)
+		{
+			size_t size = getLittleEndian<uint32_t>(&sizes[1 + 4 * k]);
+			if (size > MAX_STREAM_SEGMENT)
+				throw std::runtime_error("encoded data is truncated or corrupted");
+			data.resize(size);
+			readExactly(in, data.data(), size);
+			decoders[k]->source.push(data.data(), size);
+			decoders[k]->bits.feed(size);
+			if (lastSegment)
+				decoders[k]->bits.finish();
+		}
+	};
+
+	// 'z' of every stream
+	for (auto& stream : decoders) {
+		while (!stream->bits.canStart(0))
+			readSegment();
+		stream->interval.start(IntervalArithmetic::Integer);
+	}
+
+	// Bytes are decoded in rounds, one from every stream. The streams don't
+	// depend on each other, so their decoding overlaps in the processor.
+	ByteWriter out(sink);
+	bool endOfStream = false;
+	while (!endOfStream)
+	{
+		// A symbol takes at most PRECISION bits.
+		for (auto& stream : decoders)
+			while (!stream->bits.canDecode(stream->interval.bitsTaken()))
+				readSegment();
+
+		for (auto& decoder : decoders)
+		{
+			StreamDecoder& stream = *decoder;
+			size_t total = stream.model.totalFrequency();
+			size_t symbol = stream.model.findSymbol((size_t)stream.interval.count(total));
+			if (symbol == EOF_SYMBOL) {
+				endOfStream = true;
+				break;
+			}
+
+			out.put((uint8_t)symbol);
+			size_t freqBegin = stream.model.frequencyBegin(symbol);
+			stream.interval.decode(freqBegin, freqBegin + stream.model.frequency(symbol), total);
+			stream.model.update(symbol);
+		}
+
+		for (auto& stream : decoders)
+			stream->bits.checkTaken(stream->interval.bitsTaken());
+	}
+
+	out.flush();
+	sink.flush();
+}
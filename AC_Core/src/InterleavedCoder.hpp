@@ -0,0 +1,46 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+#include "ArithmeticCoder.hpp"
+#include "Statistics.hpp"
+
+// Adaptive order-0 coder split into 2, 4 or 8 independent streams: byte i
+// is coded by stream i mod streams, which has its own model, interval and
+// output. Consecutive bytes therefore don't depend on each other and the
+// processor decodes several of them at once, while the input is still coded
+// as a whole (models are not reset as in BlockCoder).
+//
+// Output of the streams is written in segments, so neither side keeps more
+// than a few segments in memory. Layout (integers are little-endian):
+//
+//   StreamHeader            "AC", StreamFormat::Interleaved, flags
+//   number of streams       uint8
+//   segments:
+//     last segment flag     uint8 (1 for the last one)
+//     sizes                 uint32 for every stream
+//     data                  bytes of every stream, in the order of the sizes
+//
+// Every stream ends with the EOF symbol; decoding stops at the first one.
+class InterleavedCoder : public ArithmeticCoder
+{
+public:
+	static constexpr uint64_t PRECISION = 32;
+	static constexpr int DEFAULT_STREAMS = 4;
+	static constexpr size_t SEGMENT_SIZE = 1 << 16;	// written when streams have this many bytes ready
+
+	// Decoding ignores the number of streams, it is read from the data.
+	InterleavedCoder(int streams = DEFAULT_STREAMS, bool printProgress = false);
+	using ArithmeticCoder::encode;
+	using ArithmeticCoder::decode;
+
+	Statistics encode(ByteSource& in, ByteSink& out) override;
+	void decode(ByteSource& in, ByteSink& out) override;
+
+	static bool validStreams(int streams) { return streams == 2 || streams == 4 || streams == 8; }
+
+private:
+	int streams;
+	bool printProgress;
+};
@@ -0,0 +1,238 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+#include "StreamHeader.hpp"
+#include "BitUtils/BitWriter.hpp"
+#include "BitUtils/BitReader.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+// The interval [a, b) of an arithmetic coder with E1/E2/E3 scaling, without
+// any model. A model gives cumulative frequencies [freqBegin, freqEnd) of
+// 'total' and the interval is narrowed to that part of it. Models that code
+// a symbol in several steps (e.g. escapes of PPMModel) call it many times.
+//
+// Precision is the number of bits of the interval; total must not exceed
+// MAX_TOTAL_FREQUENCY.
+template <unsigned Precision>
+struct IntervalBounds
+{
+	static_assert(Precision >= 16 && Precision <= 32, "decoder takes up to 32 bits at once from BitReader");
+
+	static constexpr uint64_t PRECISION = Precision;
+	static constexpr uint64_t WHOLE = uint64_t(1) << PRECISION;
+	static constexpr uint64_t HALF = WHOLE / 2;
+	static constexpr uint64_t QUARTER = WHOLE / 4;
+	static constexpr uint64_t MAX_TOTAL_FREQUENCY = QUARTER - 1;
+
+	// Returns w * (freq / total) rounded the way the given arithmetic does it.
+	static uint64_t scale(uint64_t w, uint64_t freq, uint64_t total, IntervalArithmetic arithmetic)
+	{
+		if (arithmetic == IntervalArithmetic::Integer)
+			return w * freq / total;	// exact: w <= WHOLE and freq <= total < QUARTER, so w * freq < 2^62
+		else
+			return llround(w * ((double)freq / total));
+	}
+};
+
+template <unsigned Precision = 32>
+class IntervalEncoder : public IntervalBounds<Precision>
+{
+	using B = IntervalBounds<Precision>;
+
+public:
+	IntervalEncoder(BitWriter& out, IntervalArithmetic arithmetic = IntervalArithmetic::Integer)
+		: out(out), arithmetic(arithmetic) {}
+
+	void encode(uint64_t freqBegin, uint64_t freqEnd, uint64_t total)
+	{
+		uint64_t w = b - a;
+		b = a + B::scale(w, freqEnd, total, arithmetic);
+		a = a + B::scale(w, freqBegin, total, arithmetic);
+
+		// Scaling
+		while (true)
+		{
+			if (b < B::HALF) {			// Expand left. [a = 2a, b = 2b]
+				out.write(0);
+				out.writeN(1, s);
+				s = 0;
+			}
+			else if (a > B::HALF) {		// Expand right. [a = 2(a-half), b = 2(b-HALF)]
+				out.write(1);
+				out.writeN(0, s);
+				s = 0;
+				a -= B::HALF;
+				b -= B::HALF;
+			}
+			else if (a > B::QUARTER && b < 3 * B::QUARTER) {	// Expand middle (blow up). [a = 2(a-quarter), b = 2(b-quarter)]
+				s += 1;
+				a -= B::QUARTER;
+				b -= B::QUARTER;
+			}
+			else {		// No more scaling.
+				break;	// At this point [a,b] range is at least HALF in length.
+			}
+			a *= 2;
+			b *= 2;
+		}
+	}
+
+	// Writes the bits that select the final interval (the writer is not flushed).
+	void finish()
+	{
+		s += 1;
+		if (a <= B::QUARTER) {
+			out.write(0);
+			out.writeN(1, s);
+		}
+		else {
+			out.write(1);
+			out.writeN(0, s);
+		}
+	}
+
+private:
+	BitWriter& out;
+	const IntervalArithmetic arithmetic;
+
+	uint64_t a = 0;
+	uint64_t b = B::WHOLE;
+	int s = 0;
+};
+
+template <unsigned Precision = 32>
+class IntervalDecoder : public IntervalBounds<Precision>
+{
+	using B = IntervalBounds<Precision>;
+
+public:
+	IntervalDecoder(BitReader& in)
+		: in(in) {}
+
+	// Reads the first PRECISION bits. Must be called before anything else.
+	void start(IntervalArithmetic arithmetic)
+	{
+		this->arithmetic = arithmetic;
+		z = in.peekBits(Precision);
+		take(Precision);
+	}
+
+	// Scales the code back to a frequency count in [0, total). With integer
+	// arithmetic it is exact: the symbol for which freqBegin <= count < freqEnd
+	// is the coded one. With floating-point arithmetic see locate().
+	uint64_t count(uint64_t total) const
+	{
+		uint64_t w = b - a;
+		return std::min<uint64_t>(((z - a + 1) * total - 1) / w, total - 1);
+	}
+
+	// Returns -1 if the code is below [freqBegin, freqEnd), 1 if it is above
+	// and 0 if it is inside. Only needed for floating-point arithmetic, where
+	// rounding can move a bound by one, so a neighbour of count() may be coded.
+	int locate(uint64_t freqBegin, uint64_t freqEnd, uint64_t total) const
+	{
+		uint64_t w = b - a;
+		if (z < a + B::scale(w, freqBegin, total, arithmetic))
+			return -1;
+		if (z >= a + B::scale(w, freqEnd, total, arithmetic))
+			return 1;
+		return 0;
+	}
+
+	// The same as IntervalEncoder::encode(), but reads bits instead of writing them.
+	void decode(uint64_t freqBegin, uint64_t freqEnd, uint64_t total)
+	{
+		uint64_t w = b - a;
+		b = a + B::scale(w, freqEnd, total, arithmetic);
+		a = a + B::scale(w, freqBegin, total, arithmetic);
+
+		// Scaling. Steps depend only on 'a' and 'b'. Every step doubles the
+		// distance between 'z' and 'a' and appends one bit to it, so all the
+		// bits are appended at once afterwards (at most PRECISION steps).
+		uint64_t distance = z - a;
+		int steps = 0;
+		while (true)
+		{
+			if (b < B::HALF) {				// Expand left
+				/* nothing */
+			}
+			else if (a > B::HALF) {			// Expand right
+				a -= B::HALF;
+				b -= B::HALF;
+			}
+			else if (a > B::QUARTER && b < 3 * B::QUARTER) {	// Expand middle (blow up)
+				a -= B::QUARTER;
+				b -= B::QUARTER;
+			}
+			else {		// No more scaling.
+				break;	// At this point [a,b] range is at least HALF in length.
+			}
+			a *= 2;
+			b *= 2;
+			steps++;
+		}
+
+		// Update z approximation
+		z = a + ((distance << steps) | in.peekBits(steps));
+		take(steps);
+	}
+
+	uint64_t bitsTaken() const { return taken; }	// bits taken out of the reader
+
+private:
+	BitReader& in;
+	IntervalArithmetic arithmetic = IntervalArithmetic::Integer;
+
+	uint64_t a = 0;
+	uint64_t b = B::WHOLE;
+	uint64_t z = 0;
+	uint64_t taken = 0;
+
+	void take(int n)
+	{
+		in.consumeBits(n);
+		taken += n;
+	}
+};
+
+// Bits fed to a push-based decoder. A decoder must not take bits that were
+// not fed yet, unless there is no more data: then the missing bits are '0'
+// after the end. Decoders check it with the bits they have taken (header
+// included) and the most that the next step can take.
+template <unsigned Precision = 32>
+class BitBudget
+{
+public:
+	void feed(size_t bytes) { fed += 8 * (uint64_t)bytes; }
+	void finish() { finished = true; }
+	bool isFinished() const { return finished; }
+
+	// The header and 'z' are available.
+	bool canStart(uint64_t headerBits) const
+	{
+		return finished || fed >= headerBits + Precision;
+	}
+
+	// The next step, taking at most stepBits, is available.
+	bool canDecode(uint64_t taken, uint64_t stepBits = Precision) const
+	{
+		return finished || fed >= taken + stepBits;
+	}
+
+	// A valid stream never needs more than 'z' worth of bits after its end.
+	void checkTaken(uint64_t taken) const
+	{
+		if (taken > fed + 2 * Precision)
+			throw std::runtime_error("encoded data is truncated or corrupted");
+	}
+
+private:
+	uint64_t fed = 0;
+	bool finished = false;
+};
@@ -0,0 +1,245 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#include "LzCoder.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace LzFormat;
+using namespace SlotCoding;
+
+LzCoder::LzCoder(int windowBits, bool printProgress)
+	: windowBits(windowBits), printProgress(printProgress)
+{
+	if (windowBits < MIN_WINDOW_BITS || windowBits > MAX_WINDOW_BITS)
+		throw std::invalid_argument("LZ window must be 2^10 to 2^24 bytes");
+}
+
+Statistics LzCoder::encode(ByteSource& in, ByteSink& out)
+{
+	Encoder encoder(out, windowBits);
+	return encodeWith(in, encoder, printProgress);
+}
+
+void LzCoder::decode(ByteSource& in, ByteSink& out)
+{
+	Decoder decoder(out);
+	decodeWith(in, decoder, printProgress);
+}
+
+LzCoder::Encoder::Encoder(ByteSink& sink, int windowBits, int maxChain)
+	: out(sink), interval(out), models(windowBits),
+	window(size_t(1) << windowBits), maxChain(maxChain),
+	buffer(2 * window + MAX_MATCH), head(size_t(1) << HASH_BITS, NONE), chain(window, NONE)
+{
+	StreamHeader header;
+	header.format = StreamFormat::Lz;
+	uint8_t bytes[StreamHeader::SIZE + PARAMETERS_SIZE];
+	header.serialize(bytes);
+
+	bytes[StreamHeader::SIZE] = (uint8_t)windowBits;
+	for (uint8_t byte : bytes)
+		out.writeByte(byte);
+}
+
+void LzCoder::Encoder::feed(const uint8_t* data, size_t size)
+{
+	if (finished)
+		throw std::logic_error("cannot feed finished encoder");
+
+	while (size > 0)
+	{
+		if (filled == buffer.size())
+			slide();
+
+		size_t count = std::min(size, buffer.size() - filled);
+		std::memcpy(&buffer[filled], data, count);
+		filled += count;
+		data += count;
+		size -= count;
+
+		codeAvailable(MAX_MATCH);
+	}
+}
+
+Statistics LzCoder::Encoder::finish()
+{
+	if (!finished)
+	{
+		codeAvailable(1);
+		encodeSymbol(interval, models.literals, EOF_SYMBOL);
+		interval.finish();
+		out.flush();
+		finished = true;
+	}
+	return Statistics(out.getStats());
+}
+
+// Codes bytes while at least 'lookahead' of them are buffered.
+void LzCoder::Encoder::codeAvailable(size_t lookahead)
+{
+	while (position < filled && filled - position >= lookahead)
+	{
+		size_t distance = 0;
+		size_t length = findMatch(distance);
+		if (length == 0)
+		{
+			out.beginByte(buffer[position]);	// for statistics purposes
+			encodeSymbol(interval, models.literals, buffer[position]);
+			length = 1;
+		}
+		else
+		{
+			for (size_t i = 0; i < length; i++)
+				out.beginByte(buffer[position + i]);
+			encodeSymbol(interval, models.literals, MATCH_SYMBOL);
+			encodeValue(interval, models.lengths, (uint32_t)(length - MIN_MATCH));
+			encodeValue(interval, models.distances, (uint32_t)(distance - 1));
+		}
+
+		// every position is inserted, so the next repeat finds the closest match
+		for (size_t end = position + length; position < end; position++)
+			if (position + MIN_MATCH <= filled)
+				insert(position);
+	}
+}
+
+// Moves the buffer back by a multiple of the window, keeping the last
+// window of coded data, and rebases the hash chains.
+void LzCoder::Encoder::slide()
+{
+	size_t shift = (position - window) & ~(window - 1);		// position > 2 * window here
+	std::memmove(buffer.data(), buffer.data() + shift, filled - shift);
+	filled -= shift;
+	position -= shift;
+
+	auto rebase = [shift](int32_t& at) { at = at >= (int32_t)shift ? at - (int32_t)shift : NONE; };
+	std::for_each(head.begin(), head.end(), rebase);
+	std::for_each(chain.begin(), chain.end(), rebase);	// a multiple of window keeps the slots
+}
+
+void LzCoder::Encoder::insert(size_t at)
+{
+	uint32_t bytes;
+	std::memcpy(&bytes, &buffer[at], sizeof(bytes));
+	uint32_t hash = (bytes * 2654435761u) >> (32 - HASH_BITS);
+
+	chain[at & (window - 1)] = head[hash];
+	head[hash] = (int32_t)at;
+}
+
+// Returns the length of the longest match at 'position' found in maxChain
+// candidates (0 if none is MIN_MATCH long).
+size_t LzCoder::Encoder::findMatch(size_t& distance) const
+{
+	size_t maxLength = std::min(MAX_MATCH, filled - position);
+	if (maxLength < MIN_MATCH)
+		return 0;
+
+	uint32_t bytes;
+	std::memcpy(&bytes, &buffer[position], sizeof(bytes));
+	int32_t candidate = head[(bytes * 2654435761u) >> (32 - HASH_BITS)];
+
+	const uint8_t* current = &buffer[position];
+	size_t best = MIN_MATCH - 1;
+	for (int left = maxChain; candidate != NONE && position - candidate <= window && left > 0; left--)
+	{
+		const uint8_t* earlier = &buffer[candidate];
+		if (earlier[best] == current[best])		// can it be longer than the best one?
+		{
+			size_t length = 0;
+			while (length < maxLength && earlier[length] == current[length])
+				length++;
+
+			if (length > best) {
+				best = length;
+				distance = position - candidate;
+				if (length == maxLength)
+					break;
+			}
+		}
+
+		int32_t next = chain[candidate & (window - 1)];
+		if (next >= candidate)
+			break;		// the slot was reused by a newer position
+		candidate = next;
+	}
+	return best >= MIN_MATCH ? best : 0;
+}
+
+LzCoder::Decoder::Decoder(ByteSink& sink)
+	: in(source), interval(in), out(sink)
+{
+}
+
+void LzCoder::Decoder::feed(const uint8_t* data, size_t size)
+{
+	if (endOfStream || bits.isFinished())
+		return;		// everything after EOF symbol is ignored
+
+	source.push(data, size);
+	bits.feed(size);
+	decodeAvailable();
+	out.flush();
+}
+
+void LzCoder::Decoder::finish()
+{
+	bits.finish();
+	decodeAvailable();
+	out.flush();
+}
+
+void LzCoder::Decoder::decodeAvailable()
+{
+	if (!models)
+	{
+		// header, parameters and 'z'
+		constexpr uint64_t BYTES = StreamHeader::SIZE + PARAMETERS_SIZE;
+		if (!bits.canStart(8 * BYTES))
+			return;
+
+		StreamHeader header;
+		uint8_t bytes[StreamHeader::SIZE];
+		in.peekBytes(bytes, StreamHeader::SIZE);
+		if (!header.deserialize(bytes) || header.format != StreamFormat::Lz || header.arithmetic != IntervalArithmetic::Integer)
+			throw std::runtime_error("data was encoded in a different format");
+		in.consumeBits(8 * StreamHeader::SIZE);
+
+		uint8_t parameters[PARAMETERS_SIZE];
+		in.peekBytes(parameters, PARAMETERS_SIZE);
+		in.consumeBits(8 * PARAMETERS_SIZE);
+		int windowBits = parameters[0];
+		if (windowBits < MIN_WINDOW_BITS || windowBits > MAX_WINDOW_BITS)
+			throw std::runtime_error("encoded data has an invalid LZ window size");
+
+		models = std::make_unique<Models<GroupedModel>>(windowBits);
+		history.assign(size_t(1) << windowBits, 0);
+		headerBits = 8 * BYTES;
+		interval.start(header.arithmetic);
+	}
+
+	const size_t mask = history.size() - 1;
+	while (!endOfStream && bits.canDecode(bitsTaken(), MAX_STEPS_PER_TOKEN * PRECISION))
+	{
+		size_t symbol = decodeSymbol(interval, models->literals);
+		if (symbol < MATCH_SYMBOL)
+			put((uint8_t)symbol);
+		else if (symbol == EOF_SYMBOL)
+			endOfStream = true;
+		else
+		{
+			size_t length = decodeValue(interval, models->lengths) + MIN_MATCH;
+			uint64_t distance = decodeValue(interval, models->distances) + uint64_t(1);	// within the window by its slots
+			if (distance > decoded)
+				throw std::runtime_error("encoded data is truncated or corrupted");
+
+			for (size_t i = 0; i < length; i++)		// may overlap the bytes it writes
+				put(history[(decoded - distance) & mask]);
+		}
+		bits.checkTaken(bitsTaken());
+	}
+}
@@ -0,0 +1,160 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+#include "ArithmeticCoder.hpp"
+#include "FenwickModel.hpp"
+#include "GroupedModel.hpp"
+#include "IntervalCoder.hpp"
+#include "SlotCoding.hpp"
+#include "Statistics.hpp"
+#include "StreamHeader.hpp"
+#include "BitUtils/BitWriter.hpp"
+#include "BitUtils/BitReader.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// LZ77 stage in front of the interval coder. Repeated strings are replaced
+// by (length, distance) matches to earlier data within a window, found with
+// hash chains. Literals, match lengths and match distances are then coded
+// with three separate adaptive models, so a repeated line costs a few
+// symbols instead of one symbol per byte.
+//
+// Every token starts with a symbol of the literal model: a byte, MATCH
+// or EOF. A match is followed by its length and distance, both coded as
+// a slot of their own model and uniform extra bits (see SlotCoding.hpp).
+//
+// The window size is stored after the stream header:
+//
+//   byte 4:   log2 of the window size
+class LzCoder : public ArithmeticCoder
+{
+public:
+	static constexpr uint64_t PRECISION = 32;
+	static constexpr int PARAMETERS_SIZE = 1;
+	static constexpr int MIN_WINDOW_BITS = 10;
+	static constexpr int MAX_WINDOW_BITS = 24;
+	static constexpr int DEFAULT_WINDOW_BITS = 20;
+	static constexpr size_t MIN_MATCH = 4;
+	static constexpr size_t MAX_MATCH = MIN_MATCH + 0xFFFF;
+	static constexpr int DEFAULT_MAX_CHAIN = 32;	// candidates checked for a match
+
+	class Encoder;
+	class Decoder;
+
+	// Decoding ignores the window size, it is read from the data.
+	LzCoder(int windowBits = DEFAULT_WINDOW_BITS, bool printProgress = false);
+	using ArithmeticCoder::encode;
+	using ArithmeticCoder::decode;
+
+	Statistics encode(ByteSource& in, ByteSink& out) override;
+	void decode(ByteSource& in, ByteSink& out) override;
+
+private:
+	int windowBits;
+	bool printProgress;
+};
+
+namespace LzFormat
+{
+	constexpr size_t MATCH_SYMBOL = 256;
+	constexpr size_t EOF_SYMBOL = 257;
+	constexpr size_t LITERAL_SYMBOLS = 258;
+	constexpr size_t MODEL_MAX_FREQUENCY = 1 << 16;		// low, so the models follow local statistics
+
+	// Literal, length and distance models of one stream.
+	template <typename Model>
+	struct Models
+	{
+		Model literals;
+		Model lengths;
+		Model distances;
+
+		Models(int windowBits)
+			: literals(LITERAL_SYMBOLS, MODEL_MAX_FREQUENCY),
+			lengths(SlotCoding::slotCount((uint32_t)(LzCoder::MAX_MATCH - LzCoder::MIN_MATCH)), MODEL_MAX_FREQUENCY),
+			distances(SlotCoding::slotCount((uint32_t(1) << windowBits) - 1), MODEL_MAX_FREQUENCY)
+		{
+		}
+	};
+}
+
+// Push-based encoder. Fed data is collected until there are MAX_MATCH
+// bytes to look ahead, so a match never ends at the boundary of a chunk;
+// finish() codes the rest.
+class LzCoder::Encoder
+{
+public:
+	Encoder(ByteSink& sink, int windowBits, int maxChain = DEFAULT_MAX_CHAIN);
+
+	void feed(const uint8_t* data, size_t size);
+	Statistics finish();	// codes the rest of the data and EOF symbol and flushes the sink
+
+private:
+	static constexpr int HASH_BITS = 18;
+	static constexpr int32_t NONE = -1;
+
+	BitWriter out;
+	IntervalEncoder<PRECISION> interval;
+	LzFormat::Models<FenwickModel> models;
+	bool finished = false;
+
+	const size_t window;
+	const int maxChain;
+
+	// Positions are indices of buffer. It keeps a window of coded data before
+	// 'position' and is moved back when it fills up (see slide()).
+	std::vector<uint8_t> buffer;
+	size_t filled = 0;
+	size_t position = 0;		// next byte to code
+	std::vector<int32_t> head;	// latest position of every hash
+	std::vector<int32_t> chain;	// previous position with the same hash, by position % window
+
+	void codeAvailable(size_t lookahead);
+	void slide();
+	void insert(size_t at);
+	size_t findMatch(size_t& distance) const;
+};
+
+// Push-based decoder. The models and the history are allocated when the
+// header gives the window size, and a token is decoded only when all of
+// its bits are fed.
+class LzCoder::Decoder
+{
+public:
+	Decoder(ByteSink& sink);
+
+	void feed(const uint8_t* data, size_t size);
+	void finish();		// no more data: decodes the rest assuming '0' bits after the end
+	bool done() const { return endOfStream; }
+
+private:
+	// A token takes a literal, two slots and at most three pieces of extra bits.
+	static constexpr uint64_t MAX_STEPS_PER_TOKEN = 6;
+
+	QueueSource source;
+	BitReader in;
+	IntervalDecoder<PRECISION> interval;
+	ByteWriter out;
+	std::unique_ptr<LzFormat::Models<GroupedModel>> models;
+
+	std::vector<uint8_t> history;	// the last window of decoded bytes, circular
+	uint64_t decoded = 0;
+
+	BitBudget<PRECISION> bits;
+	uint64_t headerBits = 0;
+	bool endOfStream = false;
+
+	uint64_t bitsTaken() const { return headerBits + interval.bitsTaken(); }
+	void decodeAvailable();
+
+	inline void put(uint8_t byte)
+	{
+		history[decoded & (history.size() - 1)] = byte;
+		decoded++;
+		out.put(byte);
+	}
+};
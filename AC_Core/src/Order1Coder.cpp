@@ -0,0 +1,7 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#include "Order1Coder.hpp"
+
+template class BasicArithmeticCoder<Order1Model, 32, 256, StreamFormat::Order1>;
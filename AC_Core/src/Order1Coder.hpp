@@ -0,0 +1,9 @@
+#pragma once
+#include "BasicArithmeticCoder.hpp"
+#include "Order1Model.hpp"
+
+// Adaptive order-1 coder: the previous byte selects the frequency table.
+using Order1Coder = BasicArithmeticCoder<Order1Model, 32, 256, StreamFormat::Order1>;
+
+// Compiled once in Order1Coder.cpp.
+extern template class BasicArithmeticCoder<Order1Model, 32, 256, StreamFormat::Order1>;
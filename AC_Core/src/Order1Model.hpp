@@ -0,0 +1,152 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+
+#include "SimdKernels.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+// Adaptive order-1 model: the previous symbol selects one of the frequency
+// tables (a context), so every symbol has its own statistics of what follows it.
+//
+// Every context is a Fenwick tree of 16-bit counters (see FenwickModel) and all
+// of them live in one contiguous array: [ total | frequencies (n) | tree (n) ]
+// per context. Counters are incremented by INCREMENT so a context adapts
+// quickly; a context is halved on its own when its total would exceed
+// MAX_CONTEXT_FREQUENCY (or maxTotalFrequency, if lower).
+//
+// The first symbol is coded in context 0. Symbols are not bounds-checked.
+class Order1Model
+{
+public:
+	static constexpr uint32_t MAX_CONTEXT_FREQUENCY = 0xFFFF;
+	static constexpr uint32_t INCREMENT = 16;
+
+	Order1Model(size_t numberOfSymbols, size_t maxTotalFrequency)
+		: numberOfSymbols(numberOfSymbols),
+		tableSize(2 * numberOfSymbols + 1),
+		tables(new uint16_t[numberOfSymbols * (2 * numberOfSymbols + 1)]),
+		maxFrequency((uint32_t)std::min<size_t>(maxTotalFrequency, MAX_CONTEXT_FREQUENCY))
+	{
+		if (numberOfSymbols + INCREMENT > maxFrequency)
+			throw std::invalid_argument("max frequency is too low to fit that number of symbols");
+
+		highestStep = 1;
+		while (highestStep * 2 <= numberOfSymbols)
+			highestStep *= 2;
+
+		reset();
+	}
+
+	void reset()
+	{
+		for (size_t context = 0; context < numberOfSymbols; context++)
+		{
+			selectContext(context);
+			table[0] = (uint16_t)numberOfSymbols;
+			for (size_t i = 0; i < numberOfSymbols; i++)
+				frequencies[i] = 1;		// initially every symbol is marked as 'appeared once'
+			buildTree();
+		}
+		selectContext(0);
+	}
+
+	// Counts the symbol in the current context and makes it the next context.
+	void update(size_t symbol)
+	{
+		if (table[0] + INCREMENT > maxFrequency) {	// halve counts of this context (keeping them positive)
+			table[0] = (uint16_t)SimdKernels::halve(frequencies, numberOfSymbols);
+			buildTree();
+		}
+
+		frequencies[symbol] += INCREMENT;
+		table[0] += INCREMENT;
+		for (size_t i = symbol + 1; i <= numberOfSymbols; i += lowestBit(i))
+			tree[i] += INCREMENT;
+
+		selectContext(symbol);
+	}
+
+	size_t frequencyBegin(size_t symbol) const
+	{
+		size_t sum = 0;		// sum of frequencies of symbols [0, symbol)
+		for (size_t i = symbol; i > 0; i -= lowestBit(i))
+			sum += tree[i];
+		return sum;
+	}
+
+	size_t frequencyEnd(size_t symbol) const
+	{
+		return frequencyBegin(symbol) + frequencies[symbol];
+	}
+
+	// Returns the symbol for which frequencyBegin(symbol) <= count < frequencyEnd(symbol).
+	size_t findSymbol(size_t count) const
+	{
+		size_t position = 0;
+		for (size_t step = highestStep; step > 0; step >>= 1)
+		{
+			size_t next = position + step;
+			if (next <= numberOfSymbols && tree[next] <= count) {
+				position = next;
+				count -= tree[next];
+			}
+		}
+		return position;
+	}
+
+	size_t frequency(size_t symbol) const
+	{
+		return frequencies[symbol];
+	}
+
+	size_t totalFrequency() const
+	{
+		return table[0];
+	}
+
+	size_t size() const
+	{
+		return numberOfSymbols;
+	}
+
+private:
+	const size_t numberOfSymbols;
+	const size_t tableSize;
+	std::unique_ptr<uint16_t[]> tables;		// one table per context
+	const uint32_t maxFrequency;
+	size_t highestStep;		// the largest power of 2 not greater than numberOfSymbols
+
+	uint16_t* table;		// current context: [ total | frequencies | tree ]
+	uint16_t* frequencies;
+	uint16_t* tree;			// tree[1..n]
+
+	static size_t lowestBit(size_t i)
+	{
+		return i & (~i + 1);
+	}
+
+	void selectContext(size_t context)
+	{
+		table = tables.get() + context * tableSize;
+		frequencies = table + 1;
+		tree = table + numberOfSymbols;		// tree[0] would be frequencies[n - 1], but it is never used
+	}
+
+	void buildTree()	// O(n) construction from plain frequencies
+	{
+		for (size_t i = 1; i <= numberOfSymbols; i++)
+			tree[i] = frequencies[i - 1];
+
+		for (size_t i = 1; i <= numberOfSymbols; i++) {
+			size_t parent = i + lowestBit(i);
+			if (parent <= numberOfSymbols)
+				tree[parent] += tree[i];
+		}
+	}
+};
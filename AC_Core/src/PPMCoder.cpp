@@ -0,0 +1,130 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#include "PPMCoder.hpp"
+
+#include <stdexcept>
+
+PPMCoder::PPMCoder(int order, size_t memoryLimit, bool printProgress)
+	: order(order), memoryLimit(memoryLimit), printProgress(printProgress)
+{
+	if (memoryLimit % MEMORY_UNIT != 0 || memoryLimit == 0 || memoryLimit / MEMORY_UNIT > 0xFFFF)
+		throw std::invalid_argument("PPM memory limit must be a multiple of 1 MiB");
+}
+
+Statistics PPMCoder::encode(ByteSource& in, ByteSink& out)
+{
+	Encoder encoder(out, order, memoryLimit);
+	return encodeWith(in, encoder, printProgress);
+}
+
+void PPMCoder::decode(ByteSource& in, ByteSink& out)
+{
+	Decoder decoder(out);
+	decodeWith(in, decoder, printProgress);
+}
+
+PPMCoder::Encoder::Encoder(ByteSink& sink, int order, size_t memoryLimit)
+	: out(sink), interval(out), model(order, memoryLimit)
+{
+	StreamHeader header;
+	header.format = StreamFormat::PPM;
+	uint8_t bytes[StreamHeader::SIZE + PARAMETERS_SIZE];
+	header.serialize(bytes);
+
+	uint16_t memory = (uint16_t)(memoryLimit / MEMORY_UNIT);
+	bytes[StreamHeader::SIZE] = (uint8_t)order;
+	bytes[StreamHeader::SIZE + 1] = (uint8_t)memory;
+	bytes[StreamHeader::SIZE + 2] = (uint8_t)(memory >> 8);
+	for (uint8_t byte : bytes)
+		out.writeByte(byte);
+}
+
+void PPMCoder::Encoder::feed(const uint8_t* data, size_t size)
+{
+	if (finished)
+		throw std::logic_error("cannot feed finished encoder");
+
+	for (size_t i = 0; i < size; i++)
+	{
+		out.beginByte(data[i]);		// for statistics purposes
+		model.encode(data[i], interval);
+	}
+}
+
+Statistics PPMCoder::Encoder::finish()
+{
+	if (!finished)
+	{
+		model.encode(PPMModel::EOF_SYMBOL, interval);
+		interval.finish();
+		out.flush();
+		finished = true;
+	}
+	return Statistics(out.getStats());
+}
+
+PPMCoder::Decoder::Decoder(ByteSink& sink)
+	: in(source), interval(in), out(sink)
+{
+}
+
+void PPMCoder::Decoder::feed(const uint8_t* data, size_t size)
+{
+	if (endOfStream || bits.isFinished())
+		return;		// everything after EOF symbol is ignored
+
+	source.push(data, size);
+	bits.feed(size);
+	decodeAvailable();
+	out.flush();
+}
+
+void PPMCoder::Decoder::finish()
+{
+	bits.finish();
+	decodeAvailable();
+	out.flush();
+}
+
+void PPMCoder::Decoder::decodeAvailable()
+{
+	if (!model)
+	{
+		// header, parameters and 'z'
+		constexpr uint64_t BYTES = StreamHeader::SIZE + PARAMETERS_SIZE;
+		if (!bits.canStart(8 * BYTES))
+			return;
+
+		StreamHeader header;
+		uint8_t bytes[StreamHeader::SIZE];
+		in.peekBytes(bytes, StreamHeader::SIZE);
+		if (!header.deserialize(bytes) || header.format != StreamFormat::PPM || header.arithmetic != IntervalArithmetic::Integer)
+			throw std::runtime_error("data was encoded in a different format");
+		in.consumeBits(8 * StreamHeader::SIZE);
+
+		uint8_t parameters[PARAMETERS_SIZE];
+		in.peekBytes(parameters, PARAMETERS_SIZE);
+		in.consumeBits(8 * PARAMETERS_SIZE);
+		int order = parameters[0];
+		size_t memoryLimit = (parameters[1] | parameters[2] << 8) * MEMORY_UNIT;
+		model = std::make_unique<PPMModel>(order, memoryLimit);	// throws on invalid parameters
+
+		headerBits = 8 * BYTES;
+		interval.start(header.arithmetic);
+	}
+
+	// A symbol is coded in at most maxStepsPerSymbol() steps, each taking
+	// at most PRECISION bits.
+	const uint64_t symbolBits = model->maxStepsPerSymbol() * PRECISION;
+	while (!endOfStream && bits.canDecode(bitsTaken(), symbolBits))
+	{
+		size_t symbol = model->decode(interval);
+		if (symbol == PPMModel::EOF_SYMBOL)
+			endOfStream = true;
+		else
+			out.put((uint8_t)symbol);
+		bits.checkTaken(bitsTaken());
+	}
+}
@@ -0,0 +1,92 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+#include "ArithmeticCoder.hpp"
+#include "IntervalCoder.hpp"
+#include "PPMModel.hpp"
+#include "Statistics.hpp"
+#include "StreamHeader.hpp"
+#include "BitUtils/BitWriter.hpp"
+#include "BitUtils/BitReader.hpp"
+
+#include <memory>
+
+// Arithmetic coder with a PPM model (see PPMModel). Much better compression
+// of text than the order-0 and order-1 coders, at the cost of speed and memory.
+//
+// The model parameters are stored after the stream header, so the decoder
+// allocates the same amount of memory as the encoder did:
+//
+//   byte 4:   order
+//   byte 5-6: memory limit in MiB (little endian)
+class PPMCoder : public ArithmeticCoder
+{
+public:
+	static constexpr uint64_t PRECISION = 32;
+	static constexpr int PARAMETERS_SIZE = 3;
+	static constexpr size_t MEMORY_UNIT = 1 << 20;
+	static constexpr int DEFAULT_ORDER = 4;
+	static constexpr size_t DEFAULT_MEMORY = 64 * MEMORY_UNIT;
+
+	class Encoder;
+	class Decoder;
+
+	// Memory limit must be a multiple of MEMORY_UNIT. Decoding ignores
+	// both parameters, they are read from the data.
+	PPMCoder(int order = DEFAULT_ORDER, size_t memoryLimit = DEFAULT_MEMORY, bool printProgress = false);
+	using ArithmeticCoder::encode;
+	using ArithmeticCoder::decode;
+
+	Statistics encode(ByteSource& in, ByteSink& out) override;
+	void decode(ByteSource& in, ByteSink& out) override;
+
+private:
+	int order;
+	size_t memoryLimit;
+	bool printProgress;
+};
+
+// Push-based encoder. Every byte is coded by the model in the context of
+// the bytes before it, so the context trie grows as data is fed.
+class PPMCoder::Encoder
+{
+public:
+	Encoder(ByteSink& sink, int order, size_t memoryLimit);
+
+	void feed(const uint8_t* data, size_t size);
+	Statistics finish();	// encodes EOF symbol and flushes the sink
+
+private:
+	BitWriter out;
+	IntervalEncoder<PRECISION> interval;
+	PPMModel model;
+	bool finished = false;
+};
+
+// Push-based decoder. The model is created when the header is read, and a
+// byte is decoded only when all of its escapes can be.
+class PPMCoder::Decoder
+{
+public:
+	Decoder(ByteSink& sink);
+
+	void feed(const uint8_t* data, size_t size);
+	void finish();		// no more data: decodes the rest assuming '0' bits after the end
+	bool done() const { return endOfStream; }
+
+private:
+	QueueSource source;
+	BitReader in;
+	IntervalDecoder<PRECISION> interval;
+	ByteWriter out;
+	std::unique_ptr<PPMModel> model;
+
+	BitBudget<PRECISION> bits;
+	uint64_t headerBits = 0;
+	bool endOfStream = false;
+
+	uint64_t bitsTaken() const { return headerBits + interval.bitsTaken(); }
+	void decodeAvailable();
+};
@@ -0,0 +1,134 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#include "PPMModel.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+PPMModel::PPMModel(int order, size_t memoryLimit)
+	: maxOrder(order), arenaSize(memoryLimit / 8 * 8)
+{
+	if (order < MIN_ORDER || order > MAX_ORDER)
+		throw std::invalid_argument("PPM order must be between 1 and 16");
+	if (memoryLimit < MIN_MEMORY || memoryLimit > MAX_MEMORY)
+		throw std::invalid_argument("PPM memory limit must be between 64 KiB and 2 GiB");
+
+	arena.reset(new uint64_t[arenaSize / 8]);	// not initialized, so pages are touched only when used
+	restart();
+}
+
+void PPMModel::restart()
+{
+	arenaTop = 8;	// offset 0 means 'none'
+	contexts[0] = newContext(0);
+	std::fill(contexts + 1, contexts + MAX_ORDER + 1, 0);
+	highestOrder = 0;
+}
+
+uint32_t PPMModel::allocate(size_t bytes)
+{
+	bytes = (bytes + 7) / 8 * 8;
+	if (arenaTop + bytes > arenaSize)
+		return 0;
+
+	uint32_t offset = (uint32_t)arenaTop;
+	arenaTop += bytes;
+	return offset;
+}
+
+uint32_t PPMModel::newContext(uint32_t suffix)
+{
+	uint32_t offset = allocate(sizeof(Context));
+	if (offset != 0)
+		new (&context(offset)) Context{ 0, suffix, 0, 0, 0 };
+	return offset;
+}
+
+PPMModel::Entry* PPMModel::findOrAdd(uint32_t offset, uint8_t symbol)
+{
+	Context& c = context(offset);
+	Entry* list = entries(c);
+	for (uint16_t i = 0; i < c.count; i++)
+		if (list[i].symbol == symbol)
+			return &list[i];
+
+	if (c.count == c.capacity)	// move to a twice bigger array, the old one is wasted
+	{
+		uint16_t capacity = c.capacity == 0 ? 2 : 2 * c.capacity;
+		uint32_t moved = allocate(capacity * sizeof(Entry));
+		if (moved == 0)
+			return nullptr;
+
+		if (c.count > 0)
+			std::memcpy((uint8_t*)arena.get() + moved, list, c.count * sizeof(Entry));
+		c.entries = moved;
+		c.capacity = capacity;
+	}
+
+	Entry* entry = new (&entries(c)[c.count++]) Entry{ 0, 0, symbol };
+	return entry;		// frequency is 0, the caller counts it
+}
+
+void PPMModel::update(size_t symbol, int foundOrder)
+{
+	if (!tryUpdate(symbol, foundOrder))
+	{
+		restart();	// the arena is full
+		restartCounter++;
+	}
+}
+
+bool PPMModel::tryUpdate(size_t symbol, int foundOrder)
+{
+	auto count = [this](uint32_t offset, Entry* entry) {
+		Context& c = context(offset);
+		if (c.total == MAX_TOTAL_FREQUENCY) {	// halve first (keeping frequencies positive)
+			Entry* list = entries(c);
+			c.total = 0;
+			for (uint16_t i = 0; i < c.count; i++) {
+				list[i].frequency = (list[i].frequency + 1) / 2;
+				c.total += list[i].frequency;
+			}
+		}
+		entry->frequency++;
+		c.total++;
+	};
+
+	// Contexts that coded an escape learn the symbol, the one
+	// that coded the symbol counts it (update exclusion).
+	for (int k = highestOrder; k >= std::max(foundOrder, 0); k--)
+	{
+		Entry* entry = findOrAdd(contexts[k], (uint8_t)symbol);
+		if (entry == nullptr)
+			return false;
+		count(contexts[k], entry);
+	}
+
+	// The symbol extends every context by one byte.
+	uint32_t next[MAX_ORDER + 1];
+	next[0] = contexts[0];
+	int nextHighestOrder = 0;
+	for (int k = 1; k <= maxOrder && k - 1 <= highestOrder; k++)
+	{
+		Entry* entry = findOrAdd(contexts[k - 1], (uint8_t)symbol);
+		if (entry == nullptr)
+			return false;
+		if (entry->frequency == 0)
+			count(contexts[k - 1], entry);
+
+		if (entry->child == 0) {
+			entry->child = newContext(next[k - 1]);
+			if (entry->child == 0)
+				return false;
+		}
+		next[k] = entry->child;
+		nextHighestOrder = k;
+	}
+
+	std::copy(next, next + nextHighestOrder + 1, contexts);
+	highestOrder = nextHighestOrder;
+	return true;
+}
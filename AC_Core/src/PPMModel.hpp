@@ -0,0 +1,217 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+
+// Prediction by partial matching (PPM, method C) of a given maximum order.
+//
+// Every context (the last k bytes, k = 0..order) is a node of a trie. A symbol
+// is coded in the longest context that has seen it; every context on the way
+// that has not seen it codes an escape instead, and symbols seen there are
+// excluded from the lower orders. Symbols never seen at all (and the end of
+// data) are coded with equal probabilities (order -1).
+//
+// Nodes and their symbol lists are allocated from a single arena of fixed
+// size, so memory usage has a hard limit. When the arena is full the model
+// starts from scratch. Encoder and decoder do this at the same symbol.
+//
+// Symbols are coded with any interval coder that has these methods
+// (see IntervalEncoder and IntervalDecoder):
+//
+//   encoder.encode(freqBegin, freqEnd, total);
+//   decoder.count(total) -> count;  decoder.decode(freqBegin, freqEnd, total);
+class PPMModel
+{
+public:
+	static constexpr size_t EOF_SYMBOL = 256;
+	static constexpr int MIN_ORDER = 1;
+	static constexpr int MAX_ORDER = 16;
+	static constexpr size_t MIN_MEMORY = 1 << 16;
+	static constexpr size_t MAX_MEMORY = size_t(1) << 31;	// arena offsets are 32-bit
+
+	PPMModel(int order, size_t memoryLimit);
+
+	// Codes the symbol (0..255 or EOF_SYMBOL) and updates the model.
+	template <typename Encoder>
+	void encode(size_t symbol, Encoder& encoder);
+
+	// Decodes a symbol (0..255 or EOF_SYMBOL) and updates the model.
+	template <typename Decoder>
+	size_t decode(Decoder& decoder);
+
+	int order() const { return maxOrder; }
+
+	// The highest number of interval steps used for a single symbol.
+	int maxStepsPerSymbol() const { return maxOrder + 2; }
+
+	size_t restarts() const { return restartCounter; }	// times the arena was full
+
+private:
+	static constexpr uint32_t MAX_TOTAL_FREQUENCY = 0xFFFF;	// context is halved when it is reached
+	static constexpr size_t ORDER_MINUS_ONE_SIZE = 257;			// all bytes and EOF
+
+	struct Entry		// symbol seen in a context
+	{
+		uint32_t child;			// context extended by this symbol (0 if not created yet)
+		uint16_t frequency;
+		uint8_t symbol;
+	};
+
+	struct Context		// node of the trie
+	{
+		uint32_t entries;		// array of Entry (0 if empty)
+		uint32_t suffix;		// context one order lower
+		uint16_t count;			// number of entries
+		uint16_t capacity;
+		uint32_t total;			// sum of frequencies
+	};
+
+	const int maxOrder;
+	const size_t arenaSize;
+	std::unique_ptr<uint64_t[]> arena;	// untouched until used
+	size_t arenaTop;
+	size_t restartCounter = 0;
+
+	uint32_t contexts[MAX_ORDER + 1];	// contexts[k] is the last k bytes (0 if it doesn't exist yet)
+	int highestOrder;					// the longest existing context
+	uint64_t excluded[(ORDER_MINUS_ONE_SIZE + 63) / 64];	// bit set of symbols excluded from the lower orders
+
+	Context& context(uint32_t offset) { return *(Context*)((uint8_t*)arena.get() + offset); }
+	Entry* entries(const Context& context) { return (Entry*)((uint8_t*)arena.get() + context.entries); }
+
+	bool isExcluded(size_t symbol) const { return (excluded[symbol >> 6] >> (symbol & 63)) & 1; }
+	void exclude(size_t symbol) { excluded[symbol >> 6] |= uint64_t(1) << (symbol & 63); }
+
+	void restart();
+	uint32_t allocate(size_t bytes);				// returns 0 if the arena is full
+	uint32_t newContext(uint32_t suffix);
+	Entry* findOrAdd(uint32_t context, uint8_t symbol);	// nullptr if the arena is full
+	void update(size_t symbol, int foundOrder);
+	bool tryUpdate(size_t symbol, int foundOrder);
+};
+
+template <typename Encoder>
+void PPMModel::encode(size_t symbol, Encoder& encoder)
+{
+	std::fill(std::begin(excluded), std::end(excluded), 0);
+	int foundOrder = -1;
+
+	for (int k = highestOrder; k >= 0 && foundOrder < 0; k--)
+	{
+		Context& c = context(contexts[k]);
+		Entry* list = entries(c);
+
+		uint32_t total = 0, begin = 0, frequency = 0, escape = 0;
+		for (uint16_t i = 0; i < c.count; i++)
+		{
+			if (isExcluded(list[i].symbol))
+				continue;
+			if (list[i].symbol == symbol) {
+				begin = total;
+				frequency = list[i].frequency;
+			}
+			total += list[i].frequency;
+			escape++;		// method C: escape count is the number of distinct symbols
+		}
+		if (escape == 0)
+			continue;		// nothing to choose from
+
+		if (frequency != 0) {
+			encoder.encode(begin, begin + frequency, total + escape);
+			foundOrder = k;
+		}
+		else {
+			encoder.encode(total, total + escape, total + escape);
+			for (uint16_t i = 0; i < c.count; i++)
+				exclude(list[i].symbol);
+		}
+	}
+
+	if (foundOrder < 0)		// order -1: every symbol not excluded is equally likely
+	{
+		uint32_t rank = 0, total = 0;
+		for (size_t s = 0; s < ORDER_MINUS_ONE_SIZE; s++)
+		{
+			if (isExcluded(s))
+				continue;
+			rank += s < symbol;
+			total++;
+		}
+		encoder.encode(rank, rank + 1, total);
+	}
+
+	if (symbol != EOF_SYMBOL)
+		update(symbol, foundOrder);
+}
+
+template <typename Decoder>
+size_t PPMModel::decode(Decoder& decoder)
+{
+	std::fill(std::begin(excluded), std::end(excluded), 0);
+
+	for (int k = highestOrder; k >= 0; k--)
+	{
+		Context& c = context(contexts[k]);
+		Entry* list = entries(c);
+
+		uint32_t total = 0, escape = 0;
+		for (uint16_t i = 0; i < c.count; i++)
+		{
+			if (!isExcluded(list[i].symbol)) {
+				total += list[i].frequency;
+				escape++;
+			}
+		}
+		if (escape == 0)
+			continue;
+
+		uint64_t count = decoder.count(total + escape);
+		if (count < total)
+		{
+			uint32_t begin = 0;
+			for (uint16_t i = 0; i < c.count; i++)
+			{
+				if (isExcluded(list[i].symbol))
+					continue;
+				if (count < begin + list[i].frequency) {
+					size_t symbol = list[i].symbol;
+					decoder.decode(begin, begin + list[i].frequency, total + escape);
+					update(symbol, k);
+					return symbol;
+				}
+				begin += list[i].frequency;
+			}
+		}
+
+		decoder.decode(total, total + escape, total + escape);
+		for (uint16_t i = 0; i < c.count; i++)
+			exclude(list[i].symbol);
+	}
+
+	// order -1
+	uint32_t total = 0;
+	for (size_t s = 0; s < ORDER_MINUS_ONE_SIZE; s++)
+		total += !isExcluded(s);
+
+	uint64_t rank = decoder.count(total);
+	size_t symbol = 0;
+	for (uint32_t r = 0; ; symbol++)
+	{
+		if (isExcluded(symbol))
+			continue;
+		if (r++ == rank)
+			break;
+	}
+	decoder.decode(rank, rank + 1, total);
+
+	if (symbol != EOF_SYMBOL)
+		update(symbol, -1);
+	return symbol;
+}
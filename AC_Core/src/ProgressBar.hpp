@@ -0,0 +1,96 @@
+#pragma once
+#include "IO/ByteSource.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// Progress of coding printed in place on standard output. Does nothing if disabled.
+class ProgressBar
+{
+public:
+	ProgressBar(bool enabled)
+		: enabled(enabled) {}
+
+	void update(double progress)
+	{
+		if (!enabled || int(progress * 100.0) == currentProgress)
+			return;
+
+		currentProgress = std::min(int(progress * 100.0), 100);
+
+		std::cout << "[";
+		int pos = (int)((double)progressbarWidth * progress);
+		for (int i = 0; i < (int)progressbarWidth; ++i) {
+			if (i < pos) std::cout << "=";
+			else if (i == pos) std::cout << ">";
+			else std::cout << " ";
+		}
+		std::cout << "] " << currentProgress << " %\r";
+		std::cout.flush();
+	}
+
+	// For data of unknown size (e.g. a pipe): only the amount done, in MiB.
+	void updateBytes(uint64_t bytes)
+	{
+		if (!enabled || bytes >> 20 == currentMebibytes)
+			return;
+
+		currentMebibytes = bytes >> 20;
+		std::cout << currentMebibytes << " MiB\r";
+		std::cout.flush();
+	}
+
+	void clear()
+	{
+		if (enabled)
+		{
+			std::cout << std::string(progressbarWidth + 8, ' ');
+			std::cout << "\r";
+			std::cout.flush();
+		}
+	}
+
+private:
+	const bool enabled;
+	int currentProgress = 0;
+	uint64_t currentMebibytes = 0;
+	const size_t progressbarWidth = 70;
+};
+
+// Passes on chunks of another source and shows how much of it was read
+// (as a percentage, or as a byte count if the size of the source is unknown).
+// The bar is cleared when the source is destroyed.
+class ProgressSource : public ByteSource
+{
+public:
+	ProgressSource(ByteSource& source, bool enabled)
+		: source(source), progress(enabled), filesize(source.size()) {}
+
+	size_t next(const uint8_t*& data) override
+	{
+		size_t size = source.next(data);
+		if (size > 0) {
+			bytesRead += size;
+			if (filesize > 0)
+				progress.update((double)(bytesRead) / filesize);
+			else
+				progress.updateBytes(bytesRead);
+		}
+		return size;
+	}
+
+	long long size() const override { return filesize; }
+
+	~ProgressSource()
+	{
+		progress.clear();
+	}
+
+private:
+	ByteSource& source;
+	ProgressBar progress;
+	long long filesize;
+	uint64_t bytesRead = 0;
+};
@@ -0,0 +1,221 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+#include "IO/ByteSink.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Binary range coder in the style of LZMA's rc: every decision splits the
+// 32-bit range in proportion to a 12-bit probability of '0'. There is no
+// division and no search; the probability is adapted by a shift.
+//
+// A carry out of 'low' can only change the last byte that is not written
+// yet (and the 0xFF bytes after it), so the encoder keeps that byte back
+// and never touches bytes already passed to the sink.
+struct BinaryProbability
+{
+	static constexpr int BITS = 12;
+	static constexpr uint16_t ONE = 1 << BITS;
+	static constexpr uint16_t INITIAL = ONE / 2;
+	static constexpr int ADAPTATION_SHIFT = 5;		// higher adapts slower but more precisely
+
+	static void update(uint16_t& probability, int bit)
+	{
+		if (bit == 0)
+			probability += (ONE - probability) >> ADAPTATION_SHIFT;
+		else
+			probability -= probability >> ADAPTATION_SHIFT;
+	}
+};
+
+class RangeEncoder
+{
+public:
+	static constexpr uint32_t TOP = 1 << 24;
+
+	RangeEncoder(ByteWriter& out)
+		: out(out) {}
+
+	// Codes a bit with the probability of '0' and adapts it.
+	inline void encodeBit(uint16_t& probability, int bit)
+	{
+		encode(bit, probability);
+		BinaryProbability::update(probability, bit);
+	}
+
+	// Codes a bit with the given probability of '0' (1..ONE-1), for models
+	// that compute probabilities on their own.
+	inline void encode(int bit, uint32_t probability)
+	{
+		uint32_t bound = (range >> BinaryProbability::BITS) * probability;
+		if (bit == 0)
+			range = bound;
+		else {
+			low += bound;
+			range -= bound;
+		}
+		normalize();
+	}
+
+	// Codes a bit whose probability of '1' is fixed at 2^-shift (shift <= 16).
+	inline void encodeRare(int bit, int shift)
+	{
+		uint32_t bound = range >> shift;
+		if (bit != 0)
+			range = bound;
+		else {
+			low += bound;
+			range -= bound;
+		}
+		normalize();
+	}
+
+	void finish()	// writes out 'low', the writer is not flushed
+	{
+		for (int i = 0; i < 5; i++)
+			shiftLow();
+	}
+
+	uint64_t bytesWritten() const { return written; }
+
+private:
+	ByteWriter& out;
+	uint64_t low = 0;				// 33 bits: bit 32 is the carry
+	uint32_t range = 0xFFFFFFFF;
+	uint8_t cache = 0;				// byte kept back for a carry
+	uint64_t cacheSize = 1;			// the cache and 0xFF bytes after it
+	uint64_t written = 0;
+
+	inline void normalize()
+	{
+		while (range < TOP) {
+			range <<= 8;
+			shiftLow();
+		}
+	}
+
+	void shiftLow()
+	{
+		if ((uint32_t)low < 0xFF000000 || (low >> 32) != 0)
+		{
+			uint8_t carry = (uint8_t)(low >> 32);
+			uint8_t byte = cache;
+			do {
+				out.put((uint8_t)(byte + carry));
+				byte = 0xFF;
+				written++;
+			} while (--cacheSize != 0);
+			cache = (uint8_t)(low >> 24);
+		}
+		cacheSize++;
+		low = (low & 0x00FFFFFF) << 8;
+	}
+};
+
+// Reads from a buffer that the caller keeps filled: every decision takes at
+// most MAX_BYTES_PER_BIT bytes. The first byte written by the encoder is always 0.
+class RangeDecoder
+{
+public:
+	static constexpr uint32_t TOP = RangeEncoder::TOP;
+	static constexpr int START_BYTES = 5;
+	static constexpr int MAX_BYTES_PER_BIT = 2;
+
+	void start(const uint8_t*& in)
+	{
+		in++;
+		for (int i = 0; i < 4; i++)
+			code = (code << 8) | *in++;
+	}
+
+	inline int decodeBit(uint16_t& probability, const uint8_t*& in)
+	{
+		int bit = decode(probability, in);
+		BinaryProbability::update(probability, bit);
+		return bit;
+	}
+
+	inline int decode(uint32_t probability, const uint8_t*& in)
+	{
+		uint32_t bound = (range >> BinaryProbability::BITS) * probability;
+		int bit;
+		if (code < bound) {
+			range = bound;
+			bit = 0;
+		}
+		else {
+			code -= bound;
+			range -= bound;
+			bit = 1;
+		}
+		normalize(in);
+		return bit;
+	}
+
+	inline int decodeRare(int shift, const uint8_t*& in)
+	{
+		uint32_t bound = range >> shift;
+		int bit;
+		if (code < bound) {
+			range = bound;
+			bit = 1;
+		}
+		else {
+			code -= bound;
+			range -= bound;
+			bit = 0;
+		}
+		normalize(in);
+		return bit;
+	}
+
+private:
+	uint32_t code = 0;
+	uint32_t range = 0xFFFFFFFF;
+
+	inline void normalize(const uint8_t*& in)
+	{
+		while (range < TOP) {
+			range <<= 8;
+			code = (code << 8) | *in++;
+		}
+	}
+};
+
+// Bytes fed to a push-based range decoder and not decoded yet. The decoder
+// reads [begin(), end()) and consumes what it has read.
+//
+// After the end of data the missing bytes are padding, which a valid
+// stream ends before it needs. It is made of ones, as zeros would bring the
+// code close to the end marker.
+class RangeDecoderInput
+{
+public:
+	bool isFinished() const { return finished; }
+
+	void feed(const uint8_t* data, size_t size)
+	{
+		buffer.insert(buffer.end(), data, data + size);
+	}
+
+	void finish(size_t padding)		// no more data
+	{
+		finished = true;
+		buffer.insert(buffer.end(), padding, 0xFF);
+	}
+
+	const uint8_t* begin() const { return buffer.data(); }
+	const uint8_t* end() const { return buffer.data() + buffer.size(); }
+
+	void consume(const uint8_t* upTo)
+	{
+		buffer.erase(buffer.begin(), buffer.begin() + (upTo - buffer.data()));
+	}
+
+private:
+	std::vector<uint8_t> buffer;
+	bool finished = false;
+};
@@ -0,0 +1,223 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#include "RansCoder.hpp"
+#include "ProgressBar.hpp"
+#include "StaticModel.hpp"
+#include "StreamHeader.hpp"
+#include "IO/LittleEndian.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	constexpr int TOTAL_BITS = StaticModel::TOTAL_BITS;
+	constexpr uint32_t SLOT_MASK = StaticModel::TOTAL_FREQUENCY - 1;
+	constexpr uint32_t LOWER_BOUND = RansCoder::LOWER_BOUND;
+	constexpr size_t PADDING = 2 * RansCoder::MAX_STATES + 2;	// the decoder checks the end once per round of states
+	static_assert(LOWER_BOUND % StaticModel::TOTAL_FREQUENCY == 0, "states must stay in 32 bits");
+
+	// A symbol takes at most 2 bytes (its frequency is at least 1 of 2^15).
+	size_t maxEncodedSize(size_t size, int states)
+	{
+		return 2 * size + 4 * (size_t)states;
+	}
+
+	// Codes the chunk backwards, so the decoder reads the bytes forwards.
+	template <int States>
+	void encodeChunk(const uint8_t* data, size_t size, const StaticModel& model, std::vector<uint8_t>& out, std::vector<BitStat>& stats)
+	{
+		std::vector<uint8_t> buffer(maxEncodedSize(size, States));
+		uint8_t* const end = buffer.data() + buffer.size();
+		uint8_t* p = end;
+
+		uint32_t x[States];
+		for (uint32_t& state : x)
+			state = LOWER_BOUND;
+
+		for (size_t i = size; i-- > 0; )
+		{
+			uint32_t& state = x[i % States];
+			uint8_t symbol = data[i];
+			uint32_t frequency = (uint32_t)model.frequency(symbol);
+			uint8_t* before = p;
+
+			// make room for the symbol: the result must stay below 256 * LOWER_BOUND
+			uint32_t limit = ((LOWER_BOUND >> TOTAL_BITS) << 8) * frequency;
+			while (state >= limit) {
+				*--p = (uint8_t)state;
+				state >>= 8;
+			}
+			state = ((state / frequency) << TOTAL_BITS) + state % frequency + (uint32_t)model.frequencyBegin(symbol);
+
+			// for statistics purposes
+			stats[symbol].readCounter += 8;
+			stats[symbol].writeCounter += 8 * (before - p);
+		}
+
+		for (int k = States - 1; k >= 0; k--) {
+			p -= 4;
+			putLittleEndian<uint32_t>(p, x[k]);
+		}
+		out.insert(out.end(), p, end);
+	}
+
+	// 'in' holds 'size' encoded bytes followed by PADDING readable bytes.
+	template <int States>
+	void decodeChunk(const uint8_t* in, size_t size, const StaticModel& model, uint8_t* out, size_t outSize)
+	{
+		if (size < 4 * States)
+			throw std::runtime_error("encoded data is truncated or corrupted");
+
+		uint32_t x[States];
+		for (int k = 0; k < States; k++) {
+			x[k] = getLittleEndian<uint32_t>(in + 4 * k);
+			if (x[k] < LOWER_BOUND || x[k] >= 256 * LOWER_BOUND)
+				throw std::runtime_error("encoded data is truncated or corrupted");
+		}
+
+		const uint8_t* p = in + 4 * States;
+		const uint8_t* const end = in + size;
+
+		// Tables in locals: stores of the output bytes could alias the model otherwise.
+		uint32_t begins[StaticModel::NUMBER_OF_SYMBOLS + 1];
+		for (size_t s = 0; s <= StaticModel::NUMBER_OF_SYMBOLS; s++)
+			begins[s] = (uint32_t)model.frequencyBegin(s);
+		const uint16_t* lookup = model.lookupTable();
+
+		// A symbol takes 0, 1 or 2 bytes. Whether it takes any is hard to
+		// predict, so the next 2 bytes are always read and shifted in as needed.
+		auto decodeSymbol = [&](uint32_t& state) {
+			uint32_t slot = state & SLOT_MASK;
+			uint32_t symbol = lookup[slot];
+			state = (begins[symbol + 1] - begins[symbol]) * (state >> TOTAL_BITS) + slot - begins[symbol];
+
+			uint32_t bytes = (state < LOWER_BOUND) + (state < (LOWER_BOUND >> 8));
+			uint32_t next = (uint32_t)p[0] << 8 | p[1];
+			state = state << (8 * bytes) | next >> (8 * (2 - bytes));
+			p += bytes;
+			return (uint8_t)symbol;
+		};
+
+		size_t i = 0;
+		for (; i + States <= outSize; i += States)
+		{
+			for (int k = 0; k < States; k++)	// independent of each other
+				out[i + k] = decodeSymbol(x[k]);
+			if (p > end)
+				throw std::runtime_error("encoded data is truncated or corrupted");
+		}
+		for (; i < outSize; i++)
+			out[i] = decodeSymbol(x[i % States]);
+
+		// the encoder started from LOWER_BOUND and used every byte
+		bool valid = p == end;
+		for (uint32_t state : x)
+			valid &= state == LOWER_BOUND;
+		if (!valid)
+			throw std::runtime_error("encoded data is truncated or corrupted");
+	}
+
+	using EncodeChunk = void (*)(const uint8_t*, size_t, const StaticModel&, std::vector<uint8_t>&, std::vector<BitStat>&);
+	using DecodeChunk = void (*)(const uint8_t*, size_t, const StaticModel&, uint8_t*, size_t);
+
+	// indexed by the number of states
+	const EncodeChunk CHUNK_ENCODERS[] = { nullptr, nullptr,
+		encodeChunk<2>, encodeChunk<3>, encodeChunk<4>, encodeChunk<5>, encodeChunk<6>, encodeChunk<7>, encodeChunk<8> };
+	const DecodeChunk CHUNK_DECODERS[] = { nullptr, nullptr,
+		decodeChunk<2>, decodeChunk<3>, decodeChunk<4>, decodeChunk<5>, decodeChunk<6>, decodeChunk<7>, decodeChunk<8> };
+}
+
+RansCoder::RansCoder(int states, bool printProgress)
+	: states(states), printProgress(printProgress)
+{
+	if (states < MIN_STATES || states > MAX_STATES)
+		throw std::invalid_argument("number of rANS states must be between 2 and 8");
+}
+
+Statistics RansCoder::encode(ByteSource& source, ByteSink& out)
+{
+	ProgressSource progress(source, printProgress);
+	ByteReader in(progress);
+	std::vector<BitStat> stats(256);
+
+	uint8_t header[StreamHeader::SIZE + 1];
+	StreamHeader streamHeader;
+	streamHeader.format = StreamFormat::Rans;
+	streamHeader.serialize(header);
+	header[StreamHeader::SIZE] = (uint8_t)states;
+	out.write(header, sizeof(header));
+
+	std::vector<uint8_t> chunk(CHUNK_SIZE);
+	std::vector<uint8_t> encoded;
+	while (size_t size = in.read(chunk.data(), CHUNK_SIZE))
+	{
+		uint64_t counts[256] = {};
+		StaticModel::countBytes(chunk.data(), size, counts);
+		StaticModel model(counts);
+
+		encoded.resize(4);
+		putLittleEndian<uint32_t>(encoded.data(), (uint32_t)size);
+		model.serialize(encoded);
+
+		size_t sizeOffset = encoded.size();
+		encoded.resize(sizeOffset + 4);
+		CHUNK_ENCODERS[states](chunk.data(), size, model, encoded, stats);
+		putLittleEndian<uint32_t>(encoded.data() + sizeOffset, (uint32_t)(encoded.size() - sizeOffset - 4));
+		out.write(encoded.data(), encoded.size());
+	}
+
+	uint8_t endMarker[4] = {};
+	out.write(endMarker, 4);
+	out.flush();
+	return Statistics(stats);
+}
+
+void RansCoder::decode(ByteSource& source, ByteSink& out)
+{
+	ProgressSource progress(source, printProgress);
+	ByteReader in(progress);
+
+	uint8_t header[StreamHeader::SIZE + 1] = {};
+	in.read(header, sizeof(header));
+	StreamHeader streamHeader;
+	if (!streamHeader.deserialize(header) || streamHeader.format != StreamFormat::Rans)
+		throw std::runtime_error("data was encoded in a different format");
+	int states = header[StreamHeader::SIZE];
+	if (states < MIN_STATES || states > MAX_STATES)
+		throw std::runtime_error("encoded data is truncated or corrupted");
+
+	std::vector<uint8_t> table(StaticModel::MAX_SERIALIZED_SIZE);
+	std::vector<uint8_t> encoded;
+	std::vector<uint8_t> decoded;
+	while (true)
+	{
+		uint8_t sizeBytes[4];
+		readExactly(in, sizeBytes, 4);
+		size_t size = getLittleEndian<uint32_t>(sizeBytes);
+		if (size == 0)
+			break;	// end marker
+		if (size > CHUNK_SIZE)
+			throw std::runtime_error("encoded data is truncated or corrupted");
+
+		readExactly(in, table.data(), StaticModel::BIT_SET_SIZE);
+		size_t tableSize = StaticModel::serializedSize(table.data());
+		readExactly(in, table.data() + StaticModel::BIT_SET_SIZE, tableSize - StaticModel::BIT_SET_SIZE);
+		StaticModel model(table.data(), tableSize);
+
+		readExactly(in, sizeBytes, 4);
+		size_t encodedSize = getLittleEndian<uint32_t>(sizeBytes);
+		if (encodedSize > maxEncodedSize(size, states))
+			throw std::runtime_error("encoded data is truncated or corrupted");
+		encoded.assign(encodedSize + PADDING, 0);
+		readExactly(in, encoded.data(), encodedSize);
+
+		decoded.resize(size);
+		CHUNK_DECODERS[states](encoded.data(), encodedSize, model, decoded.data(), size);
+		out.write(decoded.data(), size);
+	}
+
+	out.flush();
+}
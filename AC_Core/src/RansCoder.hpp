@@ -0,0 +1,52 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+#include "ArithmeticCoder.hpp"
+#include "Statistics.hpp"
+
+// Range variant of asymmetric numeral systems (rANS) with a static order-0
+// model: the fastest coder, meant for data that is decoded often.
+//
+// The state is a 32-bit integer kept in [LOWER_BOUND, 256 * LOWER_BOUND) by
+// moving whole bytes in and out, so a symbol costs a table lookup, a multiply
+// and at most two byte reads to decode. Consecutive symbols are coded with
+// 2 to 8 independent states in turn (symbol i with state i mod states), which
+// lets the CPU work on several of them at once.
+//
+// rANS decodes in the reverse order of encoding, so the input is coded in
+// chunks of CHUNK_SIZE bytes, each with its own frequency table (see
+// StaticModel; its end of data symbol is never coded). Layout (integers
+// are little-endian):
+//
+//   StreamHeader            "AC", StreamFormat::Rans, flags
+//   number of states        uint8
+//   for every chunk:
+//     original size         uint32 (1 .. CHUNK_SIZE)
+//     frequency table       see StaticModel::serialize
+//     encoded size          uint32
+//     final states          uint32 each, the first state first
+//     bytes of the states   in the order the decoder reads them
+//   end marker              uint32 equal to 0
+class RansCoder : public ArithmeticCoder
+{
+public:
+	static constexpr int MIN_STATES = 2;
+	static constexpr int MAX_STATES = 8;
+	static constexpr int DEFAULT_STATES = 4;
+	static constexpr size_t CHUNK_SIZE = 1 << 20;
+	static constexpr uint32_t LOWER_BOUND = 1 << 23;
+
+	// Decoding ignores the number of states, it is read from the data.
+	RansCoder(int states = DEFAULT_STATES, bool printProgress = false);
+	using ArithmeticCoder::encode;
+	using ArithmeticCoder::decode;
+
+	Statistics encode(ByteSource& in, ByteSink& out) override;
+	void decode(ByteSource& in, ByteSink& out) override;
+
+private:
+	int states;
+	bool printProgress;
+};
@@ -0,0 +1,188 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#include "RunLengthCoder.hpp"
+#include "SlotCoding.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace SlotCoding;
+
+namespace
+{
+	constexpr uint32_t MAX_LENGTH = (uint32_t)(RunLengthCoder::MAX_RUN - RunLengthCoder::MIN_RUN);
+
+	// Returns the end of the run of 'byte' starting at data[begin], comparing
+	// whole words first.
+	size_t runEnd(const uint8_t* data, size_t begin, size_t size, uint8_t byte)
+	{
+		const uint64_t pattern = 0x0101010101010101ull * byte;
+		size_t i = begin;
+		for (; i + 8 <= size; i += 8) {
+			uint64_t word;
+			std::memcpy(&word, data + i, sizeof(word));
+			if (word != pattern)
+				break;
+		}
+		while (i < size && data[i] == byte)
+			i++;
+		return i;
+	}
+}
+
+RunLengthCoder::RunLengthCoder(bool printProgress)
+	: printProgress(printProgress)
+{
+}
+
+Statistics RunLengthCoder::encode(ByteSource& in, ByteSink& out)
+{
+	Encoder encoder(out);
+	return encodeWith(in, encoder, printProgress);
+}
+
+void RunLengthCoder::decode(ByteSource& in, ByteSink& out)
+{
+	Decoder decoder(out);
+	decodeWith(in, decoder, printProgress);
+}
+
+RunLengthCoder::Encoder::Encoder(ByteSink& sink)
+	: out(sink), interval(out),
+	model(MODEL_SIZE, IntervalBounds<PRECISION>::MAX_TOTAL_FREQUENCY),
+	lengths(slotCount(MAX_LENGTH), LENGTH_MAX_FREQUENCY)
+{
+	StreamHeader header;
+	header.format = StreamFormat::RunLength;
+	uint8_t bytes[StreamHeader::SIZE];
+	header.serialize(bytes);
+	for (uint8_t byte : bytes)
+		out.writeByte(byte);
+}
+
+void RunLengthCoder::Encoder::feed(const uint8_t* data, size_t size)
+{
+	if (finished)
+		throw std::logic_error("cannot feed finished encoder");
+
+	size_t i = 0;
+	while (i < size)
+	{
+		if (data[i] == previous)
+		{
+			size_t end = runEnd(data, i, size, data[i]);
+			repeats += end - i;
+			i = end;
+			if (repeats >= MAX_RUN)
+				encodeRepeats();
+			continue;
+		}
+
+		if (repeats > 0)
+			encodeRepeats();
+		out.beginByte(data[i]);		// for statistics purposes
+		encodeSymbol(interval, model, data[i]);
+		previous = data[i];
+		i++;
+	}
+}
+
+Statistics RunLengthCoder::Encoder::finish()
+{
+	if (!finished)
+	{
+		if (repeats > 0)
+			encodeRepeats();
+		encodeSymbol(interval, model, EOF_SYMBOL);
+		interval.finish();
+		out.flush();
+		finished = true;
+	}
+	return Statistics(out.getStats());
+}
+
+// Codes the repeats of the previous byte: as a run if there are enough,
+// otherwise one by one.
+void RunLengthCoder::Encoder::encodeRepeats()
+{
+	while (repeats >= MIN_RUN)
+	{
+		uint64_t run = std::min(repeats, MAX_RUN);
+		out.beginByte(previous, run);
+		encodeSymbol(interval, model, RUN_SYMBOL);
+		encodeValue(interval, lengths, (uint32_t)(run - MIN_RUN));
+		repeats -= run;
+	}
+	for (; repeats > 0; repeats--)
+	{
+		out.beginByte(previous);
+		encodeSymbol(interval, model, previous);
+	}
+}
+
+RunLengthCoder::Decoder::Decoder(ByteSink& sink)
+	: in(source), interval(in), out(sink),
+	model(MODEL_SIZE, IntervalBounds<PRECISION>::MAX_TOTAL_FREQUENCY),
+	lengths(slotCount(MAX_LENGTH), LENGTH_MAX_FREQUENCY),
+	maxSymbolBits((1 + maxSteps(MAX_LENGTH)) * PRECISION)
+{
+}
+
+void RunLengthCoder::Decoder::feed(const uint8_t* data, size_t size)
+{
+	if (endOfStream || bits.isFinished())
+		return;		// everything after EOF symbol is ignored
+
+	source.push(data, size);
+	bits.feed(size);
+	decodeAvailable();
+	out.flush();
+}
+
+void RunLengthCoder::Decoder::finish()
+{
+	bits.finish();
+	decodeAvailable();
+	out.flush();
+}
+
+void RunLengthCoder::Decoder::decodeAvailable()
+{
+	if (!started)
+	{
+		// header and 'z'
+		if (!bits.canStart(8 * StreamHeader::SIZE))
+			return;
+
+		StreamHeader header;
+		uint8_t bytes[StreamHeader::SIZE];
+		in.peekBytes(bytes, StreamHeader::SIZE);
+		if (!header.deserialize(bytes) || header.format != StreamFormat::RunLength || header.arithmetic != IntervalArithmetic::Integer)
+			throw std::runtime_error("data was encoded in a different format");
+		in.consumeBits(8 * StreamHeader::SIZE);
+
+		headerBits = 8 * StreamHeader::SIZE;
+		interval.start(header.arithmetic);
+		started = true;
+	}
+
+	while (!endOfStream && bits.canDecode(bitsTaken(), maxSymbolBits))
+	{
+		size_t symbol = decodeSymbol(interval, model);
+		if (symbol < RUN_SYMBOL) {
+			out.put((uint8_t)symbol);
+			previous = (int)symbol;
+		}
+		else if (symbol == RUN_SYMBOL) {
+			uint64_t run = decodeValue(interval, lengths) + MIN_RUN;
+			if (previous < 0)
+				throw std::runtime_error("encoded data is truncated or corrupted");
+			out.fill((uint8_t)previous, run);
+		}
+		else
+			endOfStream = true;
+		bits.checkTaken(bitsTaken());
+	}
+}
@@ -0,0 +1,103 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+#include "ArithmeticCoder.hpp"
+#include "FenwickModel.hpp"
+#include "GroupedModel.hpp"
+#include "IntervalCoder.hpp"
+#include "Statistics.hpp"
+#include "StreamHeader.hpp"
+#include "BitUtils/BitWriter.hpp"
+#include "BitUtils/BitReader.hpp"
+
+#include <cstdint>
+#include <limits>
+
+// Order-0 coder with a fast path for runs of the same byte. Bytes are coded
+// like in AdaptiveScalingCoder, but when a byte repeats at least MIN_RUN
+// times after it was coded, the repeats are coded as a RUN symbol of the byte
+// model and their number with a model of its own (see SlotCoding.hpp).
+// Runs are found a word at a time and cost the same regardless of their
+// length, so sparse files and padding are coded at nearly memory speed.
+//
+// There are no parameters after the stream header.
+class RunLengthCoder : public ArithmeticCoder
+{
+public:
+	static constexpr uint64_t PRECISION = 32;
+	static constexpr uint64_t MIN_RUN = 8;
+	static constexpr uint64_t MAX_RUN = MIN_RUN + std::numeric_limits<uint32_t>::max();
+
+	static constexpr size_t RUN_SYMBOL = 256;
+	static constexpr size_t EOF_SYMBOL = 257;
+	static constexpr size_t MODEL_SIZE = 258;
+	static constexpr size_t LENGTH_MAX_FREQUENCY = 1 << 16;	// low, so the model follows local statistics
+
+	class Encoder;
+	class Decoder;
+
+	RunLengthCoder(bool printProgress = false);
+	using ArithmeticCoder::encode;
+	using ArithmeticCoder::decode;
+
+	Statistics encode(ByteSource& in, ByteSink& out) override;
+	void decode(ByteSource& in, ByteSink& out) override;
+
+private:
+	bool printProgress;
+};
+
+// Push-based encoder. Repeats of the last coded byte are only counted, also
+// across calls, and coded when the run ends or in finish().
+class RunLengthCoder::Encoder
+{
+public:
+	Encoder(ByteSink& sink);
+
+	void feed(const uint8_t* data, size_t size);
+	Statistics finish();	// encodes the last run and EOF symbol and flushes the sink
+
+private:
+	BitWriter out;
+	IntervalEncoder<PRECISION> interval;
+	FenwickModel model;
+	FenwickModel lengths;
+	bool finished = false;
+
+	int previous = -1;		// the last coded byte
+	uint64_t repeats = 0;	// of previous, not coded yet
+
+	void encodeRepeats();
+};
+
+// Push-based decoder. A symbol is decoded only when the bits of the longest
+// run length are fed too, and a run is written out at once.
+class RunLengthCoder::Decoder
+{
+public:
+	Decoder(ByteSink& sink);
+
+	void feed(const uint8_t* data, size_t size);
+	void finish();		// no more data: decodes the rest assuming '0' bits after the end
+	bool done() const { return endOfStream; }
+
+private:
+	QueueSource source;
+	BitReader in;
+	IntervalDecoder<PRECISION> interval;
+	ByteWriter out;
+	GroupedModel model;
+	GroupedModel lengths;
+	int previous = -1;
+
+	BitBudget<PRECISION> bits;
+	uint64_t headerBits = 0;
+	bool started = false;
+	bool endOfStream = false;
+	uint64_t maxSymbolBits;		// a run takes the most
+
+	uint64_t bitsTaken() const { return headerBits + interval.bitsTaken(); }
+	void decodeAvailable();
+};
@@ -0,0 +1,411 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#include "SimdKernels.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define AC_SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AC_TARGET_AVX2
+#else
+#define AC_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#endif
+#endif
+
+using InstructionSet = SimdKernels::InstructionSet;
+
+namespace
+{
+	// Scalar versions also finish the last few elements of the vector ones.
+
+	template <typename T, typename Sum>
+	Sum halveScalar(T* counters, size_t n, Sum sum)
+	{
+		for (size_t i = 0; i < n; i++) {
+			T half = counters[i] / 2;
+			counters[i] = half != 0 ? half : 1;
+			sum += counters[i];
+		}
+		return sum;
+	}
+
+	template <typename T>
+	void prefixSumScalar(T* values, size_t n, T carry)
+	{
+		for (size_t i = 0; i < n; i++) {
+			carry = (T)(carry + values[i]);
+			values[i] = carry;
+		}
+	}
+
+	void addCountsScalar(uint64_t* total, const uint32_t* part, size_t n)
+	{
+		for (size_t i = 0; i < n; i++)
+			total[i] += part[i];
+	}
+
+	size_t countGreaterScalar(const uint32_t* values, size_t n, uint32_t value)
+	{
+		size_t count = 0;
+		for (size_t i = 0; i < n; i++)
+			count += values[i] > value;
+		return count;
+	}
+
+#ifdef AC_SIMD_X86
+
+	InstructionSet detect()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return InstructionSet::SSE2;
+		__cpuid(info, 1);
+		bool osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;	// OSXSAVE, AVX
+		__cpuidex(info, 7, 0);
+		bool avx2 = (info[1] & (1 << 5)) != 0;
+		return osSavesYmm && avx2 ? InstructionSet::AVX2 : InstructionSet::SSE2;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") ? InstructionSet::AVX2 : InstructionSet::SSE2;
+#endif
+	}
+
+	// --- SSE2 ---
+
+	uint64_t halveSSE2(uint32_t* counters, size_t n)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		__m128i sum = zero;		// 2 x 64 bits
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			__m128i half = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(counters + i)), 1);
+			half = _mm_sub_epi32(half, _mm_cmpeq_epi32(half, zero));	// 0 - (-1) = 1
+			_mm_storeu_si128((__m128i*)(counters + i), half);
+			sum = _mm_add_epi64(sum, _mm_add_epi64(_mm_unpacklo_epi32(half, zero), _mm_unpackhi_epi32(half, zero)));
+		}
+		uint64_t lanes[2];
+		_mm_storeu_si128((__m128i*)lanes, sum);
+		return halveScalar(counters + i, n - i, lanes[0] + lanes[1]);
+	}
+
+	uint64_t halveSSE2(uint16_t* counters, size_t n)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		__m128i sum = zero;		// 4 x 32 bits, enough for fewer than 65536 counters
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+		{
+			__m128i half = _mm_srli_epi16(_mm_loadu_si128((const __m128i*)(counters + i)), 1);
+			half = _mm_sub_epi16(half, _mm_cmpeq_epi16(half, zero));
+			_mm_storeu_si128((__m128i*)(counters + i), half);
+			sum = _mm_add_epi32(sum, _mm_add_epi32(_mm_unpacklo_epi16(half, zero), _mm_unpackhi_epi16(half, zero)));
+		}
+		uint32_t lanes[4];
+		_mm_storeu_si128((__m128i*)lanes, sum);
+		return halveScalar(counters + i, n - i, (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+	}
+
+	// Prefix sums within a register take log2(lanes) shifted additions; the
+	// last element of the previous register is then added to all of them.
+	void prefixSumSSE2(uint32_t* values, size_t n)
+	{
+		__m128i carry = _mm_setzero_si128();
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			__m128i x = _mm_loadu_si128((const __m128i*)(values + i));
+			x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+			x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+			x = _mm_add_epi32(x, carry);
+			_mm_storeu_si128((__m128i*)(values + i), x);
+			carry = _mm_shuffle_epi32(x, 0xFF);
+		}
+		prefixSumScalar(values + i, n - i, (uint32_t)_mm_cvtsi128_si32(carry));
+	}
+
+	void prefixSumSSE2(uint16_t* values, size_t n)
+	{
+		__m128i carry = _mm_setzero_si128();
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+		{
+			__m128i x = _mm_loadu_si128((const __m128i*)(values + i));
+			x = _mm_add_epi16(x, _mm_slli_si128(x, 2));
+			x = _mm_add_epi16(x, _mm_slli_si128(x, 4));
+			x = _mm_add_epi16(x, _mm_slli_si128(x, 8));
+			x = _mm_add_epi16(x, carry);
+			_mm_storeu_si128((__m128i*)(values + i), x);
+			carry = _mm_shufflehi_epi16(x, 0xFF);
+			carry = _mm_unpackhi_epi64(carry, carry);
+		}
+		prefixSumScalar(values + i, n - i, (uint16_t)_mm_cvtsi128_si32(carry));
+	}
+
+	void addCountsSSE2(uint64_t* total, const uint32_t* part, size_t n)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			__m128i x = _mm_loadu_si128((const __m128i*)(part + i));
+			__m128i* t = (__m128i*)(total + i);
+			_mm_storeu_si128(t, _mm_add_epi64(_mm_loadu_si128(t), _mm_unpacklo_epi32(x, zero)));
+			_mm_storeu_si128(t + 1, _mm_add_epi64(_mm_loadu_si128(t + 1), _mm_unpackhi_epi32(x, zero)));
+		}
+		addCountsScalar(total + i, part + i, n - i);
+	}
+
+	// SSE2 compares only signed integers, so both sides are shifted by 2^31.
+	// Compared values are -1 (true) or 0, so subtracting them counts them.
+	size_t upperBoundSSE2(const uint32_t* sorted, size_t n, uint32_t value)
+	{
+		const __m128i bias = _mm_set1_epi32(INT32_MIN);
+		const __m128i bound = _mm_xor_si128(_mm_set1_epi32((int)value), bias);
+		__m128i greater = _mm_setzero_si128();
+		size_t i = 0;
+		for (; i + 16 <= n; i += 16)
+		{
+			const __m128i* p = (const __m128i*)(sorted + i);
+			__m128i a = _mm_cmpgt_epi32(_mm_xor_si128(_mm_loadu_si128(p), bias), bound);
+			__m128i b = _mm_cmpgt_epi32(_mm_xor_si128(_mm_loadu_si128(p + 1), bias), bound);
+			__m128i c = _mm_cmpgt_epi32(_mm_xor_si128(_mm_loadu_si128(p + 2), bias), bound);
+			__m128i d = _mm_cmpgt_epi32(_mm_xor_si128(_mm_loadu_si128(p + 3), bias), bound);
+			greater = _mm_sub_epi32(greater, _mm_add_epi32(_mm_add_epi32(a, b), _mm_add_epi32(c, d)));
+		}
+		uint32_t lanes[4];
+		_mm_storeu_si128((__m128i*)lanes, greater);
+		size_t count = (size_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+		return n - count - countGreaterScalar(sorted + i, n - i, value);
+	}
+
+	// --- AVX2 ---
+
+	AC_TARGET_AVX2 uint64_t halveAVX2(uint32_t* counters, size_t n)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		__m256i sum = zero;		// 4 x 64 bits
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+		{
+			__m256i half = _mm256_srli_epi32(_mm256_loadu_si256((const __m256i*)(counters + i)), 1);
+			half = _mm256_sub_epi32(half, _mm256_cmpeq_epi32(half, zero));
+			_mm256_storeu_si256((__m256i*)(counters + i), half);
+			sum = _mm256_add_epi64(sum, _mm256_add_epi64(_mm256_unpacklo_epi32(half, zero), _mm256_unpackhi_epi32(half, zero)));
+		}
+		uint64_t lanes[4];
+		_mm256_storeu_si256((__m256i*)lanes, sum);
+		return halveScalar(counters + i, n - i, lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+	}
+
+	AC_TARGET_AVX2 uint64_t halveAVX2(uint16_t* counters, size_t n)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		__m256i sum = zero;		// 8 x 32 bits
+		size_t i = 0;
+		for (; i + 16 <= n; i += 16)
+		{
+			__m256i half = _mm256_srli_epi16(_mm256_loadu_si256((const __m256i*)(counters + i)), 1);
+			half = _mm256_sub_epi16(half, _mm256_cmpeq_epi16(half, zero));
+			_mm256_storeu_si256((__m256i*)(counters + i), half);
+			sum = _mm256_add_epi32(sum, _mm256_add_epi32(_mm256_unpacklo_epi16(half, zero), _mm256_unpackhi_epi16(half, zero)));
+		}
+		uint32_t lanes[8];
+		_mm256_storeu_si256((__m256i*)lanes, sum);
+		uint64_t total = 0;
+		for (uint32_t lane : lanes)
+			total += lane;
+		return halveScalar(counters + i, n - i, total);
+	}
+
+	// AVX2 shifts work within 128-bit halves, so the upper half also gets
+	// the last element of the lower one.
+	AC_TARGET_AVX2 void prefixSumAVX2(uint32_t* values, size_t n)
+	{
+		const __m256i last = _mm256_set1_epi32(7);
+		__m256i carry = _mm256_setzero_si256();
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+		{
+			__m256i x = _mm256_loadu_si256((const __m256i*)(values + i));
+			x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+			x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+			__m256i lower = _mm256_permute2x128_si256(x, x, 0x08);	// [ 0 | lower half ]
+			x = _mm256_add_epi32(x, _mm256_shuffle_epi32(lower, 0xFF));
+			x = _mm256_add_epi32(x, carry);
+			_mm256_storeu_si256((__m256i*)(values + i), x);
+			carry = _mm256_permutevar8x32_epi32(x, last);
+		}
+		prefixSumScalar(values + i, n - i, (uint32_t)_mm_cvtsi128_si32(_mm256_castsi256_si128(carry)));
+	}
+
+	AC_TARGET_AVX2 void prefixSumAVX2(uint16_t* values, size_t n)
+	{
+		__m256i carry = _mm256_setzero_si256();
+		size_t i = 0;
+		for (; i + 16 <= n; i += 16)
+		{
+			__m256i x = _mm256_loadu_si256((const __m256i*)(values + i));
+			x = _mm256_add_epi16(x, _mm256_slli_si256(x, 2));
+			x = _mm256_add_epi16(x, _mm256_slli_si256(x, 4));
+			x = _mm256_add_epi16(x, _mm256_slli_si256(x, 8));
+			__m256i lower = _mm256_shufflehi_epi16(_mm256_permute2x128_si256(x, x, 0x08), 0xFF);
+			x = _mm256_add_epi16(x, _mm256_unpackhi_epi64(lower, lower));
+			x = _mm256_add_epi16(x, carry);
+			_mm256_storeu_si256((__m256i*)(values + i), x);
+			carry = _mm256_shufflehi_epi16(x, 0xFF);
+			carry = _mm256_permute4x64_epi64(carry, 0xFF);
+		}
+		prefixSumScalar(values + i, n - i, (uint16_t)_mm_cvtsi128_si32(_mm256_castsi256_si128(carry)));
+	}
+
+	AC_TARGET_AVX2 void addCountsAVX2(uint64_t* total, const uint32_t* part, size_t n)
+	{
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+		{
+			__m256i* t = (__m256i*)(total + i);
+			__m256i low = _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i*)(part + i)));
+			__m256i high = _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i*)(part + i + 4)));
+			_mm256_storeu_si256(t, _mm256_add_epi64(_mm256_loadu_si256(t), low));
+			_mm256_storeu_si256(t + 1, _mm256_add_epi64(_mm256_loadu_si256(t + 1), high));
+		}
+		addCountsScalar(total + i, part + i, n - i);
+	}
+
+	// AVX2 has no unsigned comparison either.
+	AC_TARGET_AVX2 size_t upperBoundAVX2(const uint32_t* sorted, size_t n, uint32_t value)
+	{
+		const __m256i bias = _mm256_set1_epi32(INT32_MIN);
+		const __m256i bound = _mm256_xor_si256(_mm256_set1_epi32((int)value), bias);
+		size_t greater = 0;
+		size_t i = 0;
+		for (; i + 16 <= n; i += 16)
+		{
+			const __m256i* p = (const __m256i*)(sorted + i);
+			__m256i a = _mm256_cmpgt_epi32(_mm256_xor_si256(_mm256_loadu_si256(p), bias), bound);
+			__m256i b = _mm256_cmpgt_epi32(_mm256_xor_si256(_mm256_loadu_si256(p + 1), bias), bound);
+			unsigned mask = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(a))
+				| (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(b)) << 8;
+			greater += _mm_popcnt_u32(mask);
+		}
+		return n - greater - countGreaterScalar(sorted + i, n - i, value);
+	}
+
+#else
+	InstructionSet detect()
+	{
+		return InstructionSet::Scalar;
+	}
+#endif
+
+	const InstructionSet SUPPORTED = detect();
+	std::atomic<InstructionSet> activeSet{ SUPPORTED };
+}
+
+SimdKernels::InstructionSet SimdKernels::supported()
+{
+	return SUPPORTED;
+}
+
+SimdKernels::InstructionSet SimdKernels::active()
+{
+	return activeSet.load(std::memory_order_relaxed);
+}
+
+void SimdKernels::setActive(InstructionSet set)
+{
+	set = set < SUPPORTED ? set : SUPPORTED;
+	activeSet.store(set, std::memory_order_relaxed);
+	scalarOnly.store(set == InstructionSet::Scalar, std::memory_order_relaxed);
+}
+
+const char* SimdKernels::name(InstructionSet set)
+{
+	switch (set)
+	{
+	case InstructionSet::SSE2:	return "SSE2";
+	case InstructionSet::AVX2:	return "AVX2";
+	default:					return "scalar";
+	}
+}
+
+uint64_t SimdKernels::halve(uint32_t* counters, size_t n)
+{
+	switch (active())
+	{
+#ifdef AC_SIMD_X86
+	case InstructionSet::AVX2:	return halveAVX2(counters, n);
+	case InstructionSet::SSE2:	return halveSSE2(counters, n);
+#endif
+	default:					return halveScalar(counters, n, (uint64_t)0);
+	}
+}
+
+uint64_t SimdKernels::halve(uint16_t* counters, size_t n)
+{
+	switch (active())
+	{
+#ifdef AC_SIMD_X86
+	case InstructionSet::AVX2:	return halveAVX2(counters, n);
+	case InstructionSet::SSE2:	return halveSSE2(counters, n);
+#endif
+	default:					return halveScalar(counters, n, (uint64_t)0);
+	}
+}
+
+void SimdKernels::prefixSum(uint32_t* values, size_t n)
+{
+	switch (active())
+	{
+#ifdef AC_SIMD_X86
+	case InstructionSet::AVX2:	prefixSumAVX2(values, n); break;
+	case InstructionSet::SSE2:	prefixSumSSE2(values, n); break;
+#endif
+	default:					prefixSumScalar(values, n, (uint32_t)0);
+	}
+}
+
+void SimdKernels::prefixSum(uint16_t* values, size_t n)
+{
+	switch (active())
+	{
+#ifdef AC_SIMD_X86
+	case InstructionSet::AVX2:	prefixSumAVX2(values, n); break;
+	case InstructionSet::SSE2:	prefixSumSSE2(values, n); break;
+#endif
+	default:					prefixSumScalar(values, n, (uint16_t)0);
+	}
+}
+
+void SimdKernels::addCounts(uint64_t* total, const uint32_t* part, size_t n)
+{
+	switch (active())
+	{
+#ifdef AC_SIMD_X86
+	case InstructionSet::AVX2:	addCountsAVX2(total, part, n); break;
+	case InstructionSet::SSE2:	addCountsSSE2(total, part, n); break;
+#endif
+	default:					addCountsScalar(total, part, n);
+	}
+}
+
+size_t SimdKernels::upperBound(const uint32_t* sorted, size_t n, uint32_t value)
+{
+	switch (active())
+	{
+#ifdef AC_SIMD_X86
+	case InstructionSet::AVX2:	return upperBoundAVX2(sorted, n, value);
+	case InstructionSet::SSE2:	return upperBoundSSE2(sorted, n, value);
+#endif
+	default:					return std::upper_bound(sorted, sorted + n, value) - sorted;
+	}
+}
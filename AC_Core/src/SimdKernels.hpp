@@ -0,0 +1,132 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// Vectorized loops over arrays of counters, shared by the models: halving
+// when a model rescales, cumulative frequencies and merging of histograms.
+//
+// Every kernel has a scalar, an SSE2 and an AVX2 version. The best one the
+// processor supports is chosen at startup (the build needs no special
+// flags), and all of them give exactly the same results, so the choice
+// never changes the encoded data.
+class SimdKernels
+{
+public:
+	enum class InstructionSet
+	{
+		Scalar,
+		SSE2,
+		AVX2
+	};
+
+	static InstructionSet supported();	// the best one of this processor
+	static InstructionSet active();
+
+	// Selects a slower set, e.g. to compare them. Sets the processor doesn't
+	// support are lowered to supported().
+	static void setActive(InstructionSet set);
+	static const char* name(InstructionSet set);
+
+	// counters[i] = max(counters[i] / 2, 1). Returns the sum of the new counters.
+	static uint64_t halve(uint32_t* counters, size_t n);
+	static uint64_t halve(uint16_t* counters, size_t n);	// n < 65536
+
+	// Inclusive prefix sum in place: values[i] = values[0] + ... + values[i],
+	// wrapping around like unsigned integers do.
+	static void prefixSum(uint32_t* values, size_t n);
+	static void prefixSum(uint16_t* values, size_t n);
+
+	// total[i] += part[i]
+	static void addCounts(uint64_t* total, const uint32_t* part, size_t n);
+
+	// Number of values not greater than 'value', i.e. std::upper_bound() in
+	// a sorted array. Vector versions compare all values, 16 at a time, so
+	// there are no data-dependent branches; the scalar one does a binary search.
+	static size_t upperBound(const uint32_t* sorted, size_t n, uint32_t value);
+
+	// Kernels for short arrays on the hot path of a model; n is a multiple
+	// of 4. They are inlined: SSE2 is a part of x86-64, so they need no
+	// dispatch, and wider vectors don't pay off for a few values.
+	// Other sets than Scalar use SSE2.
+
+	// upperBound() of a short sorted array.
+	static size_t upperBoundShort(const uint32_t* sorted, size_t n, uint32_t value);
+
+	// values[i]++ for every begin <= i < end; both may lie outside [0, n).
+	static void increment(uint32_t* values, size_t n, int begin, int end);
+
+private:
+	static inline std::atomic<bool> scalarOnly{ false };	// active() is Scalar; checked by inline kernels
+};
+
+#if defined(__x86_64__) || defined(_M_X64)
+
+inline size_t SimdKernels::upperBoundShort(const uint32_t* sorted, size_t n, uint32_t value)
+{
+	if (scalarOnly.load(std::memory_order_relaxed))
+		return std::upper_bound(sorted, sorted + n, value) - sorted;
+
+	// Compared lanes are -1 (greater) or 0, so subtracting them counts them.
+	const __m128i bias = _mm_set1_epi32(INT32_MIN);		// for unsigned comparison
+	const __m128i bound = _mm_xor_si128(_mm_set1_epi32((int)value), bias);
+	__m128i greater = _mm_setzero_si128();
+	for (size_t i = 0; i < n; i += 4)
+	{
+		__m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(sorted + i)), bias);
+		greater = _mm_sub_epi32(greater, _mm_cmpgt_epi32(x, bound));
+	}
+	greater = _mm_add_epi32(greater, _mm_shuffle_epi32(greater, 0x4E));	// swap halves
+	greater = _mm_add_epi32(greater, _mm_shuffle_epi32(greater, 0xB1));	// swap neighbours
+	return n - (size_t)_mm_cvtsi128_si32(greater);
+}
+
+inline void SimdKernels::increment(uint32_t* values, size_t n, int begin, int end)
+{
+	if (scalarOnly.load(std::memory_order_relaxed)) {
+		for (int i = std::max(begin, 0); i < std::min(end, (int)n); i++)
+			values[i]++;
+		return;
+	}
+
+	// lanes with begin <= index < end are -1, the others 0
+	const __m128i four = _mm_set1_epi32(4);
+	const __m128i first = _mm_set1_epi32(begin - 1);
+	const __m128i last = _mm_set1_epi32(end);
+	__m128i index = _mm_setr_epi32(0, 1, 2, 3);
+	for (size_t i = 0; i < n; i += 4)
+	{
+		__m128i* p = (__m128i*)(values + i);
+		__m128i inRange = _mm_and_si128(_mm_cmpgt_epi32(index, first), _mm_cmplt_epi32(index, last));
+		_mm_storeu_si128(p, _mm_sub_epi32(_mm_loadu_si128(p), inRange));
+		index = _mm_add_epi32(index, four);
+	}
+}
+
+#else
+
+inline size_t SimdKernels::upperBoundShort(const uint32_t* sorted, size_t n, uint32_t value)
+{
+	return std::upper_bound(sorted, sorted + n, value) - sorted;
+}
+
+inline void SimdKernels::increment(uint32_t* values, size_t n, int begin, int end)
+{
+	for (int i = std::max(begin, 0); i < std::min(end, (int)n); i++)
+		values[i]++;
+}
+
+#endif
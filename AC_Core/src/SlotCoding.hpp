@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+#include "IntervalCoder.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+// Coding of symbols and of unbounded values (lengths, distances) with an
+// adaptive model on the interval coder, shared by the LZ and run-length coders.
+//
+// Values below DIRECT_SLOTS are coded as their slot alone. Larger ones as
+// the position of their highest bit (the slot, with its own frequency in
+// the model) and the bits below it, which are uniform and coded as they are.
+namespace SlotCoding
+{
+	constexpr uint32_t DIRECT_SLOTS = 16;			// values below are their own slot
+	constexpr int MAX_EXTRA_BITS_STEP = 16;			// extra bits coded in one step
+
+	inline uint32_t slotOf(uint32_t value)
+	{
+		if (value < DIRECT_SLOTS)
+			return value;
+		uint32_t bits = 0;
+		while ((value >> bits) > 1)
+			bits++;
+		return DIRECT_SLOTS - 4 + bits;		// bits >= 4
+	}
+
+	inline int extraBits(uint32_t slot)
+	{
+		return slot < DIRECT_SLOTS ? 0 : (int)(slot - DIRECT_SLOTS + 4);
+	}
+
+	inline uint32_t slotBase(uint32_t slot)
+	{
+		return slot < DIRECT_SLOTS ? slot : uint32_t(1) << extraBits(slot);
+	}
+
+	// Size of a model of slots for values up to maxValue.
+	inline size_t slotCount(uint32_t maxValue)
+	{
+		return slotOf(maxValue) + 1;
+	}
+
+	// Interval steps of a value with extra bits up to maxValue, the slot included.
+	inline int maxSteps(uint32_t maxValue)
+	{
+		return 1 + (extraBits(slotOf(maxValue)) + MAX_EXTRA_BITS_STEP - 1) / MAX_EXTRA_BITS_STEP;
+	}
+
+	template <typename Model, unsigned Precision>
+	void encodeSymbol(IntervalEncoder<Precision>& interval, Model& model, size_t symbol)
+	{
+		size_t freqBegin = model.frequencyBegin(symbol);
+		interval.encode(freqBegin, freqBegin + model.frequency(symbol), model.totalFrequency());
+		model.update(symbol);
+	}
+
+	template <typename Model, unsigned Precision>
+	size_t decodeSymbol(IntervalDecoder<Precision>& interval, Model& model)
+	{
+		size_t total = model.totalFrequency();
+		size_t symbol = model.findSymbol((size_t)interval.count(total));
+
+		size_t freqBegin = model.frequencyBegin(symbol);
+		interval.decode(freqBegin, freqBegin + model.frequency(symbol), total);
+		model.update(symbol);
+		return symbol;
+	}
+
+	template <typename Model, unsigned Precision>
+	void encodeValue(IntervalEncoder<Precision>& interval, Model& model, uint32_t value)
+	{
+		uint32_t slot = slotOf(value);
+		encodeSymbol(interval, model, slot);
+
+		uint32_t extra = value - slotBase(slot);
+		for (int count = extraBits(slot); count > 0; )
+		{
+			int n = std::min(count, MAX_EXTRA_BITS_STEP);
+			uint64_t piece = extra & ((uint32_t(1) << n) - 1);
+			interval.encode(piece, piece + 1, uint64_t(1) << n);
+			extra >>= n;
+			count -= n;
+		}
+	}
+
+	template <typename Model, unsigned Precision>
+	uint32_t decodeValue(IntervalDecoder<Precision>& interval, Model& model)
+	{
+		uint32_t slot = (uint32_t)decodeSymbol(interval, model);
+
+		uint32_t extra = 0;
+		int shift = 0;
+		for (int count = extraBits(slot); count > 0; )
+		{
+			int n = std::min(count, MAX_EXTRA_BITS_STEP);
+			uint64_t piece = interval.count(uint64_t(1) << n);
+			interval.decode(piece, piece + 1, uint64_t(1) << n);
+			extra |= (uint32_t)piece << shift;
+			shift += n;
+			count -= n;
+		}
+		return slotBase(slot) + extra;
+	}
+}
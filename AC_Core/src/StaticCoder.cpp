@@ -0,0 +1,213 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#include "StaticCoder.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <future>
+#include <stdexcept>
+
+namespace
+{
+	constexpr size_t COUNTING_CHUNK = 1 << 18;
+}
+
+StaticCoder::StaticCoder(unsigned threads, bool printProgress)
+	: threads(threads), printProgress(printProgress)
+{
+}
+
+void StaticCoder::countBytes(ByteSource& in, unsigned threads, uint64_t counts[256])
+{
+	if (!in.seekable() || in.size() < 0)
+		throw std::invalid_argument("counting needs a seekable source");
+
+	uint64_t size = (uint64_t)in.size();
+	unsigned parts = (unsigned)std::max<uint64_t>(1, std::min<uint64_t>(std::max(threads, 1u), size / COUNTING_CHUNK));
+	ThreadPool pool(parts > 1 ? parts : 0);
+
+	std::vector<std::future<std::array<uint64_t, 256>>> results;
+	for (unsigned part = 0; part < parts; part++)
+	{
+		uint64_t begin = size * part / parts;
+		uint64_t end = size * (part + 1) / parts;
+		results.push_back(pool.submit([&in, begin, end]() {
+			std::array<uint64_t, 256> partCounts = {};
+			std::vector<uint8_t> buffer(COUNTING_CHUNK);
+			for (uint64_t offset = begin; offset < end; )
+			{
+				size_t count = in.readAt(offset, buffer.data(), (size_t)std::min<uint64_t>(COUNTING_CHUNK, end - offset));
+				if (count == 0)
+					break;		// the source got shorter
+				StaticModel::countBytes(buffer.data(), count, partCounts.data());
+				offset += count;
+			}
+			return partCounts;
+		}));
+	}
+
+	std::fill(counts, counts + 256, 0);
+	for (auto& result : results) {
+		std::array<uint64_t, 256> partCounts = result.get();
+		for (int s = 0; s < 256; s++)
+			counts[s] += partCounts[s];
+	}
+}
+
+Statistics StaticCoder::encode(ByteSource& in, ByteSink& out)
+{
+	if (!in.seekable() || in.size() < 0)
+	{
+		// the data is needed twice, keep it
+		std::vector<uint8_t> data;
+		const uint8_t* chunk = nullptr;
+		while (size_t chunkSize = in.next(chunk))
+			data.insert(data.end(), chunk, chunk + chunkSize);
+
+		MemorySource memory(data.data(), data.size());
+		return encode(memory, out);
+	}
+
+	uint64_t counts[256];
+	countBytes(in, threads, counts);
+	StaticModel model(counts);
+	Encoder encoder(out, model);
+	return encodeWith(in, encoder, printProgress);
+}
+
+void StaticCoder::decode(ByteSource& in, ByteSink& out)
+{
+	Decoder decoder(out);
+	decodeWith(in, decoder, printProgress);
+}
+
+StaticCoder::Encoder::Encoder(ByteSink& sink, const StaticModel& model)
+	: out(sink), interval(out), model(model)
+{
+	StreamHeader header;
+	header.format = StreamFormat::Static;
+	std::vector<uint8_t> bytes(StreamHeader::SIZE);
+	header.serialize(bytes.data());
+	model.serialize(bytes);
+	for (uint8_t byte : bytes)
+		out.writeByte(byte);
+}
+
+void StaticCoder::Encoder::feed(const uint8_t* data, size_t size)
+{
+	if (finished)
+		throw std::logic_error("cannot feed finished encoder");
+
+	for (size_t i = 0; i < size; i++)
+	{
+		if (model.frequency(data[i]) == 0)
+			throw std::invalid_argument("byte was not counted in the frequency table");
+
+		out.beginByte(data[i]);		// for statistics purposes
+		interval.encode(model.frequencyBegin(data[i]), model.frequencyEnd(data[i]), StaticModel::TOTAL_FREQUENCY);
+	}
+}
+
+Statistics StaticCoder::Encoder::finish()
+{
+	if (!finished)
+	{
+		interval.encode(model.frequencyBegin(StaticModel::EOF_SYMBOL), StaticModel::TOTAL_FREQUENCY, StaticModel::TOTAL_FREQUENCY);
+		interval.finish();
+		out.flush();
+		finished = true;
+	}
+	return Statistics(out.getStats());
+}
+
+StaticCoder::Decoder::Decoder(ByteSink& sink)
+	: in(source), interval(in), out(sink)
+{
+}
+
+void StaticCoder::Decoder::feed(const uint8_t* data, size_t size)
+{
+	if (endOfStream || bits.isFinished())
+		return;		// everything after EOF symbol is ignored
+
+	if (!model) {
+		size_t taken = takeHeader(data, size);
+		data += taken;
+		size -= taken;
+	}
+
+	source.push(data, size);
+	bits.feed(size);
+	decodeAvailable();
+	out.flush();
+}
+
+void StaticCoder::Decoder::finish()
+{
+	if (!model)
+		throw std::runtime_error("encoded data is truncated or corrupted");
+
+	bits.finish();
+	decodeAvailable();
+	out.flush();
+}
+
+size_t StaticCoder::Decoder::takeHeader(const uint8_t* data, size_t size)
+{
+	constexpr size_t FIXED_SIZE = StreamHeader::SIZE + StaticModel::BIT_SET_SIZE;
+
+	size_t taken = 0;
+	auto takeUpTo = [&](size_t length) {
+		size_t count = std::min(length - std::min(length, header.size()), size - taken);
+		header.insert(header.end(), data + taken, data + taken + count);
+		taken += count;
+	};
+
+	takeUpTo(FIXED_SIZE);
+	if (header.size() < FIXED_SIZE)
+		return taken;
+
+	StreamHeader streamHeader;
+	if (!streamHeader.deserialize(header.data()) || streamHeader.format != StreamFormat::Static || streamHeader.arithmetic != IntervalArithmetic::Integer)
+		throw std::runtime_error("data was encoded in a different format");
+
+	size_t tableSize = StaticModel::serializedSize(header.data() + StreamHeader::SIZE);
+	takeUpTo(StreamHeader::SIZE + tableSize);
+	if (header.size() < StreamHeader::SIZE + tableSize)
+		return taken;
+
+	model = std::make_unique<StaticModel>(header.data() + StreamHeader::SIZE, tableSize);	// throws on invalid table
+	header.clear();
+	return taken;
+}
+
+void StaticCoder::Decoder::decodeAvailable()
+{
+	if (!model)
+		return;
+
+	if (interval.bitsTaken() == 0)
+	{
+		// 'z'
+		if (!bits.canStart(0))
+			return;
+		interval.start(IntervalArithmetic::Integer);
+	}
+
+	// A symbol takes at most PRECISION bits.
+	while (!endOfStream && bits.canDecode(interval.bitsTaken()))
+	{
+		size_t symbol = model->findSymbol((size_t)interval.count(StaticModel::TOTAL_FREQUENCY));
+		if (symbol == StaticModel::EOF_SYMBOL) {
+			endOfStream = true;
+			break;
+		}
+
+		out.put((uint8_t)symbol);
+		interval.decode(model->frequencyBegin(symbol), model->frequencyEnd(symbol), StaticModel::TOTAL_FREQUENCY);
+		bits.checkTaken(interval.bitsTaken());
+	}
+}
@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+#include "ArithmeticCoder.hpp"
+#include "IntervalCoder.hpp"
+#include "StaticModel.hpp"
+#include "Statistics.hpp"
+#include "StreamHeader.hpp"
+#include "BitUtils/BitWriter.hpp"
+#include "BitUtils/BitReader.hpp"
+
+#include <memory>
+#include <vector>
+
+// Semi-static order-0 coder in two passes: the first one counts bytes of the
+// whole input, the second codes it with the frozen table (see StaticModel).
+// The table is stored after the stream header, so decoding never updates a
+// model. Compression is about the same as with the adaptive order-0 model,
+// decoding is much faster.
+//
+// Counting is split between threads. A seekable source is read twice; any
+// other source is kept in memory between the passes.
+//
+//   byte 4-: frequency table (see StaticModel::serialize)
+class StaticCoder : public ArithmeticCoder
+{
+public:
+	static constexpr uint64_t PRECISION = 32;
+
+	class Encoder;
+	class Decoder;
+
+	StaticCoder(unsigned threads = 1, bool printProgress = false);
+	using ArithmeticCoder::encode;
+	using ArithmeticCoder::decode;
+
+	Statistics encode(ByteSource& in, ByteSink& out) override;
+	void decode(ByteSource& in, ByteSink& out) override;
+
+	// The first pass: counts of bytes of a seekable source, read on the given number of threads.
+	static void countBytes(ByteSource& in, unsigned threads, uint64_t counts[256]);
+
+private:
+	unsigned threads;
+	bool printProgress;
+};
+
+// Push-based encoder of the second pass. The model is frozen, so it must
+// be counted before the first byte is fed.
+class StaticCoder::Encoder
+{
+public:
+	Encoder(ByteSink& sink, const StaticModel& model);
+
+	void feed(const uint8_t* data, size_t size);
+	Statistics finish();	// encodes EOF symbol and flushes the sink
+
+private:
+	BitWriter out;
+	IntervalEncoder<PRECISION> interval;
+	const StaticModel& model;
+	bool finished = false;
+};
+
+// Push-based decoder. The header and the table are collected from the fed
+// chunks first; the model is created from them and never updated.
+class StaticCoder::Decoder
+{
+public:
+	Decoder(ByteSink& sink);
+
+	void feed(const uint8_t* data, size_t size);
+	void finish();		// no more data: decodes the rest assuming '0' bits after the end
+	bool done() const { return endOfStream; }
+
+private:
+	QueueSource source;
+	BitReader in;
+	IntervalDecoder<PRECISION> interval;
+	ByteWriter out;
+	std::unique_ptr<StaticModel> model;
+	std::vector<uint8_t> header;	// stream header and the table, until the model is created
+
+	BitBudget<PRECISION> bits;		// after the header
+	bool endOfStream = false;
+
+	size_t takeHeader(const uint8_t* data, size_t size);	// returns the number of bytes taken
+	void decodeAvailable();
+};
@@ -0,0 +1,170 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+
+#include "SimdKernels.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+// Frozen order-0 model: frequencies of all bytes are counted beforehand and
+// never change while coding, so there is nothing to update and a symbol is
+// found by a direct lookup.
+//
+// Counts are normalized so that the total is always TOTAL_FREQUENCY (a power
+// of two). Every byte that occurs keeps a frequency of at least 1 and the
+// end of data (EOF_SYMBOL) gets whatever is left, at least 1.
+//
+// Serialized table (see serialize):
+//
+//   32 bytes:  bit set of bytes that occur (bit i of byte i / 8)
+//   for every byte that occurs, in ascending order:
+//     frequency  uint16 (little endian)
+class StaticModel
+{
+public:
+	static constexpr size_t NUMBER_OF_SYMBOLS = 257;	// all bytes and EOF
+	static constexpr size_t EOF_SYMBOL = 256;
+	static constexpr int TOTAL_BITS = 15;
+	static constexpr uint32_t TOTAL_FREQUENCY = 1 << TOTAL_BITS;
+	static constexpr size_t BIT_SET_SIZE = 32;
+	static constexpr size_t MAX_SERIALIZED_SIZE = BIT_SET_SIZE + 2 * 256;
+
+	// Normalizes counts of bytes.
+	explicit StaticModel(const uint64_t counts[256])
+	{
+		uint64_t sum = 0;
+		for (int s = 0; s < 256; s++)
+			sum += counts[s];
+
+		uint32_t frequencies[NUMBER_OF_SYMBOLS] = {};
+		if (sum > 0)
+		{
+			const uint32_t target = TOTAL_FREQUENCY - 1;	// 1 for EOF
+			uint32_t scaled = 0;
+			for (int s = 0; s < 256; s++) {
+				if (counts[s] == 0)
+					continue;
+				// only the encoder normalizes, the decoder reads the result
+				uint64_t frequency = (uint64_t)((double)counts[s] * target / sum);
+				frequencies[s] = (uint32_t)std::max<uint64_t>(frequency, 1);
+				scaled += frequencies[s];
+			}
+
+			// Rounding up rare bytes to 1 may exceed the target; take it back
+			// from the most frequent bytes. What is missing goes to the most frequent one.
+			while (scaled > target) {
+				uint32_t* largest = std::max_element(frequencies, frequencies + 256);
+				(*largest)--;
+				scaled--;
+			}
+			*std::max_element(frequencies, frequencies + 256) += target - scaled;
+		}
+
+		build(frequencies);
+	}
+
+	// Reads a table written by serialize(). 'size' must be at least serializedSize(table).
+	StaticModel(const uint8_t* table, size_t size)
+	{
+		if (size < BIT_SET_SIZE || size < serializedSize(table))
+			throw std::runtime_error("frequency table is truncated");
+
+		uint32_t frequencies[NUMBER_OF_SYMBOLS] = {};
+		const uint8_t* next = table + BIT_SET_SIZE;
+		for (int s = 0; s < 256; s++) {
+			if ((table[s / 8] >> (s % 8)) & 1) {
+				frequencies[s] = next[0] | next[1] << 8;
+				next += 2;
+				if (frequencies[s] == 0)
+					throw std::runtime_error("frequency table is corrupted");
+			}
+		}
+		build(frequencies);	// throws if the total is too high
+	}
+
+	// Adds counts of bytes of the data to 'counts'.
+	static void countBytes(const uint8_t* data, size_t size, uint64_t counts[256])
+	{
+		// four tables, so that runs of the same byte don't wait for each other's increments
+		uint32_t partial[4][256] = {};
+		while (size > 0)
+		{
+			size_t length = std::min<size_t>(size, UINT32_MAX);
+			size_t i = 0;
+			for (; i + 4 <= length; i += 4) {
+				partial[0][data[i]]++;
+				partial[1][data[i + 1]]++;
+				partial[2][data[i + 2]]++;
+				partial[3][data[i + 3]]++;
+			}
+			for (; i < length; i++)
+				partial[0][data[i]]++;
+
+			for (auto& table : partial) {
+				SimdKernels::addCounts(counts, table, 256);
+				std::fill(table, table + 256, 0u);
+			}
+			data += length;
+			size -= length;
+		}
+	}
+
+	// Size of a serialized table, given its first BIT_SET_SIZE bytes.
+	static size_t serializedSize(const uint8_t* bitSet)
+	{
+		size_t present = 0;
+		for (size_t i = 0; i < BIT_SET_SIZE; i++)
+			for (uint8_t bits = bitSet[i]; bits != 0; bits &= bits - 1)
+				present++;
+		return BIT_SET_SIZE + 2 * present;
+	}
+
+	void serialize(std::vector<uint8_t>& out) const
+	{
+		uint8_t bitSet[BIT_SET_SIZE] = {};
+		for (int s = 0; s < 256; s++)
+			if (frequency(s) != 0)
+				bitSet[s / 8] |= 1 << (s % 8);
+		out.insert(out.end(), bitSet, bitSet + BIT_SET_SIZE);
+
+		for (int s = 0; s < 256; s++) {
+			if (frequency(s) != 0) {
+				out.push_back((uint8_t)frequency(s));
+				out.push_back((uint8_t)(frequency(s) >> 8));
+			}
+		}
+	}
+
+	size_t frequencyBegin(size_t symbol) const { return begins[symbol]; }
+	size_t frequencyEnd(size_t symbol) const { return begins[symbol + 1]; }
+	size_t frequency(size_t symbol) const { return begins[symbol + 1] - begins[symbol]; }
+	size_t totalFrequency() const { return TOTAL_FREQUENCY; }
+
+	// Returns the symbol for which frequencyBegin(symbol) <= count < frequencyEnd(symbol).
+	size_t findSymbol(size_t count) const { return lookup[count]; }
+	const uint16_t* lookupTable() const { return lookup.get(); }	// findSymbol() for all counts
+
+private:
+	uint32_t begins[NUMBER_OF_SYMBOLS + 1];
+	std::unique_ptr<uint16_t[]> lookup{ new uint16_t[TOTAL_FREQUENCY] };	// count -> symbol
+
+	void build(uint32_t frequencies[NUMBER_OF_SYMBOLS])
+	{
+		begins[0] = 0;
+		std::copy(frequencies, frequencies + 256, begins + 1);
+		SimdKernels::prefixSum(begins + 1, 256);	// frequencies are below 2^16, so it can't wrap around
+
+		if (begins[EOF_SYMBOL] >= TOTAL_FREQUENCY)	// sum of the bytes
+			throw std::runtime_error("frequency table is corrupted");
+		begins[EOF_SYMBOL + 1] = TOTAL_FREQUENCY;
+
+		for (size_t s = 0; s < NUMBER_OF_SYMBOLS; s++)
+			std::fill(&lookup[begins[s]], &lookup[begins[s + 1]], (uint16_t)s);
+	}
+};
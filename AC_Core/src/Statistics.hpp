@@ -11,6 +11,22 @@ public:
 	Statistics(std::vector<BitStat> stats)
 		: m_stats(stats) {}
 
+	Statistics()
+		: m_stats(256) {}
+
+	// Adds stats of another part of the same input (e.g. a block).
+	void add(const Statistics& other)
+	{
+		if (m_stats.size() < other.m_stats.size())
+			m_stats.resize(other.m_stats.size());
+
+		for (size_t i = 0; i < other.m_stats.size(); i++)
+		{
+			m_stats[i].readCounter += other.m_stats[i].readCounter;
+			m_stats[i].writeCounter += other.m_stats[i].writeCounter;
+		}
+	}
+
 	double entropy()
 	{
 		unsigned long long n = 0uLL;	// total number of bits written
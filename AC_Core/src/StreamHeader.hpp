@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+
+// Arithmetic used to narrow the [a, b) interval for every symbol.
+enum class IntervalArithmetic : uint8_t
+{
+	FloatingPoint = 0,	// llround(w * (freq / total)), the original format (no header)
+	Integer = 1			// w * freq / total in 64-bit integers, exact and portable
+};
+
+// Layout of the data that follows the header.
+enum class StreamFormat : uint8_t
+{
+	AdaptiveScaling = 1,	// a single AdaptiveScalingCoder stream
+	BlockContainer = 2,		// independently coded blocks (see BlockCoder)
+	Order1 = 3,				// a single stream coded with Order1Model
+	PPM = 4,				// a single PPMCoder stream
+	Binary = 5,				// a single BinaryCoder stream
+	ContextMixing = 6,		// a single ContextMixingCoder stream
+	Static = 7,				// a single StaticCoder stream
+	Rans = 8,				// a single RansCoder stream
+	Interleaved = 9,		// InterleavedCoder streams
+	Lz = 10,				// a single LzCoder stream
+	Bwt = 11,				// a single BwtCoder stream
+	RunLength = 12			// a single RunLengthCoder stream
+};
+
+// Header at the beginning of an encoded stream.
+//
+// Files produced before the header existed start directly with the
+// bitstream and always use floating-point arithmetic. They are recognised
+// by the absence of the magic bytes, so they still decode.
+//
+//   byte 0-1: magic "AC"
+//   byte 2:   format
+//   byte 3:   flags
+struct StreamHeader
+{
+	static constexpr uint8_t MAGIC_0 = 'A';
+	static constexpr uint8_t MAGIC_1 = 'C';
+	static constexpr int SIZE = 4;
+
+	enum Flags : uint8_t
+	{
+		INTEGER_ARITHMETIC = 0x01
+	};
+
+	StreamFormat format = StreamFormat::AdaptiveScaling;
+	IntervalArithmetic arithmetic = IntervalArithmetic::Integer;
+
+	void serialize(uint8_t bytes[SIZE]) const
+	{
+		bytes[0] = MAGIC_0;
+		bytes[1] = MAGIC_1;
+		bytes[2] = (uint8_t)format;
+		bytes[3] = arithmetic == IntervalArithmetic::Integer ? INTEGER_ARITHMETIC : 0;
+	}
+
+	// Returns false if bytes do not start with a valid header (legacy stream).
+	bool deserialize(const uint8_t bytes[SIZE])
+	{
+		if (bytes[0] != MAGIC_0 || bytes[1] != MAGIC_1)
+			return false;
+		if (bytes[2] < (uint8_t)StreamFormat::AdaptiveScaling || bytes[2] > (uint8_t)StreamFormat::RunLength)
+			return false;	// unknown format
+		if ((bytes[3] & ~INTEGER_ARITHMETIC) != 0)
+			return false;	// unknown flags
+
+		format = (StreamFormat)bytes[2];
+		arithmetic = (bytes[3] & INTEGER_ARITHMETIC) ? IntervalArithmetic::Integer : IntervalArithmetic::FloatingPoint;
+		return true;
+	}
+};
@@ -0,0 +1,160 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#include "SuffixArray.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+	constexpr int32_t EMPTY = -1;
+
+	// Type of every suffix: S (smaller than the next suffix) or L (larger).
+	class SuffixTypes
+	{
+	public:
+		SuffixTypes(size_t size) : bits((size + 63) / 64) {}
+
+		bool isS(int32_t i) const { return (bits[i >> 6] >> (i & 63)) & 1; }
+		void setS(int32_t i) { bits[i >> 6] |= uint64_t(1) << (i & 63); }
+
+		// Leftmost S: an S suffix after an L suffix.
+		bool isLms(int32_t i) const { return i > 0 && isS(i) && !isS(i - 1); }
+
+	private:
+		std::vector<uint64_t> bits;
+	};
+
+	// Where the bucket of every symbol starts (or ends).
+	template <typename Symbol>
+	void findBuckets(const Symbol* s, int32_t n, std::vector<int32_t>& buckets, bool ends)
+	{
+		std::fill(buckets.begin(), buckets.end(), 0);
+		for (int32_t i = 0; i < n; i++)
+			buckets[s[i]]++;
+
+		int32_t sum = 0;
+		for (int32_t& bucket : buckets) {
+			sum += bucket;
+			bucket = ends ? sum : sum - bucket;
+		}
+	}
+
+	// Sorts L suffixes from the sorted S suffixes at the ends of their
+	// buckets, then S suffixes from the L ones.
+	template <typename Symbol>
+	void induce(const Symbol* s, int32_t* sa, int32_t n, const SuffixTypes& types, std::vector<int32_t>& buckets)
+	{
+		findBuckets(s, n, buckets, false);
+		for (int32_t i = 0; i < n; i++) {
+			int32_t j = sa[i] - 1;
+			if (j >= 0 && !types.isS(j))
+				sa[buckets[s[j]]++] = j;
+		}
+
+		findBuckets(s, n, buckets, true);
+		for (int32_t i = n - 1; i >= 0; i--) {
+			int32_t j = sa[i] - 1;
+			if (j >= 0 && types.isS(j))
+				sa[--buckets[s[j]]] = j;
+		}
+	}
+
+	// s has n symbols of an alphabet of size k and ends with the unique
+	// smallest symbol 0.
+	template <typename Symbol>
+	void sais(const Symbol* s, int32_t* sa, int32_t n, int32_t k)
+	{
+		SuffixTypes types(n);
+		types.setS(n - 1);		// the sentinel
+		for (int32_t i = n - 2; i >= 0; i--)
+			if (s[i] < s[i + 1] || (s[i] == s[i + 1] && types.isS(i + 1)))
+				types.setS(i);
+
+		// Sort LMS substrings: put LMS suffixes at the ends of their buckets and induce.
+		std::vector<int32_t> buckets(k);
+		findBuckets(s, n, buckets, true);
+		std::fill(sa, sa + n, EMPTY);
+		for (int32_t i = 1; i < n; i++)
+			if (types.isLms(i))
+				sa[--buckets[s[i]]] = i;
+		induce(s, sa, n, types, buckets);
+
+		// Move the sorted LMS substrings to the front and name them. Equal
+		// substrings get the same name.
+		int32_t lmsCount = 0;
+		for (int32_t i = 0; i < n; i++)
+			if (types.isLms(sa[i]))
+				sa[lmsCount++] = sa[i];
+
+		std::fill(sa + lmsCount, sa + n, EMPTY);
+		int32_t names = 0;
+		int32_t previous = EMPTY;
+		for (int32_t i = 0; i < lmsCount; i++)
+		{
+			int32_t position = sa[i];
+			bool different = previous == EMPTY;
+			for (int32_t d = 0; !different; d++)
+			{
+				if (s[position + d] != s[previous + d] || types.isS(position + d) != types.isS(previous + d))
+					different = true;
+				else if (d > 0 && (types.isLms(position + d) || types.isLms(previous + d)))
+					break;		// both substrings ended, they are equal
+			}
+			if (different) {
+				names++;
+				previous = position;
+			}
+			sa[lmsCount + position / 2] = names - 1;	// LMS positions are at least 2 apart
+		}
+		for (int32_t i = n - 1, j = n - 1; i >= lmsCount; i--)
+			if (sa[i] != EMPTY)
+				sa[j--] = sa[i];
+
+		// Sort LMS suffixes: by recursion on the names, unless they are all unique.
+		int32_t* reduced = sa + n - lmsCount;
+		if (names < lmsCount)
+			sais(reduced, sa, lmsCount, names);
+		else
+			for (int32_t i = 0; i < lmsCount; i++)
+				sa[reduced[i]] = i;
+
+		// Map them back to positions in s and induce the rest from them.
+		for (int32_t i = 1, j = 0; i < n; i++)
+			if (types.isLms(i))
+				reduced[j++] = i;
+		for (int32_t i = 0; i < lmsCount; i++)
+			sa[i] = reduced[sa[i]];
+		std::fill(sa + lmsCount, sa + n, EMPTY);
+
+		findBuckets(s, n, buckets, true);
+		for (int32_t i = lmsCount - 1; i >= 0; i--) {
+			int32_t j = sa[i];
+			sa[i] = EMPTY;
+			sa[--buckets[s[j]]] = j;
+		}
+		induce(s, sa, n, types, buckets);
+	}
+}
+
+void suffixArray(const uint8_t* data, size_t size, std::vector<int32_t>& sa)
+{
+	if (size >= (size_t)INT32_MAX)
+		throw std::invalid_argument("too much data for a suffix array");
+
+	int32_t n = (int32_t)size + 1;
+	sa.resize(n);
+	if (n == 1) {
+		sa[0] = 0;		// only the sentinel, no LMS suffix to start from
+		return;
+	}
+
+	std::vector<uint16_t> symbols(n);
+	for (int32_t i = 0; i + 1 < n; i++)
+		symbols[i] = data[i] + 1;
+	symbols[n - 1] = 0;		// the sentinel
+
+	sais(symbols.data(), sa.data(), n, 257);
+}
@@ -0,0 +1,18 @@
+//
+// Copyright (c) 2020 Sebastian Fojcik
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Sorts all suffixes of data in linear time with induced sorting (SA-IS,
+// Nong, Zhang and Chan). Like the textbook version it appends a sentinel
+// smaller than any byte, so sa gets size + 1 entries and sa[0] == size
+// (the empty suffix). sa is resized and can be reused between calls.
+//
+// Besides sa it takes at most about 4 bytes per input byte (symbols and
+// buckets of the recursion). Size must be less than 2^31.
+void suffixArray(const uint8_t* data, size_t size, std::vector<int32_t>& sa);
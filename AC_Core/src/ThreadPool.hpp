@@ -0,0 +1,81 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed number of worker threads executing submitted tasks in FIFO order.
+// A pool with no threads runs every task immediately in submit().
+class ThreadPool
+{
+public:
+	ThreadPool(unsigned threads)
+	{
+		for (unsigned i = 0; i < threads; i++)
+			workers.emplace_back([this] { work(); });
+	}
+
+	template <class Task>
+	auto submit(Task task) -> std::future<decltype(task())>
+	{
+		auto packaged = std::make_shared<std::packaged_task<decltype(task())()>>(std::move(task));
+		auto result = packaged->get_future();
+
+		if (workers.empty()) {
+			(*packaged)();
+			return result;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			tasks.emplace_back([packaged] { (*packaged)(); });
+		}
+		available.notify_one();
+		return result;
+	}
+
+	size_t size() const
+	{
+		return workers.size();
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		available.notify_all();
+		for (auto& worker : workers)
+			worker.join();
+	}
+
+private:
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable available;
+	bool stopping = false;
+
+	void work()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				available.wait(lock, [this] { return stopping || !tasks.empty(); });
+				if (tasks.empty())
+					return;		// stopping and nothing left to do
+				task = std::move(tasks.front());
+				tasks.pop_front();
+			}
+			task();
+		}
+	}
+};
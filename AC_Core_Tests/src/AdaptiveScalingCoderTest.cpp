@@ -7,6 +7,7 @@
 #include <fstream>
 #include <filesystem>
 #include <algorithm>
+#include <vector>
 #pragma warning( disable : 6237 6319 )
 
 namespace fs = std::filesystem;
@@ -164,6 +165,158 @@ SCENARIO("Processing binary files", "[Coder]")
 	removeAllTempFiles();
 }
 
+SCENARIO("Interval arithmetic is recorded in the file", "[Coder]")
+{
+	removeAllTempFiles();
+	std::ofstream file(encode_path_in);
+	for (int i = 1; i <= 50; i++) {
+		file << std::string(i, 'x') << std::string(i % 7, 'y') << i << '\n';
+	}
+	file.close();
+
+	GIVEN("a file encoded with integer arithmetic")
+	{
+		AdaptiveScalingCoder(false, IntervalArithmetic::Integer).encode(encode_path_in, encode_path_out);
+
+		THEN("it starts with a header") {
+			std::ifstream encoded(encode_path_out, std::ifstream::binary);
+			CHECK(encoded.get() == 'A');
+			CHECK(encoded.get() == 'C');
+			CHECK(encoded.get() == (int)StreamFormat::AdaptiveScaling);
+			CHECK(encoded.get() == StreamHeader::INTEGER_ARITHMETIC);
+		}
+		THEN("it can be decoded") {
+			AdaptiveScalingCoder().decode(encode_path_out, decode_path_out);
+			CHECK(files_equal(encode_path_in, decode_path_out));
+		}
+	}
+	GIVEN("a file encoded in the legacy floating-point format")
+	{
+		AdaptiveScalingCoder(false, IntervalArithmetic::FloatingPoint).encode(encode_path_in, encode_path_out);
+
+		THEN("it can be decoded by default coder") {
+			AdaptiveScalingCoder().decode(encode_path_out, decode_path_out);
+			CHECK(files_equal(encode_path_in, decode_path_out));
+		}
+	}
+	removeAllTempFiles();
+}
+
+SCENARIO("Coding data in memory", "[Coder]")
+{
+	removeAllTempFiles();
+	AdaptiveScalingCoder coder;
+
+	GIVEN("a buffer with data")
+	{
+		std::vector<uint8_t> data;
+		for (int i = 0; i < 5000; i++)
+			data.push_back((uint8_t)(i * i % 251));
+
+		WHEN("it is encoded to memory") {
+			std::vector<uint8_t> encoded;
+			Statistics stats = coder.encode(data.data(), data.size(), encoded);
+
+			THEN("no file is needed to decode it") {
+				std::vector<uint8_t> decoded;
+				coder.decode(encoded.data(), encoded.size(), decoded);
+				CHECK(decoded == data);
+			}
+			THEN("it is the same as encoded file") {
+				std::ofstream(encode_path_in, std::ofstream::binary).write((const char*)data.data(), data.size());
+				Statistics fileStats = coder.encode(encode_path_in, encode_path_out);
+
+				std::ifstream file(encode_path_out, std::ifstream::binary);
+				std::vector<uint8_t> fromFile((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+				CHECK(fromFile == encoded);
+				CHECK(fileStats.averageCodingLength() == stats.averageCodingLength());
+			}
+		}
+		WHEN("output buffer already contains data") {
+			std::vector<uint8_t> encoded = { 1, 2, 3 };
+			coder.encode(data.data(), data.size(), encoded);
+
+			THEN("encoded data is appended") {
+				CHECK(encoded.size() > 3);
+				CHECK(encoded[0] == 1);
+				std::vector<uint8_t> decoded;
+				coder.decode(encoded.data() + 3, encoded.size() - 3, decoded);
+				CHECK(decoded == data);
+			}
+		}
+	}
+	GIVEN("an empty buffer")
+	{
+		std::vector<uint8_t> encoded, decoded;
+		coder.encode(nullptr, 0, encoded);
+		coder.decode(encoded.data(), encoded.size(), decoded);
+
+		THEN("it is decoded to an empty buffer") {
+			CHECK(decoded.empty());
+		}
+	}
+	removeAllTempFiles();
+}
+
+SCENARIO("Coding data fed in chunks", "[Coder]")
+{
+	std::vector<uint8_t> data;
+	for (int i = 0; i < 20000; i++)
+		data.push_back((uint8_t)((i / 7) % 13 + (i % 3) * 50));
+
+	std::vector<uint8_t> encoded;
+	AdaptiveScalingCoder().encode(data.data(), data.size(), encoded);
+
+	GIVEN("an encoder")
+	{
+		std::vector<uint8_t> output;
+		MemorySink sink(output);
+		AdaptiveScalingCoder::Encoder encoder(sink);
+
+		WHEN("data is fed in chunks of different sizes") {
+			size_t chunkSize = GENERATE(1, 7, 4096);
+			for (size_t i = 0; i < data.size(); i += chunkSize)
+				encoder.feed(data.data() + i, std::min(chunkSize, data.size() - i));
+			Statistics stats = encoder.finish();
+
+			THEN("output is the same as encoded at once") {
+				CHECK(output == encoded);
+				CHECK(stats.averageCodingLength() > 0);
+			}
+		}
+	}
+	GIVEN("a decoder")
+	{
+		std::vector<uint8_t> output;
+		MemorySink sink(output);
+		AdaptiveScalingCoder::Decoder decoder(sink);
+
+		WHEN("encoded data is fed in chunks of different sizes") {
+			size_t chunkSize = GENERATE(1, 3, 4096);
+			for (size_t i = 0; i < encoded.size(); i += chunkSize)
+				decoder.feed(encoded.data() + i, std::min(chunkSize, encoded.size() - i));
+			decoder.finish();
+
+			THEN("all the data is decoded") {
+				CHECK(decoder.done());
+				CHECK(output == data);
+			}
+		}
+		WHEN("only part of encoded data is fed") {
+			decoder.feed(encoded.data(), encoded.size() / 2);
+
+			THEN("some of the data is decoded already") {
+				CHECK_FALSE(decoder.done());
+				CHECK(output.size() > 0);
+				CHECK(std::equal(output.begin(), output.end(), data.begin()));
+			}
+			THEN("finishing detects truncated data") {
+				CHECK_THROWS_AS(decoder.finish(), std::runtime_error);
+			}
+		}
+	}
+}
+
 bool files_equal(const std::string& path1, const std::string& path2)
 {
 	if (!fs::exists(path1) || !fs::exists(path2))
@@ -173,7 +326,7 @@ bool files_equal(const std::string& path1, const std::string& path2)
 		return false;	// files have different size
 
 	std::ifstream file1(path1, std::ifstream::binary);
-	std::ifstream file2(path1, std::ifstream::binary);
+	std::ifstream file2(path2, std::ifstream::binary);
 	std::istreambuf_iterator<char> begin1(file1);
 	std::istreambuf_iterator<char> begin2(file2);
 
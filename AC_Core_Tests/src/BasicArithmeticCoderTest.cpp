@@ -0,0 +1,81 @@
+#include <catch2/catch.hpp>
+#include "BasicArithmeticCoder.hpp"
+#include "AdaptiveScalingCoder.hpp"
+#include "AdaptiveModel.hpp"
+
+#include <vector>
+#pragma warning( disable : 6237 6319 )
+
+static std::vector<uint8_t> sampleData(size_t size, uint8_t alphabetSize)
+{
+	std::vector<uint8_t> data(size);
+	uint32_t state = 777;
+	for (size_t i = 0; i < size; i++) {
+		state = state * 1103515245 + 12345;
+		data[i] = (uint8_t)((state >> 16) % (1 + (state >> 28) % alphabetSize));
+	}
+	return data;
+}
+
+SCENARIO("Coders with the same model behave the same", "[BasicArithmeticCoder]")
+{
+	using ReferenceCoder = BasicArithmeticCoder<AdaptiveModel, 32, 256>;
+	std::vector<uint8_t> data = sampleData(20000, 255);
+
+	GIVEN("data encoded with AdaptiveScalingCoder")
+	{
+		IntervalArithmetic arithmetic = GENERATE(IntervalArithmetic::Integer, IntervalArithmetic::FloatingPoint);
+		std::vector<uint8_t> encoded;
+		AdaptiveScalingCoder(false, arithmetic).encode(data.data(), data.size(), encoded);
+
+		THEN("coder with AdaptiveModel gives the same output") {
+			std::vector<uint8_t> reference;
+			ReferenceCoder(false, arithmetic).encode(data.data(), data.size(), reference);
+			CHECK(reference == encoded);
+		}
+		THEN("coder with AdaptiveModel decodes it") {
+			std::vector<uint8_t> decoded;
+			ReferenceCoder().decode(encoded.data(), encoded.size(), decoded);
+			CHECK(decoded == data);
+		}
+	}
+}
+
+SCENARIO("Coder works with other precisions and alphabets", "[BasicArithmeticCoder]")
+{
+	using NibbleCoder = BasicArithmeticCoder<FenwickModel, 20, 16>;
+	using WideCoder = BasicArithmeticCoder<FenwickModel, 24, 256>;
+
+	GIVEN("data made of 4-bit symbols")
+	{
+		std::vector<uint8_t> data = sampleData(50000, 16);
+
+		WHEN("it is encoded with a 16-symbol alphabet") {
+			std::vector<uint8_t> encoded, decoded;
+			NibbleCoder().encode(data.data(), data.size(), encoded);
+			NibbleCoder().decode(encoded.data(), encoded.size(), decoded);
+
+			THEN("it decodes to the same data") {
+				CHECK(decoded == data);
+			}
+		}
+		WHEN("it is encoded with 24-bit precision") {
+			std::vector<uint8_t> encoded, decoded;
+			WideCoder().encode(data.data(), data.size(), encoded);
+			WideCoder().decode(encoded.data(), encoded.size(), decoded);
+
+			THEN("it decodes to the same data") {
+				CHECK(decoded == data);
+			}
+		}
+	}
+	GIVEN("a byte outside of the alphabet")
+	{
+		std::vector<uint8_t> data = { 1, 2, 16 };
+		std::vector<uint8_t> encoded;
+
+		THEN("an exception is thrown") {
+			CHECK_THROWS_AS(NibbleCoder().encode(data.data(), data.size(), encoded), std::invalid_argument);
+		}
+	}
+}
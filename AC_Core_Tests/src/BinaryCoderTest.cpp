@@ -0,0 +1,78 @@
+#include <catch2/catch.hpp>
+#include "CoderTestHelpers.hpp"
+#include "BinaryCoder.hpp"
+#include "AdaptiveScalingCoder.hpp"
+
+#include <vector>
+#pragma warning( disable : 6237 6319 )
+
+SCENARIO("BinaryCoder decodes what it encoded", "[BinaryCoder]")
+{
+	const size_t SIZE = GENERATE(0, 1, 2, 17, 100000);
+	std::vector<uint8_t> data = skewedData(SIZE);
+
+	GIVEN("encoded data")
+	{
+		std::vector<uint8_t> encoded = encodedWith(BinaryCoder(), data);
+
+		THEN("it decodes to the same data and refuses it truncated") {
+			checkDecodes(BinaryCoder(), encoded, encoded.size() / 2, data);
+		}
+		THEN("it decodes the same when fed byte by byte") {
+			checkDecodesInChunks<BinaryCoder::Decoder>(encoded, 1, data);
+		}
+	}
+}
+
+SCENARIO("BinaryCoder handles carries and incompressible data", "[BinaryCoder]")
+{
+	GIVEN("bytes that are all ones or uniformly random")
+	{
+		std::vector<uint8_t> data(200000, 0xFF);
+		uint32_t state = 1;
+		for (size_t i = data.size() / 2; i < data.size(); i++) {
+			state ^= state << 13; state ^= state >> 17; state ^= state << 5;
+			data[i] = (uint8_t)state;
+		}
+
+		WHEN("they are encoded") {
+			std::vector<uint8_t> encoded, decoded;
+			BinaryCoder().encode(data.data(), data.size(), encoded);
+			BinaryCoder().decode(encoded.data(), encoded.size(), decoded);
+
+			THEN("they decode to the same data") {
+				CHECK(decoded == data);
+			}
+			THEN("random half grows by less than 3%") {
+				CAPTURE(encoded.size());
+				CHECK(encoded.size() < data.size() / 2 * 103 / 100);
+			}
+		}
+	}
+}
+
+SCENARIO("BinaryCoder streams are recognised by the format", "[BinaryCoder]")
+{
+	std::vector<uint8_t> data = skewedData(1000);
+
+	GIVEN("data encoded with BinaryCoder")
+	{
+		std::vector<uint8_t> encoded;
+		BinaryCoder().encode(data.data(), data.size(), encoded);
+
+		THEN("order-0 coder refuses it") {
+			std::vector<uint8_t> decoded;
+			CHECK_THROWS_AS(AdaptiveScalingCoder().decode(encoded.data(), encoded.size(), decoded), std::runtime_error);
+		}
+	}
+	GIVEN("data encoded with AdaptiveScalingCoder")
+	{
+		std::vector<uint8_t> encoded;
+		AdaptiveScalingCoder().encode(data.data(), data.size(), encoded);
+
+		THEN("BinaryCoder refuses it") {
+			std::vector<uint8_t> decoded;
+			CHECK_THROWS_AS(BinaryCoder().decode(encoded.data(), encoded.size(), decoded), std::runtime_error);
+		}
+	}
+}
@@ -91,4 +91,49 @@ SCENARIO("BitReader reads data from a file") {
 			}
 		}
 	}
-}
\ No newline at end of file
+}
+SCENARIO("BitReader takes several bits at once", "[BitReader]") {
+	GIVEN("A file with data in it") {
+		std::string filename = "_file_1.test.tmp";
+		std::ofstream file(filename, std::ios_base::binary);
+		file.put(0b0000'1101);
+		file.put((char)0b1111'0000);
+		file.close();
+
+		BitReader reader(filename);
+
+		WHEN("bits are peeked") {
+			uint32_t bits = reader.peekBits(5);
+
+			THEN("the first bit is the most significant one") {
+				CHECK(bits == 0b10110);
+			}
+			THEN("they are not consumed") {
+				CHECK(reader.read() == true);
+				CHECK(reader.read() == false);
+			}
+		}
+		WHEN("bits are consumed") {
+			reader.consumeBits(4);
+
+			THEN("reading continues after them") {
+				CHECK(reader.peekBits(8) == 0b0000'0000);
+				CHECK(reader.peekBits(12) == 0b0000'0000'1111);
+			}
+		}
+		WHEN("more bits than a file contains are peeked") {
+			reader.consumeBits(12);
+			uint32_t bits = reader.peekBits(32);
+
+			THEN("missing bits are '0'") {
+				CHECK(bits == 0xF000'0000);
+			}
+			THEN("EOF flag is set after consuming them") {
+				CHECK(reader.eof() == false);
+				reader.consumeBits(32);
+				CHECK(reader.eof() == true);
+			}
+		}
+		fs::remove(filename);
+	}
+}
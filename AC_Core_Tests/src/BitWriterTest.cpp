@@ -1,8 +1,10 @@
 #include <catch2/catch.hpp>
+#include <algorithm>
 #include <string>
 #include <filesystem>
 #include <fstream>
 #include "BitUtils/BitWriter.hpp"
+#include "AdaptiveScalingCoder.hpp"
 
 #pragma warning( disable : 6237 6319 )
 
@@ -106,6 +108,27 @@ SCENARIO("BitWriter writes data to a file", "[BitWriter]") {
 				CHECK(byte == 0b0011'1111);
 			}
 		}
+		WHEN("long runs of bits cross 64-bit word boundaries") {
+			writer << 1;
+			writer.writeN(0, 70);
+			writer.writeN(1, 130);
+			writer << 0;
+			writer.flush();
+
+			THEN("file contains all the bits in order") {
+				std::ifstream file(filename, std::ios_base::binary);
+				std::vector<int> bits;
+				for (int byte = file.get(); byte != EOF; byte = file.get())
+					for (int i = 0; i < 8; i++)
+						bits.push_back((byte >> i) & 1);
+
+				REQUIRE(bits.size() == 208);	// 202 bits padded to 26 bytes
+				CHECK(bits[0] == 1);
+				CHECK(std::count(bits.begin() + 1, bits.begin() + 71, 0) == 70);
+				CHECK(std::count(bits.begin() + 71, bits.begin() + 201, 1) == 130);
+				CHECK(std::count(bits.begin() + 201, bits.end(), 0) == 7);
+			}
+		}
 	}
 	fs::remove(filename);
 }
@@ -137,6 +160,23 @@ SCENARIO("BitWriter collects stats about bits being written", "[BitWriter]")
 				CHECK(stats.at(0xAB).writeCounter == 0);
 			}
 		}
+		WHEN("many bits are written for consecutive bytes")
+		{
+			writer.beginByte(0x01);
+			writer.writeN(1, 100);
+			writer.beginByte(0x02);
+			writer << 0;
+			writer.beginByte(0x01);
+			writer.writeN(0, 3);
+			std::vector<BitStat> stats = writer.getStats();
+
+			THEN("bits are counted for the byte that was being written") {
+				CHECK(stats.at(0x01).readCounter == 16);
+				CHECK(stats.at(0x01).writeCounter == 103);
+				CHECK(stats.at(0x02).readCounter == 8);
+				CHECK(stats.at(0x02).writeCounter == 1);
+			}
+		}
 		WHEN("nonexistent byte is begun")
 		{
 			writer.beginByte(0xFFF);
@@ -157,3 +197,45 @@ SCENARIO("BitWriter collects stats about bits being written", "[BitWriter]")
 
 	fs::remove(filename);
 }
+
+// Accepts a limited number of bytes, then fails like a full disk.
+class FailingSink : public ByteSink
+{
+public:
+	FailingSink(size_t capacity) : capacity(capacity) {}
+
+	void write(const uint8_t*, size_t size) override
+	{
+		if (size > capacity)
+			throw std::runtime_error("no space left");
+		capacity -= size;
+	}
+
+private:
+	size_t capacity;
+};
+
+SCENARIO("BitWriter passes sink errors to the caller", "[BitWriter]")
+{
+	GIVEN("a sink that fails after 1000 bytes")
+	{
+		FailingSink sink(1000);
+
+		THEN("writing more than it takes throws instead of terminating") {
+			auto writeMany = [&sink] {
+				BitWriter writer(sink);
+				for (int i = 0; i < 200000; i++)
+					writer.writeByte((byte_t)i);
+				writer.flush();
+			};
+			CHECK_THROWS_AS(writeMany(), std::runtime_error);
+		}
+		THEN("a coder encoding into it throws as well") {
+			std::vector<uint8_t> data(200000);
+			for (size_t i = 0; i < data.size(); i++)
+				data[i] = (uint8_t)(i * 2654435761u >> 24);
+			MemorySource source(data.data(), data.size());
+			CHECK_THROWS_AS(AdaptiveScalingCoder().encode(source, sink), std::runtime_error);
+		}
+	}
+}
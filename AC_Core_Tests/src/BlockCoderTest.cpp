@@ -0,0 +1,268 @@
+#include <catch2/catch.hpp>
+#include "BlockCoder.hpp"
+#include "AdaptiveScalingCoder.hpp"
+
+#include <vector>
+#pragma warning( disable : 6237 6319 )
+
+static std::unique_ptr<ArithmeticCoder> makeAdaptiveCoder()
+{
+	return std::make_unique<AdaptiveScalingCoder>();
+}
+
+static std::vector<uint8_t> sampleData(size_t size)
+{
+	std::vector<uint8_t> data(size);
+	uint32_t state = 12345;
+	for (size_t i = 0; i < size; i++) {
+		state = state * 1103515245 + 12345;
+		data[i] = (i / 1000) % 2 ? (uint8_t)(state >> 24) : (uint8_t)('a' + (state >> 28));
+	}
+	return data;
+}
+
+// Writes every byte twice and remembers how many it was given.
+class ExpandingCoder : public ArithmeticCoder
+{
+public:
+	ExpandingCoder(size_t& bytesRead)
+		: bytesRead(bytesRead) {}
+
+	using ArithmeticCoder::encode;
+	using ArithmeticCoder::decode;
+
+	Statistics encode(ByteSource& in, ByteSink& out) override
+	{
+		const uint8_t* chunk = nullptr;
+		while (size_t chunkSize = in.next(chunk))
+		{
+			out.write(chunk, chunkSize);
+			out.write(chunk, chunkSize);
+			bytesRead += chunkSize;
+		}
+		return Statistics();
+	}
+
+	void decode(ByteSource&, ByteSink&) override
+	{
+		throw std::logic_error("stored blocks are not decoded");
+	}
+
+private:
+	size_t& bytesRead;
+};
+
+SCENARIO("Block coder output doesn't depend on the number of threads", "[BlockCoder]")
+{
+	std::vector<uint8_t> data = sampleData(100000);
+
+	GIVEN("data encoded with one thread")
+	{
+		std::vector<uint8_t> reference;
+		BlockCoder(makeAdaptiveCoder, 1, 4096).encode(data.data(), data.size(), reference);
+
+		WHEN("it is encoded with more threads") {
+			unsigned threads = GENERATE(2, 3, 8);
+			std::vector<uint8_t> encoded;
+			BlockCoder(makeAdaptiveCoder, threads, 4096).encode(data.data(), data.size(), encoded);
+
+			THEN("output is byte-identical") {
+				CHECK(encoded == reference);
+			}
+			THEN("it can be decoded with any number of threads") {
+				std::vector<uint8_t> decoded;
+				BlockCoder(makeAdaptiveCoder, 5 - threads % 4).decode(encoded.data(), encoded.size(), decoded);
+				CHECK(decoded == data);
+			}
+		}
+	}
+}
+
+SCENARIO("Block coder handles any block size", "[BlockCoder]")
+{
+	GIVEN("some data")
+	{
+		size_t dataSize = GENERATE(0, 1, 999, 1000, 1001, 5000);
+		size_t blockSize = GENERATE(1, 1000, 1 << 20);
+		std::vector<uint8_t> data = sampleData(dataSize);
+
+		WHEN("it is encoded in blocks") {
+			std::vector<uint8_t> encoded;
+			Statistics stats = BlockCoder(makeAdaptiveCoder, 2, blockSize).encode(data.data(), data.size(), encoded);
+
+			THEN("it decodes to the same data") {
+				std::vector<uint8_t> decoded;
+				BlockCoder(makeAdaptiveCoder, 2).decode(encoded.data(), encoded.size(), decoded);
+				CHECK(decoded == data);
+			}
+		}
+	}
+	GIVEN("invalid block size")
+	{
+		THEN("an exception is thrown") {
+			CHECK_THROWS_AS(BlockCoder(makeAdaptiveCoder, 1, 0), std::invalid_argument);
+		}
+	}
+}
+
+SCENARIO("Block coder detects damaged containers", "[BlockCoder]")
+{
+	std::vector<uint8_t> data = sampleData(10000);
+	std::vector<uint8_t> encoded;
+	BlockCoder(makeAdaptiveCoder, 1, 1000).encode(data.data(), data.size(), encoded);
+	std::vector<uint8_t> decoded;
+
+	WHEN("container is truncated") {
+		encoded.resize(encoded.size() / 2);
+
+		THEN("an exception is thrown") {
+			CHECK_THROWS_AS(BlockCoder(makeAdaptiveCoder).decode(encoded.data(), encoded.size(), decoded), std::runtime_error);
+		}
+	}
+	WHEN("data is not a container") {
+		std::vector<uint8_t> plain;
+		AdaptiveScalingCoder().encode(data.data(), data.size(), plain);
+
+		THEN("an exception is thrown") {
+			CHECK_THROWS_AS(BlockCoder(makeAdaptiveCoder).decode(plain.data(), plain.size(), decoded), std::runtime_error);
+		}
+	}
+}
+
+SCENARIO("Block coder decodes a range of data using the index", "[BlockCoder]")
+{
+	std::vector<uint8_t> data = sampleData(10000);
+	std::vector<uint8_t> encoded;
+	BlockCoder(makeAdaptiveCoder, 1, 1000).encode(data.data(), data.size(), encoded);
+
+	GIVEN("a range inside the data")
+	{
+		uint64_t offset = GENERATE(0, 1, 999, 1000, 4321);
+		uint64_t length = GENERATE(0, 1, 1000, 2500);
+		unsigned threads = GENERATE(1, 3);
+
+		WHEN("it is decoded") {
+			std::vector<uint8_t> decoded;
+			BlockCoder(makeAdaptiveCoder, threads).decodeRange(encoded.data(), encoded.size(), offset, length, decoded);
+
+			THEN("only that range is returned") {
+				CHECK(decoded == std::vector<uint8_t>(data.begin() + offset, data.begin() + offset + length));
+			}
+		}
+	}
+	GIVEN("a range that goes past the end of data")
+	{
+		uint64_t offset = GENERATE(9500, 10000, 20000);
+		std::vector<uint8_t> decoded;
+		BlockCoder(makeAdaptiveCoder).decodeRange(encoded.data(), encoded.size(), offset, 1000, decoded);
+
+		THEN("it is cut at the end of data") {
+			size_t begin = std::min<size_t>(offset, data.size());
+			CHECK(decoded == std::vector<uint8_t>(data.begin() + begin, data.end()));
+		}
+	}
+	GIVEN("a container without the footer")
+	{
+		encoded.resize(encoded.size() - 1);
+		THEN("an exception is thrown") {
+			std::vector<uint8_t> decoded;
+			CHECK_THROWS_AS(BlockCoder(makeAdaptiveCoder).decodeRange(encoded.data(), encoded.size(), 0, 10, decoded), std::runtime_error);
+		}
+	}
+	GIVEN("a container with a damaged index")
+	{
+		// the index is 10 entries of two offsets, right before the footer
+		const size_t indexOffset = encoded.size() - 28 - 10 * 16;
+		const size_t entry = GENERATE(0, 3, 9);
+		const uint8_t damage = GENERATE(0x80, 0xFF);
+		encoded[indexOffset + entry * 16 + 1] ^= damage;	// original offset moved by 256 * damage
+
+		THEN("an exception is thrown instead of reading past a block") {
+			std::vector<uint8_t> decoded;
+			CHECK_THROWS_AS(BlockCoder(makeAdaptiveCoder).decodeRange(encoded.data(), encoded.size(), 0, data.size(), decoded), std::runtime_error);
+		}
+	}
+	GIVEN("an index whose offsets ascend but don't match the blocks")
+	{
+		const size_t indexOffset = encoded.size() - 28 - 10 * 16;
+		encoded[indexOffset + 9 * 16] ^= 1;		// the last block starts at 9001 instead of 9000
+
+		THEN("an exception is thrown after decoding the block") {
+			std::vector<uint8_t> decoded;
+			CHECK_THROWS_AS(BlockCoder(makeAdaptiveCoder).decodeRange(encoded.data(), encoded.size(), 8500, 1000, decoded), std::runtime_error);
+		}
+	}
+}
+
+SCENARIO("Block coder stores blocks that don't compress", "[BlockCoder]")
+{
+	GIVEN("random data")
+	{
+		std::vector<uint8_t> data(300000);
+		uint32_t state = 777;
+		for (uint8_t& byte : data) {
+			state = state * 1103515245 + 12345;
+			byte = (uint8_t)(state >> 24);
+		}
+		size_t blockSize = GENERATE(1000, 1 << 16, 1 << 20);
+
+		WHEN("it is encoded in blocks") {
+			std::vector<uint8_t> encoded;
+			Statistics stats = BlockCoder(makeAdaptiveCoder, 2, blockSize).encode(data.data(), data.size(), encoded);
+
+			THEN("blocks are stored as they are") {
+				CHECK(encoded.size() < data.size() + 100 + 24 * (data.size() / blockSize + 1));
+				CHECK(stats.compressionRatio() == 0);
+			}
+			THEN("it decodes to the same data") {
+				std::vector<uint8_t> decoded;
+				BlockCoder(makeAdaptiveCoder, 3).decode(encoded.data(), encoded.size(), decoded);
+				CHECK(decoded == data);
+			}
+			THEN("a range of it decodes too") {
+				std::vector<uint8_t> decoded;
+				BlockCoder(makeAdaptiveCoder).decodeRange(encoded.data(), encoded.size(), 12345, 100000, decoded);
+				CHECK(decoded == std::vector<uint8_t>(data.begin() + 12345, data.begin() + 112345));
+			}
+		}
+	}
+	GIVEN("random data in small blocks")
+	{
+		std::vector<uint8_t> data(8 * 4096);
+		uint32_t state = 777;
+		for (uint8_t& byte : data) {
+			state = state * 1103515245 + 12345;
+			byte = (uint8_t)(state >> 24);
+		}
+
+		size_t bytesRead = 0;
+		auto factory = [&bytesRead]() { return std::make_unique<ExpandingCoder>(bytesRead); };
+		std::vector<uint8_t> encoded;
+		BlockCoder(factory, 1, 4096).encode(data.data(), data.size(), encoded);
+
+		THEN("blocks are stored without being coded") {
+			CHECK(bytesRead == 0);
+			std::vector<uint8_t> decoded;
+			BlockCoder(factory).decode(encoded.data(), encoded.size(), decoded);
+			CHECK(decoded == data);
+		}
+	}
+	GIVEN("a coder whose output grows")
+	{
+		std::vector<uint8_t> data(1 << 20);
+		for (size_t i = 0; i < data.size(); i++)
+			data[i] = (uint8_t)('a' + i % 7);
+
+		size_t bytesRead = 0;
+		auto factory = [&bytesRead]() { return std::make_unique<ExpandingCoder>(bytesRead); };
+		std::vector<uint8_t> encoded;
+		BlockCoder(factory, 1, data.size()).encode(data.data(), data.size(), encoded);
+
+		THEN("coding stops early and the block is stored") {
+			CHECK(bytesRead < data.size() / 4);
+			std::vector<uint8_t> decoded;
+			BlockCoder(factory).decode(encoded.data(), encoded.size(), decoded);
+			CHECK(decoded == data);
+		}
+	}
+}
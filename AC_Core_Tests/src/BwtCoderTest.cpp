@@ -0,0 +1,139 @@
+#include <catch2/catch.hpp>
+#include "CoderTestHelpers.hpp"
+#include "BwtCoder.hpp"
+#include "AdaptiveScalingCoder.hpp"
+
+#include <string>
+#include <vector>
+#pragma warning( disable : 6237 6319 )
+
+// Words from a small vocabulary, like text.
+static std::vector<uint8_t> words(size_t size)
+{
+	static const char* VOCABULARY[] = { "the ", "coder ", "block ", "sorting ", "of ", "and ", "transform ", "text ", "\n" };
+	std::vector<uint8_t> data;
+	uint32_t state = 2020;
+	while (data.size() < size) {
+		state = state * 1103515245 + 12345;
+		std::string word = VOCABULARY[(state >> 16) % 9];
+		data.insert(data.end(), word.begin(), word.end());
+	}
+	data.resize(size);
+	return data;
+}
+
+SCENARIO("BWT and move-to-front can be inverted", "[BwtCoder]")
+{
+	const size_t SIZE = GENERATE(1, 2, 3, 100, 4000);
+
+	GIVEN(SIZE << " bytes of text")
+	{
+		std::vector<uint8_t> data = words(SIZE);
+
+		THEN("the inverse transform restores them") {
+			std::vector<uint8_t> last(SIZE), restored(SIZE);
+			std::vector<int32_t> sa;
+			std::vector<uint32_t> next;
+			uint32_t primary = BwtCoder::transform(data.data(), SIZE, last.data(), sa);
+			BwtCoder::inverseTransform(last.data(), SIZE, primary, restored.data(), next);
+			CHECK(restored == data);
+		}
+		THEN("the inverse move-to-front restores them") {
+			std::vector<uint8_t> ranks = data;
+			BwtCoder::moveToFront(ranks.data(), SIZE);
+			BwtCoder::inverseMoveToFront(ranks.data(), SIZE);
+			CHECK(ranks == data);
+		}
+	}
+	GIVEN("a known example")
+	{
+		const std::string text = "banana";
+		std::vector<uint8_t> last(text.size());
+		std::vector<int32_t> sa;
+		uint32_t primary = BwtCoder::transform((const uint8_t*)text.data(), text.size(), last.data(), sa);
+
+		THEN("it is the last column of the sorted rotations of banana$") {
+			// $banana, a$banan, ana$ban, anana$b, banana$, na$bana, nana$ba
+			CHECK(std::string(last.begin(), last.end()) == "annbaa");
+			CHECK(primary == 4);
+		}
+	}
+}
+
+SCENARIO("BwtCoder decodes what it encoded", "[BwtCoder]")
+{
+	const size_t BLOCK_SIZE = GENERATE(BwtCoder::MIN_BLOCK_SIZE, BwtCoder::DEFAULT_BLOCK_SIZE);
+	const size_t SIZE = GENERATE(0, 1, 1000, 1024, 1025, 100000);
+
+	GIVEN(SIZE << " bytes in blocks of " << BLOCK_SIZE)
+	{
+		std::vector<uint8_t> data = words(SIZE);
+		std::vector<uint8_t> encoded = encodedWith(BwtCoder(BLOCK_SIZE), data);
+
+		THEN("it decodes to the same data and refuses it truncated") {
+			checkDecodes(BwtCoder(), encoded, encoded.size() / 2, data);
+		}
+		THEN("it decodes when fed in chunks of 5 bytes") {
+			checkDecodesInChunks<BwtCoder::Decoder>(encoded, 5, data);
+		}
+	}
+}
+
+SCENARIO("BwtCoder detects invalid data and parameters", "[BwtCoder]")
+{
+	std::vector<uint8_t> data = words(20000);
+	std::vector<uint8_t> encoded;
+	BwtCoder(BwtCoder::MIN_BLOCK_SIZE).encode(data.data(), data.size(), encoded);
+
+	GIVEN("truncated data")
+	{
+		THEN("decoding fails") {
+			std::vector<uint8_t> decoded;
+			CHECK_THROWS_AS(BwtCoder().decode(encoded.data(), encoded.size() / 2, decoded), std::runtime_error);
+			CHECK_THROWS_AS(BwtCoder().decode(encoded.data(), 6, decoded), std::runtime_error);
+		}
+	}
+	GIVEN("a block size over the limit in the data")
+	{
+		encoded[StreamHeader::SIZE + 3] = 0x10;
+
+		THEN("it is refused before allocating the block") {
+			std::vector<uint8_t> decoded;
+			CHECK_THROWS_AS(BwtCoder().decode(encoded.data(), encoded.size(), decoded), std::runtime_error);
+		}
+	}
+	GIVEN("data of another format")
+	{
+		std::vector<uint8_t> other;
+		AdaptiveScalingCoder().encode(data.data(), data.size(), other);
+
+		THEN("it is refused") {
+			std::vector<uint8_t> decoded;
+			CHECK_THROWS_AS(BwtCoder().decode(other.data(), other.size(), decoded), std::runtime_error);
+		}
+	}
+	GIVEN("invalid block sizes")
+	{
+		THEN("an exception is thrown") {
+			CHECK_THROWS_AS(BwtCoder(BwtCoder::MIN_BLOCK_SIZE - 1), std::invalid_argument);
+			CHECK_THROWS_AS(BwtCoder(BwtCoder::MAX_BLOCK_SIZE + 1), std::invalid_argument);
+		}
+	}
+}
+
+SCENARIO("BwtCoder compresses text better than order-0", "[BwtCoder]")
+{
+	std::vector<uint8_t> data = words(200000);
+
+	GIVEN("text encoded with both coders")
+	{
+		std::vector<uint8_t> bwt, order0;
+		BwtCoder().encode(data.data(), data.size(), bwt);
+		AdaptiveScalingCoder().encode(data.data(), data.size(), order0);
+
+		THEN("the BWT output is smaller") {
+			CAPTURE(bwt.size(), order0.size());
+			CHECK(bwt.size() < order0.size());
+		}
+	}
+}
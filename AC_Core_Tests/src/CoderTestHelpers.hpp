@@ -0,0 +1,54 @@
+#pragma once
+#include <catch2/catch.hpp>
+#include "IO/ByteSink.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+// Mostly small values, sometimes any, so every coder has something to compress.
+inline std::vector<uint8_t> skewedData(size_t size)
+{
+	std::vector<uint8_t> data(size);
+	uint32_t state = 2020;
+	for (size_t i = 0; i < size; i++) {
+		state = state * 1103515245 + 12345;
+		data[i] = (uint8_t)((state >> 16) % (1 + (state >> 29) * 36));
+	}
+	return data;
+}
+
+template<typename Coder>
+std::vector<uint8_t> encodedWith(Coder&& coder, const std::vector<uint8_t>& data)
+{
+	std::vector<uint8_t> encoded;
+	coder.encode(data.data(), data.size(), encoded);
+	return encoded;
+}
+
+// Checks that encoded decodes to data and that its first truncatedSize bytes alone are refused.
+template<typename Coder>
+void checkDecodes(Coder&& coder, const std::vector<uint8_t>& encoded, size_t truncatedSize, const std::vector<uint8_t>& data)
+{
+	std::vector<uint8_t> decoded;
+	coder.decode(encoded.data(), encoded.size(), decoded);
+	CHECK(decoded == data);
+
+	std::vector<uint8_t> truncated;
+	CHECK_THROWS_AS(coder.decode(encoded.data(), truncatedSize, truncated), std::runtime_error);
+}
+
+// Checks that a push decoder fed chunkSize bytes at a time decodes encoded to data and sees its end.
+template<typename Decoder>
+void checkDecodesInChunks(const std::vector<uint8_t>& encoded, size_t chunkSize, const std::vector<uint8_t>& data)
+{
+	std::vector<uint8_t> decoded;
+	MemorySink sink(decoded);
+	Decoder decoder(sink);
+	for (size_t i = 0; i < encoded.size(); i += chunkSize)
+		decoder.feed(encoded.data() + i, std::min(chunkSize, encoded.size() - i));
+	decoder.finish();
+
+	CHECK(decoder.done());
+	CHECK(decoded == data);
+}
@@ -0,0 +1,109 @@
+#include <catch2/catch.hpp>
+#include "CoderTestHelpers.hpp"
+#include "ContextMixingModel.hpp"
+#include "ContextMixingCoder.hpp"
+#include "PPMCoder.hpp"
+
+#include <string>
+#include <vector>
+
+#pragma warning( disable : 6237 6319 )
+
+SCENARIO("ContextMixingModel learns repeated data", "[ContextMixingModel]")
+{
+	GIVEN("ContextMixingModel instance")
+	{
+		ContextMixingModel model(ContextMixingModel::MIN_MEMORY_BITS);
+
+		THEN("the first prediction is about even") {
+			uint32_t p = model.predictOne();
+			CHECK(p > BinaryProbability::ONE / 2 - 16);
+			CHECK(p < BinaryProbability::ONE / 2 + 16);
+		}
+		WHEN("the same byte is seen many times") {
+			for (int i = 0; i < 1000; i++)
+				for (int bit = 7; bit >= 0; bit--) {
+					model.predictOne();
+					model.update(('x' >> bit) & 1);
+				}
+
+			THEN("its bits are predicted almost certainly") {
+				bool allCertain = true;
+				for (int bit = 7; bit >= 0; bit--) {
+					uint32_t p = model.predictOne();
+					int value = ('x' >> bit) & 1;
+					allCertain &= value ? p > BinaryProbability::ONE * 9 / 10 : p < BinaryProbability::ONE / 10;
+					model.update(value);
+				}
+				CHECK(allCertain);
+			}
+		}
+	}
+	GIVEN("a long run of the same byte")
+	{
+		ContextMixingModel model(ContextMixingModel::MIN_MEMORY_BITS);
+		for (int i = 0; i < (1 << 20); i++)
+			for (int bit = 0; bit < 8; bit++) {
+				model.predictOne();
+				model.update(1);
+			}
+
+		THEN("mixer weights stay bounded") {
+			CHECK(model.largestWeight() <= (1 << 20));
+		}
+	}
+	GIVEN("invalid memory")
+	{
+		THEN("an exception is thrown") {
+			CHECK_THROWS_AS(ContextMixingModel(ContextMixingModel::MIN_MEMORY_BITS - 1), std::invalid_argument);
+			CHECK_THROWS_AS(ContextMixingCoder(1000), std::invalid_argument);
+		}
+	}
+}
+
+SCENARIO("ContextMixingCoder decodes what it encoded", "[ContextMixingModel]")
+{
+	const size_t SIZE = GENERATE(0, 1, 2, 17, 30000);
+	std::vector<uint8_t> data(SIZE);
+	uint32_t state = 7;
+	for (size_t i = 0; i < SIZE; i++) {
+		state ^= state << 13; state ^= state >> 17; state ^= state << 5;
+		data[i] = state % 4 ? "repeated words "[i % 15] : (uint8_t)(state >> 8);
+	}
+
+	GIVEN("encoded data")
+	{
+		std::vector<uint8_t> encoded = encodedWith(ContextMixingCoder(1 << 20), data);
+
+		THEN("it decodes to the same data, whatever memory the decoder was given, and refuses it truncated") {
+			checkDecodes(ContextMixingCoder(64 << 20), encoded, encoded.size() / 2, data);
+		}
+		THEN("it decodes the same when fed byte by byte") {
+			checkDecodesInChunks<ContextMixingCoder::Decoder>(encoded, 1, data);
+		}
+	}
+}
+
+SCENARIO("ContextMixingCoder compresses text better than PPM", "[ContextMixingModel]")
+{
+	std::string text;
+	for (int i = 0; i < 2000; i++)
+		text += "the quick brown fox jumps over the lazy dog " + std::to_string(i % 37) + "\n";
+	const uint8_t* data = (const uint8_t*)text.data();
+
+	GIVEN("text encoded with both coders")
+	{
+		std::vector<uint8_t> ppm, cm;
+		PPMCoder(4, PPMCoder::MEMORY_UNIT).encode(data, text.size(), ppm);
+		ContextMixingCoder(1 << 20).encode(data, text.size(), cm);
+
+		THEN("context mixing output is smaller") {
+			CHECK(cm.size() < ppm.size());
+		}
+		THEN("it decodes to the same text") {
+			std::vector<uint8_t> decoded;
+			ContextMixingCoder().decode(cm.data(), cm.size(), decoded);
+			CHECK(std::string(decoded.begin(), decoded.end()) == text);
+		}
+	}
+}
@@ -0,0 +1,121 @@
+#include <catch2/catch.hpp>
+#include "FenwickModel.hpp"
+#include "AdaptiveModel.hpp"
+
+#include <cstdlib>
+#include <ctime>
+
+#pragma warning( disable : 6237 6319 )
+
+SCENARIO("FenwickModel has default values", "[FenwickModel]")
+{
+	const size_t NUMBER_OF_SYMBOLS = 7;
+	const size_t MAX_FREQUENCY = 100;
+
+	GIVEN("FenwickModel instance")
+	{
+		FenwickModel model(NUMBER_OF_SYMBOLS, MAX_FREQUENCY);
+
+		THEN("default occurence of every symbol is 1")
+		{
+			CHECK(model.totalFrequency() == NUMBER_OF_SYMBOLS);
+			for (size_t i = 0; i < NUMBER_OF_SYMBOLS; i++)
+			{
+				CHECK(model.frequencyBegin(i) == i);
+				CHECK(model.frequencyEnd(i) == i + 1);
+			}
+		}
+	}
+	GIVEN("too low max frequency")
+	{
+		THEN("an exception is thrown") {
+			CHECK_THROWS_AS(FenwickModel(NUMBER_OF_SYMBOLS, NUMBER_OF_SYMBOLS), std::invalid_argument);
+		}
+	}
+}
+
+SCENARIO("FenwickModel keeps the same frequencies as AdaptiveModel", "[FenwickModel]")
+{
+	const size_t NUMBER_OF_SYMBOLS = GENERATE(1, 2, 7, 64, 257);
+	const size_t MAX_FREQUENCY = GENERATE(300, 5000);
+
+	GIVEN("FenwickModel and AdaptiveModel instances")
+	{
+		FenwickModel model(NUMBER_OF_SYMBOLS, MAX_FREQUENCY);
+		AdaptiveModel reference(NUMBER_OF_SYMBOLS, MAX_FREQUENCY);
+
+		WHEN("both models are updated with the same symbols (including rescaling)")
+		{
+			srand((int)time(NULL));
+			for (int i = 0; i < 20000; i++)
+			{
+				size_t symbol = (rand() % 3 == 0) ? 0 : rand() % NUMBER_OF_SYMBOLS;
+				model.update(symbol);
+				reference.update(symbol);
+			}
+
+			THEN("all cumulative frequencies are equal") {
+				REQUIRE(model.totalFrequency() == reference.totalFrequency());
+				for (size_t s = 0; s < NUMBER_OF_SYMBOLS; s++) {
+					CHECK(model.frequencyBegin(s) == reference.frequencyBegin(s));
+					CHECK(model.frequencyEnd(s) == reference.frequencyEnd(s));
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("FenwickModel finds a symbol by cumulative frequency", "[FenwickModel]")
+{
+	const size_t NUMBER_OF_SYMBOLS = GENERATE(1, 5, 8, 257);
+	const size_t MAX_FREQUENCY = 1000;
+
+	GIVEN("updated FenwickModel instance")
+	{
+		FenwickModel model(NUMBER_OF_SYMBOLS, MAX_FREQUENCY);
+		srand((int)time(NULL));
+		for (int i = 0; i < 3000; i++)
+			model.update(rand() % NUMBER_OF_SYMBOLS);
+
+		THEN("every count maps to the symbol whose range contains it") {
+			for (size_t count = 0; count < model.totalFrequency(); count++) {
+				size_t symbol = model.findSymbol(count);
+				REQUIRE(symbol < NUMBER_OF_SYMBOLS);
+				CHECK(model.frequencyBegin(symbol) <= count);
+				CHECK(count < model.frequencyEnd(symbol));
+			}
+		}
+	}
+}
+
+SCENARIO("FenwickModel changes frequencies and scales", "[FenwickModel]")
+{
+	const size_t NUMBER_OF_SYMBOLS = 4;
+	const size_t MAX_FREQUENCY = 8;
+
+	GIVEN("FenwickModel instance")
+	{
+		FenwickModel model(NUMBER_OF_SYMBOLS, MAX_FREQUENCY);
+
+		WHEN("updating symbol would potentially overflow max frequency")
+		{
+			model.update(0);
+			model.update(0);
+			model.update(0);
+			model.update(1);
+			CHECK(model.totalFrequency() == MAX_FREQUENCY);
+			model.update(1);
+			model.update(2);
+
+			THEN("total frequency doesn't exceed maximum") {
+				CHECK(model.totalFrequency() <= MAX_FREQUENCY);
+				CHECK(model.frequencyEnd(NUMBER_OF_SYMBOLS - 1) == model.totalFrequency());
+			}
+			THEN("all symbols have positive frequency") {
+				for (size_t s = 0; s < model.size(); s++) {
+					CHECK(model.frequencyBegin(s) < model.frequencyEnd(s));
+				}
+			}
+		}
+	}
+}
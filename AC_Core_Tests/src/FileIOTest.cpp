@@ -0,0 +1,114 @@
+#include <catch2/catch.hpp>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <vector>
+#include "IO/FileIO.hpp"
+
+#pragma warning( disable : 6237 6319 )
+
+namespace fs = std::filesystem;
+
+static std::vector<uint8_t> readAll(ByteSource& source)
+{
+	std::vector<uint8_t> data;
+	const uint8_t* chunk;
+	while (size_t size = source.next(chunk))
+		data.insert(data.end(), chunk, chunk + size);
+	return data;
+}
+
+static std::vector<uint8_t> sampleData(size_t size)
+{
+	std::vector<uint8_t> data(size);
+	for (size_t i = 0; i < size; i++)
+		data[i] = (uint8_t)(i * 7 + i / 251);
+	return data;
+}
+
+SCENARIO("File sources read the whole file", "[FileIO]")
+{
+	FileBackend backend = GENERATE(FileBackend::Buffered, FileBackend::Mapped);
+	size_t fileSize = GENERATE(0, 1, 65536, 200000);
+
+	GIVEN("A file with data in it") {
+		std::string filename = "_file_io.test.tmp";
+		std::vector<uint8_t> data = sampleData(fileSize);
+		{
+			std::ofstream file(filename, std::ios_base::binary);
+			file.write((const char*)data.data(), data.size());
+		}
+
+		WHEN("it is opened") {
+			auto source = openFileSource(filename, backend);
+
+			THEN("size is known and all bytes are read") {
+				CHECK(source->size() == (long long)fileSize);
+				CHECK(readAll(*source) == data);
+			}
+			THEN("any part of it can be read at random") {
+				REQUIRE(source->seekable());
+				std::vector<uint8_t> part(100);
+				size_t offset = fileSize / 2;
+				size_t count = source->readAt(offset, part.data(), part.size());
+				CHECK(count == std::min<size_t>(100, fileSize - offset));
+				CHECK(std::equal(part.begin(), part.begin() + count, data.begin() + offset));
+				CHECK(readAll(*source) == data);	// sequential reading is not affected
+			}
+		}
+
+		fs::remove(filename);
+	}
+	GIVEN("A file name to non-existent file") {
+		std::string filename = "_file_io.test.tmp";
+		fs::remove(filename);
+
+		THEN("An error is thrown") {
+			REQUIRE_THROWS_AS(openFileSource(filename, backend), std::runtime_error);
+		}
+	}
+}
+
+SCENARIO("File sinks write all data to a new file", "[FileIO]")
+{
+	FileBackend backend = GENERATE(FileBackend::Buffered, FileBackend::Mapped);
+	std::string filename = "_file_io.test.tmp";
+	fs::remove(filename);
+
+	GIVEN("Data written in pieces of different sizes (more than preallocated)") {
+		std::vector<uint8_t> data = sampleData(3 << 20);
+		{
+			auto sink = createFileSink(filename, backend, 1000);
+			size_t position = 0, piece = 1;
+			while (position < data.size()) {
+				size_t size = std::min(piece, data.size() - position);
+				sink->write(data.data() + position, size);
+				position += size;
+				piece = piece * 3 % 200003;
+			}
+			sink->flush();
+		}
+
+		THEN("file has exactly the same content") {
+			REQUIRE(fs::file_size(filename) == data.size());
+			auto source = openFileSource(filename);
+			CHECK(readAll(*source) == data);
+		}
+	}
+	GIVEN("Nothing written") {
+		createFileSink(filename, backend, 4096);
+
+		THEN("file is empty") {
+			CHECK(fs::file_size(filename) == 0);
+		}
+	}
+	GIVEN("An existing file") {
+		std::ofstream(filename).close();
+
+		THEN("it is not overridden") {
+			REQUIRE_THROWS_AS(createFileSink(filename, backend), std::runtime_error);
+		}
+	}
+
+	fs::remove(filename);
+}
@@ -0,0 +1,74 @@
+#include <catch2/catch.hpp>
+#include "GroupedModel.hpp"
+#include "FenwickModel.hpp"
+#include "SimdKernels.hpp"
+
+#include <cstdlib>
+#include <ctime>
+
+#pragma warning( disable : 6237 6319 )
+
+using InstructionSet = SimdKernels::InstructionSet;
+
+SCENARIO("GroupedModel keeps the same frequencies as FenwickModel", "[GroupedModel]")
+{
+	const size_t NUMBER_OF_SYMBOLS = GENERATE(1, 2, 15, 16, 17, 64, 257);
+	const size_t MAX_FREQUENCY = GENERATE(300, 5000);
+	const InstructionSet SET = GENERATE(InstructionSet::Scalar, InstructionSet::SSE2);
+
+	GIVEN("GroupedModel and FenwickModel instances")
+	{
+		InstructionSet previous = SimdKernels::active();
+		SimdKernels::setActive(SET);
+		GroupedModel model(NUMBER_OF_SYMBOLS, MAX_FREQUENCY);
+		FenwickModel reference(NUMBER_OF_SYMBOLS, MAX_FREQUENCY);
+
+		WHEN("both models are updated with the same symbols (including rescaling)")
+		{
+			srand((int)time(NULL));
+			for (int i = 0; i < 20000; i++)
+			{
+				size_t symbol = (rand() % 3 == 0) ? NUMBER_OF_SYMBOLS - 1 : rand() % NUMBER_OF_SYMBOLS;
+				model.update(symbol);
+				reference.update(symbol);
+			}
+
+			THEN("all cumulative frequencies are equal") {
+				REQUIRE(model.totalFrequency() == reference.totalFrequency());
+				for (size_t s = 0; s < NUMBER_OF_SYMBOLS; s++) {
+					CHECK(model.frequencyBegin(s) == reference.frequencyBegin(s));
+					CHECK(model.frequencyEnd(s) == reference.frequencyEnd(s));
+				}
+			}
+			THEN("every count maps to the same symbol") {
+				for (size_t count = 0; count < model.totalFrequency(); count++)
+					REQUIRE(model.findSymbol(count) == reference.findSymbol(count));
+			}
+		}
+		SimdKernels::setActive(previous);
+	}
+}
+
+SCENARIO("GroupedModel has default values", "[GroupedModel]")
+{
+	const size_t NUMBER_OF_SYMBOLS = 20;
+
+	GIVEN("GroupedModel instance")
+	{
+		GroupedModel model(NUMBER_OF_SYMBOLS, 100);
+
+		THEN("default occurence of every symbol is 1") {
+			CHECK(model.totalFrequency() == NUMBER_OF_SYMBOLS);
+			for (size_t i = 0; i < NUMBER_OF_SYMBOLS; i++) {
+				CHECK(model.frequencyBegin(i) == i);
+				CHECK(model.findSymbol(i) == i);
+			}
+		}
+	}
+	GIVEN("too low max frequency")
+	{
+		THEN("an exception is thrown") {
+			CHECK_THROWS_AS(GroupedModel(NUMBER_OF_SYMBOLS, NUMBER_OF_SYMBOLS), std::invalid_argument);
+		}
+	}
+}
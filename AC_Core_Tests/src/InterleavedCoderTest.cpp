@@ -0,0 +1,51 @@
+#include <catch2/catch.hpp>
+#include "CoderTestHelpers.hpp"
+#include "InterleavedCoder.hpp"
+#include "AdaptiveScalingCoder.hpp"
+
+#include <vector>
+#pragma warning( disable : 6237 6319 )
+
+SCENARIO("InterleavedCoder decodes what it encoded", "[InterleavedCoder]")
+{
+	const int STREAMS = GENERATE(2, 4, 8);
+	const size_t SIZE = GENERATE(0, 1, 2, 7, 8, 9, 17, 300000);
+	std::vector<uint8_t> data = skewedData(SIZE);
+
+	GIVEN("data encoded in " << STREAMS << " streams")
+	{
+		std::vector<uint8_t> encoded = encodedWith(InterleavedCoder(STREAMS), data);
+
+		THEN("it decodes to the same data and refuses it truncated") {
+			checkDecodes(InterleavedCoder(), encoded, encoded.size() - 1, data);
+		}
+	}
+}
+
+SCENARIO("InterleavedCoder compresses as well as a single stream", "[InterleavedCoder]")
+{
+	std::vector<uint8_t> data = skewedData(300000);
+
+	GIVEN("data encoded in 8 streams and in one")
+	{
+		std::vector<uint8_t> interleaved, single;
+		InterleavedCoder(8).encode(data.data(), data.size(), interleaved);
+		AdaptiveScalingCoder().encode(data.data(), data.size(), single);
+
+		THEN("the sizes differ by less than 1%") {
+			CAPTURE(interleaved.size(), single.size());
+			CHECK(interleaved.size() < single.size() * 101 / 100);
+		}
+		THEN("order-0 coder refuses the interleaved stream") {
+			std::vector<uint8_t> decoded;
+			CHECK_THROWS_AS(AdaptiveScalingCoder().decode(interleaved.data(), interleaved.size(), decoded), std::runtime_error);
+		}
+	}
+	GIVEN("invalid number of streams")
+	{
+		THEN("an exception is thrown") {
+			CHECK_THROWS_AS(InterleavedCoder(3), std::invalid_argument);
+			CHECK_THROWS_AS(InterleavedCoder(16), std::invalid_argument);
+		}
+	}
+}
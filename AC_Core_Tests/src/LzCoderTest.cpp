@@ -0,0 +1,145 @@
+#include <catch2/catch.hpp>
+#include "CoderTestHelpers.hpp"
+#include "LzCoder.hpp"
+#include "AdaptiveScalingCoder.hpp"
+
+#include <string>
+#include <vector>
+#pragma warning( disable : 6237 6319 )
+
+// Lines from a few templates with changing numbers, like a log.
+static std::vector<uint8_t> logLines(size_t size)
+{
+	static const char* TEMPLATES[] = { "GET /index.html 200 ", "POST /api/login 302 ", "GET /favicon.ico 404 " };
+	std::vector<uint8_t> data;
+	uint32_t state = 2020;
+	while (data.size() < size) {
+		state = state * 1103515245 + 12345;
+		std::string line = TEMPLATES[(state >> 16) % 3] + std::to_string((state >> 8) % 1000) + "\n";
+		data.insert(data.end(), line.begin(), line.end());
+	}
+	data.resize(size);
+	return data;
+}
+
+static std::vector<uint8_t> noise(size_t size)
+{
+	std::vector<uint8_t> data(size);
+	uint32_t state = 7;
+	for (uint8_t& byte : data) {
+		state = state * 1103515245 + 12345;
+		byte = (uint8_t)(state >> 24);
+	}
+	return data;
+}
+
+SCENARIO("LzCoder decodes what it encoded", "[LzCoder]")
+{
+	const int WINDOW_BITS = GENERATE(LzCoder::MIN_WINDOW_BITS, LzCoder::DEFAULT_WINDOW_BITS);
+	const size_t SIZE = GENERATE(0, 1, 4, 5, 1000, 300000);
+
+	GIVEN(SIZE << " bytes of log lines with a window of 2^" << WINDOW_BITS)
+	{
+		std::vector<uint8_t> data = logLines(SIZE);
+		std::vector<uint8_t> encoded = encodedWith(LzCoder(WINDOW_BITS), data);
+
+		THEN("it decodes to the same data and refuses it truncated") {
+			checkDecodes(LzCoder(), encoded, encoded.size() / 2, data);
+		}
+	}
+	GIVEN("noise, runs and overlapping matches")
+	{
+		std::vector<uint8_t> data = noise(SIZE);
+		data.insert(data.end(), 70000, 'a');		// longer than MAX_MATCH
+		std::vector<uint8_t> part = noise(SIZE / 2 + 3);
+		data.insert(data.end(), part.begin(), part.end());
+
+		std::vector<uint8_t> encoded = encodedWith(LzCoder(WINDOW_BITS), data);
+
+		THEN("it decodes to the same data and refuses it truncated") {
+			checkDecodes(LzCoder(), encoded, encoded.size() / 2, data);
+		}
+	}
+}
+
+SCENARIO("LzCoder encoder and decoder can be fed in small chunks", "[LzCoder]")
+{
+	std::vector<uint8_t> data = logLines(100000);
+	std::vector<uint8_t> whole;
+	LzCoder(LzCoder::MIN_WINDOW_BITS).encode(data.data(), data.size(), whole);
+
+	GIVEN("data fed in chunks of 7 bytes")
+	{
+		std::vector<uint8_t> chunked;
+		MemorySink sink(chunked);
+		LzCoder::Encoder encoder(sink, LzCoder::MIN_WINDOW_BITS);
+		for (size_t i = 0; i < data.size(); i += 7)
+			encoder.feed(data.data() + i, std::min<size_t>(7, data.size() - i));
+		encoder.finish();
+
+		THEN("the output is the same as from one call") {
+			CHECK(chunked == whole);
+		}
+		THEN("it decodes in chunks of 3 bytes") {
+			checkDecodesInChunks<LzCoder::Decoder>(whole, 3, data);
+		}
+	}
+}
+
+SCENARIO("LzCoder detects invalid data and parameters", "[LzCoder]")
+{
+	std::vector<uint8_t> data = logLines(20000);
+	std::vector<uint8_t> encoded;
+	LzCoder().encode(data.data(), data.size(), encoded);
+
+	GIVEN("truncated data")
+	{
+		THEN("decoding fails") {
+			std::vector<uint8_t> decoded;
+			CHECK_THROWS_AS(LzCoder().decode(encoded.data(), encoded.size() / 2, decoded), std::runtime_error);
+		}
+	}
+	GIVEN("an invalid window size in the data")
+	{
+		encoded[StreamHeader::SIZE] = LzCoder::MAX_WINDOW_BITS + 1;
+
+		THEN("it is refused") {
+			std::vector<uint8_t> decoded;
+			CHECK_THROWS_AS(LzCoder().decode(encoded.data(), encoded.size(), decoded), std::runtime_error);
+		}
+	}
+	GIVEN("data of another format")
+	{
+		std::vector<uint8_t> other;
+		AdaptiveScalingCoder().encode(data.data(), data.size(), other);
+
+		THEN("it is refused") {
+			std::vector<uint8_t> decoded;
+			CHECK_THROWS_AS(LzCoder().decode(other.data(), other.size(), decoded), std::runtime_error);
+		}
+	}
+	GIVEN("invalid window sizes")
+	{
+		THEN("an exception is thrown") {
+			CHECK_THROWS_AS(LzCoder(LzCoder::MIN_WINDOW_BITS - 1), std::invalid_argument);
+			CHECK_THROWS_AS(LzCoder(LzCoder::MAX_WINDOW_BITS + 1), std::invalid_argument);
+		}
+	}
+}
+
+SCENARIO("LzCoder compresses repetitive data better than order-0", "[LzCoder]")
+{
+	std::vector<uint8_t> data = logLines(200000);
+
+	GIVEN("log lines encoded with both coders")
+	{
+		std::vector<uint8_t> lz, order0;
+		LzCoder().encode(data.data(), data.size(), lz);
+		AdaptiveScalingCoder().encode(data.data(), data.size(), order0);
+
+		THEN("the LZ output is at least twice smaller") {
+			CAPTURE(lz.size(), order0.size());
+			CHECK(lz.size() * 2 < order0.size());
+		}
+	}
+}
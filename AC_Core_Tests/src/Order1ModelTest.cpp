@@ -0,0 +1,97 @@
+#include <catch2/catch.hpp>
+#include "Order1Model.hpp"
+#include "Order1Coder.hpp"
+#include "AdaptiveScalingCoder.hpp"
+
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#pragma warning( disable : 6237 6319 )
+
+SCENARIO("Order1Model keeps a table per context", "[Order1Model]")
+{
+	const size_t NUMBER_OF_SYMBOLS = 257;
+
+	GIVEN("Order1Model instance")
+	{
+		Order1Model model(NUMBER_OF_SYMBOLS, 1 << 30);
+
+		THEN("every context starts with all symbols once") {
+			CHECK(model.totalFrequency() == NUMBER_OF_SYMBOLS);
+			CHECK(model.frequencyBegin(10) == 10);
+			CHECK(model.frequencyEnd(10) == 11);
+		}
+		WHEN("a symbol is updated") {
+			model.update('a');		// counted in context 0, 'a' becomes the context
+
+			THEN("only the previous context changes") {
+				CHECK(model.totalFrequency() == NUMBER_OF_SYMBOLS);
+				model.update('b');	// counted in context 'a'
+				model.update(0);	// counted in context 'b'
+				CHECK(model.frequency('a') == 1 + Order1Model::INCREMENT);
+				CHECK(model.totalFrequency() == NUMBER_OF_SYMBOLS + Order1Model::INCREMENT);
+			}
+		}
+	}
+	GIVEN("too low max frequency")
+	{
+		THEN("an exception is thrown") {
+			CHECK_THROWS_AS(Order1Model(NUMBER_OF_SYMBOLS, NUMBER_OF_SYMBOLS), std::invalid_argument);
+		}
+	}
+}
+
+SCENARIO("Order1Model stays consistent after rescaling", "[Order1Model]")
+{
+	const size_t NUMBER_OF_SYMBOLS = GENERATE(2, 7, 257);
+
+	GIVEN("Order1Model updated many times")
+	{
+		Order1Model model(NUMBER_OF_SYMBOLS, 1 << 30);
+		srand((int)time(NULL));
+		for (int i = 0; i < 100000; i++)
+			model.update(rand() % 4 ? rand() % 2 : rand() % NUMBER_OF_SYMBOLS);
+
+		THEN("total frequency doesn't exceed maximum and cumulative frequencies match") {
+			CHECK(model.totalFrequency() <= Order1Model::MAX_CONTEXT_FREQUENCY);
+			CHECK(model.frequencyEnd(NUMBER_OF_SYMBOLS - 1) == model.totalFrequency());
+			bool allFound = true;
+			for (size_t count = 0; count < model.totalFrequency(); count++) {
+				size_t symbol = model.findSymbol(count);
+				allFound &= symbol < NUMBER_OF_SYMBOLS
+					&& model.frequencyBegin(symbol) <= count && count < model.frequencyEnd(symbol);
+			}
+			CHECK(allFound);
+		}
+	}
+}
+
+SCENARIO("Order1Coder compresses text better than order-0", "[Order1Model]")
+{
+	std::string text;
+	for (int i = 0; i < 2000; i++)
+		text += "the quick brown fox jumps over the lazy dog " + std::to_string(i % 37) + "\n";
+	const uint8_t* data = (const uint8_t*)text.data();
+
+	GIVEN("text encoded with both coders")
+	{
+		std::vector<uint8_t> order0, order1;
+		AdaptiveScalingCoder().encode(data, text.size(), order0);
+		Order1Coder().encode(data, text.size(), order1);
+
+		THEN("order-1 output is smaller") {
+			CHECK(order1.size() < order0.size() * 3 / 4);
+		}
+		THEN("it decodes to the same text") {
+			std::vector<uint8_t> decoded;
+			Order1Coder().decode(order1.data(), order1.size(), decoded);
+			CHECK(std::string(decoded.begin(), decoded.end()) == text);
+		}
+		THEN("order-0 coder refuses it") {
+			std::vector<uint8_t> decoded;
+			CHECK_THROWS_AS(AdaptiveScalingCoder().decode(order1.data(), order1.size(), decoded), std::runtime_error);
+		}
+	}
+}
@@ -0,0 +1,170 @@
+#include <catch2/catch.hpp>
+#include "PPMModel.hpp"
+#include "PPMCoder.hpp"
+#include "Order1Coder.hpp"
+
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#pragma warning( disable : 6237 6319 )
+
+namespace
+{
+	struct Step { uint64_t begin, end, total; };
+
+	// Remembers coded intervals instead of coding them.
+	struct RecordingEncoder
+	{
+		std::vector<Step> steps;
+		void encode(uint64_t begin, uint64_t end, uint64_t total) { steps.push_back({ begin, end, total }); }
+	};
+
+	// Gives the recorded intervals back to a decoding model.
+	struct ReplayingDecoder
+	{
+		const std::vector<Step>& steps;
+		size_t position = 0;
+		bool matching = true;
+
+		uint64_t count(uint64_t total)
+		{
+			matching &= position < steps.size() && steps[position].total == total;
+			return position < steps.size() ? steps[position].begin : 0;
+		}
+		void decode(uint64_t begin, uint64_t end, uint64_t total)
+		{
+			matching &= position < steps.size() && steps[position].begin == begin
+				&& steps[position].end == end && steps[position].total == total;
+			position++;
+		}
+	};
+}
+
+SCENARIO("PPMModel codes symbols in the longest context", "[PPMModel]")
+{
+	GIVEN("PPMModel instance")
+	{
+		PPMModel model(2, PPMModel::MIN_MEMORY);
+		RecordingEncoder encoder;
+
+		THEN("a new symbol is coded in order -1 out of all 257") {
+			model.encode('a', encoder);
+			REQUIRE(encoder.steps.size() == 1);
+			CHECK(encoder.steps[0].end - encoder.steps[0].begin == 1);
+			CHECK(encoder.steps[0].total == 257);
+		}
+		WHEN("a sequence is repeated") {
+			for (char symbol : std::string("abcabc"))
+				model.encode(symbol, encoder);
+			encoder.steps.clear();
+			model.encode('a', encoder);
+
+			THEN("it is coded in one step without escapes") {
+				REQUIRE(encoder.steps.size() == 1);
+				CHECK(encoder.steps[0].begin == 0);
+			}
+		}
+		WHEN("a seen symbol follows an unseen context") {
+			for (char symbol : std::string("ab"))
+				model.encode(symbol, encoder);
+			encoder.steps.clear();
+			model.encode('a', encoder);	// context "b" is empty, 'a' is known in order 0
+
+			THEN("escapes exclude nothing and the order-0 step finds it") {
+				REQUIRE(encoder.steps.size() == 1);
+				CHECK(encoder.steps[0].total == 2 + 2);	// 'a' and 'b' once, escape count 2
+			}
+		}
+	}
+	GIVEN("invalid parameters")
+	{
+		THEN("an exception is thrown") {
+			CHECK_THROWS_AS(PPMModel(0, PPMModel::MIN_MEMORY), std::invalid_argument);
+			CHECK_THROWS_AS(PPMModel(PPMModel::MAX_ORDER + 1, PPMModel::MIN_MEMORY), std::invalid_argument);
+			CHECK_THROWS_AS(PPMModel(2, PPMModel::MIN_MEMORY - 1), std::invalid_argument);
+		}
+	}
+}
+
+SCENARIO("PPMModel decodes what it encoded", "[PPMModel]")
+{
+	const int ORDER = GENERATE(1, 3, 8);
+	const size_t MEMORY = GENERATE(size_t(1) << 16, size_t(1) << 24);
+
+	GIVEN("random data with repetitions")
+	{
+		srand((int)time(NULL));
+		std::vector<size_t> data;
+		for (int i = 0; i < 50000; i++)
+			data.push_back(rand() % 3 ? "some repeated text "[i % 19] : rand() % 256);
+		data.push_back(PPMModel::EOF_SYMBOL);
+
+		PPMModel encodingModel(ORDER, MEMORY);
+		RecordingEncoder encoder;
+		for (size_t symbol : data)
+			encodingModel.encode(symbol, encoder);
+
+		WHEN("it is decoded by another model") {
+			PPMModel decodingModel(ORDER, MEMORY);
+			ReplayingDecoder decoder{ encoder.steps };
+			bool allDecoded = true;
+			for (size_t symbol : data)
+				allDecoded &= decodingModel.decode(decoder) == symbol;
+
+			THEN("symbols and intervals are the same") {
+				CHECK(allDecoded);
+				CHECK(decoder.matching);
+				CHECK(decoder.position == encoder.steps.size());
+				CHECK(decodingModel.restarts() == encodingModel.restarts());
+			}
+		}
+		THEN("every interval is valid") {
+			bool allValid = true;
+			for (const Step& step : encoder.steps)
+				allValid &= step.begin < step.end && step.end <= step.total && step.total <= 0xFFFF + 256;
+			CHECK(allValid);
+		}
+		THEN("a small arena fills up and restarts the model") {
+			if (MEMORY == PPMModel::MIN_MEMORY)
+				CHECK(encodingModel.restarts() > 0);
+			else
+				CHECK(encodingModel.restarts() == 0);
+		}
+	}
+}
+
+SCENARIO("PPMCoder compresses text better than order-1", "[PPMModel]")
+{
+	std::string text;
+	for (int i = 0; i < 2000; i++)
+		text += "the quick brown fox jumps over the lazy dog " + std::to_string(i % 37) + "\n";
+	const uint8_t* data = (const uint8_t*)text.data();
+
+	GIVEN("text encoded with both coders")
+	{
+		std::vector<uint8_t> order1, ppm;
+		Order1Coder().encode(data, text.size(), order1);
+		PPMCoder(4, PPMCoder::MEMORY_UNIT).encode(data, text.size(), ppm);
+
+		THEN("ppm output is smaller") {
+			CHECK(ppm.size() < order1.size() / 2);
+		}
+		THEN("it decodes to the same text") {
+			std::vector<uint8_t> decoded;
+			PPMCoder().decode(ppm.data(), ppm.size(), decoded);
+			CHECK(std::string(decoded.begin(), decoded.end()) == text);
+		}
+		THEN("truncated data is detected") {
+			std::vector<uint8_t> decoded;
+			CHECK_THROWS_AS(PPMCoder().decode(ppm.data(), ppm.size() / 2, decoded), std::runtime_error);
+		}
+	}
+	GIVEN("memory limit that is not a whole number of MiB")
+	{
+		THEN("an exception is thrown") {
+			CHECK_THROWS_AS(PPMCoder(4, PPMCoder::MEMORY_UNIT + 1), std::invalid_argument);
+		}
+	}
+}
@@ -0,0 +1,74 @@
+#include <catch2/catch.hpp>
+#include "CoderTestHelpers.hpp"
+#include "RansCoder.hpp"
+#include "StaticCoder.hpp"
+
+#include <vector>
+#pragma warning( disable : 6237 6319 )
+
+SCENARIO("RansCoder decodes what it encoded", "[RansCoder]")
+{
+	const int STATES = GENERATE(2, 3, 4, 8);
+	const size_t SIZE = GENERATE(0, 1, 2, 17, 100000, RansCoder::CHUNK_SIZE + 5);
+	std::vector<uint8_t> data = skewedData(SIZE);
+
+	GIVEN("data encoded with " << STATES << " states")
+	{
+		std::vector<uint8_t> encoded = encodedWith(RansCoder(STATES), data);
+
+		THEN("it decodes to the same data and refuses it truncated") {
+			checkDecodes(RansCoder(), encoded, encoded.size() - 1, data);
+		}
+	}
+}
+
+SCENARIO("RansCoder detects corrupted data", "[RansCoder]")
+{
+	std::vector<uint8_t> data = skewedData(10000);
+
+	GIVEN("encoded data with a changed byte")
+	{
+		std::vector<uint8_t> encoded;
+		RansCoder().encode(data.data(), data.size(), encoded);
+		encoded[encoded.size() / 2] ^= 0x5A;
+
+		THEN("decoding fails instead of giving wrong data") {
+			std::vector<uint8_t> decoded;
+			CHECK_THROWS_AS(RansCoder().decode(encoded.data(), encoded.size(), decoded), std::runtime_error);
+		}
+	}
+	GIVEN("data of another format")
+	{
+		std::vector<uint8_t> encoded;
+		StaticCoder().encode(data.data(), data.size(), encoded);
+
+		THEN("it is refused") {
+			std::vector<uint8_t> decoded;
+			CHECK_THROWS_AS(RansCoder().decode(encoded.data(), encoded.size(), decoded), std::runtime_error);
+		}
+	}
+	GIVEN("invalid number of states")
+	{
+		THEN("an exception is thrown") {
+			CHECK_THROWS_AS(RansCoder(1), std::invalid_argument);
+			CHECK_THROWS_AS(RansCoder(9), std::invalid_argument);
+		}
+	}
+}
+
+SCENARIO("RansCoder compresses as well as the static coder", "[RansCoder]")
+{
+	std::vector<uint8_t> data = skewedData(200000);
+
+	GIVEN("data encoded with both coders")
+	{
+		std::vector<uint8_t> rans, arithmetic;
+		RansCoder().encode(data.data(), data.size(), rans);
+		StaticCoder().encode(data.data(), data.size(), arithmetic);
+
+		THEN("the sizes differ by less than 0.5%") {
+			CAPTURE(rans.size(), arithmetic.size());
+			CHECK(rans.size() < arithmetic.size() * 1005 / 1000);
+		}
+	}
+}
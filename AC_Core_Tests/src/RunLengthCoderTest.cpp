@@ -0,0 +1,113 @@
+#include <catch2/catch.hpp>
+#include "CoderTestHelpers.hpp"
+#include "RunLengthCoder.hpp"
+#include "AdaptiveScalingCoder.hpp"
+
+#include <vector>
+#pragma warning( disable : 6237 6319 )
+
+// Runs of random length (some shorter than MIN_RUN) of a few bytes.
+static std::vector<uint8_t> runs(size_t size, uint32_t maxRun)
+{
+	std::vector<uint8_t> data;
+	uint32_t state = 2020;
+	while (data.size() < size) {
+		state = state * 1103515245 + 12345;
+		size_t length = 1 + (state >> 8) % maxRun;
+		data.insert(data.end(), std::min(length, size - data.size()), (uint8_t)(state >> 28));
+	}
+	return data;
+}
+
+SCENARIO("RunLengthCoder decodes what it encoded", "[RunLengthCoder]")
+{
+	const uint32_t MAX_RUN = GENERATE(1, 2, 12, 3000);
+	const size_t SIZE = GENERATE(0, 1, 9, 100000);
+
+	GIVEN(SIZE << " bytes in runs of up to " << MAX_RUN)
+	{
+		std::vector<uint8_t> data = runs(SIZE, MAX_RUN);
+		std::vector<uint8_t> encoded = encodedWith(RunLengthCoder(), data);
+
+		THEN("it decodes to the same data and refuses it truncated") {
+			checkDecodes(RunLengthCoder(), encoded, encoded.size() / 2, data);
+		}
+		THEN("the encoder fed in chunks of 5 bytes gives the same output") {
+			std::vector<uint8_t> chunked;
+			MemorySink sink(chunked);
+			RunLengthCoder::Encoder encoder(sink);
+			for (size_t i = 0; i < data.size(); i += 5)
+				encoder.feed(data.data() + i, std::min<size_t>(5, data.size() - i));
+			encoder.finish();
+			CHECK(chunked == encoded);
+		}
+	}
+	GIVEN("a run of zeros longer than the output buffer")
+	{
+		std::vector<uint8_t> data(1000000, 0);
+		data.push_back(1);
+
+		std::vector<uint8_t> encoded;
+		RunLengthCoder().encode(data.data(), data.size(), encoded);
+
+		THEN("it takes a few bytes and decodes") {
+			CHECK(encoded.size() < 20);
+			std::vector<uint8_t> decoded;
+			RunLengthCoder().decode(encoded.data(), encoded.size(), decoded);
+			CHECK(decoded == data);
+		}
+	}
+}
+
+SCENARIO("RunLengthCoder detects invalid data", "[RunLengthCoder]")
+{
+	std::vector<uint8_t> data = runs(20000, 100);
+	std::vector<uint8_t> encoded;
+	RunLengthCoder().encode(data.data(), data.size(), encoded);
+
+	GIVEN("truncated data")
+	{
+		THEN("decoding fails") {
+			std::vector<uint8_t> decoded;
+			CHECK_THROWS_AS(RunLengthCoder().decode(encoded.data(), encoded.size() / 2, decoded), std::runtime_error);
+		}
+	}
+	GIVEN("data of another format")
+	{
+		std::vector<uint8_t> other;
+		AdaptiveScalingCoder().encode(data.data(), data.size(), other);
+
+		THEN("it is refused") {
+			std::vector<uint8_t> decoded;
+			CHECK_THROWS_AS(RunLengthCoder().decode(other.data(), other.size(), decoded), std::runtime_error);
+		}
+	}
+}
+
+SCENARIO("RunLengthCoder compresses like order-0 without runs and better with them", "[RunLengthCoder]")
+{
+	GIVEN("data without runs")
+	{
+		std::vector<uint8_t> data = runs(100000, 1);
+		std::vector<uint8_t> withRuns, order0;
+		RunLengthCoder().encode(data.data(), data.size(), withRuns);
+		AdaptiveScalingCoder().encode(data.data(), data.size(), order0);
+
+		THEN("the sizes differ by less than 1%") {
+			CAPTURE(withRuns.size(), order0.size());
+			CHECK(withRuns.size() < order0.size() * 101 / 100);
+		}
+	}
+	GIVEN("long runs")
+	{
+		std::vector<uint8_t> data = runs(100000, 3000);
+		std::vector<uint8_t> withRuns, order0;
+		RunLengthCoder().encode(data.data(), data.size(), withRuns);
+		AdaptiveScalingCoder().encode(data.data(), data.size(), order0);
+
+		THEN("the output is at least 10 times smaller") {
+			CAPTURE(withRuns.size(), order0.size());
+			CHECK(withRuns.size() * 10 < order0.size());
+		}
+	}
+}
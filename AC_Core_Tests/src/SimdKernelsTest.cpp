@@ -0,0 +1,160 @@
+#include <catch2/catch.hpp>
+#include "SimdKernels.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#pragma warning( disable : 6237 6319 )
+
+using InstructionSet = SimdKernels::InstructionSet;
+
+template <typename T>
+static std::vector<T> randomValues(size_t size, uint32_t max, uint32_t seed)
+{
+	std::mt19937 random(seed);
+	std::vector<T> values(size);
+	for (T& value : values)
+		value = (T)(random() % ((uint64_t)max + 1));
+	return values;
+}
+
+SCENARIO("SimdKernels give the same results with every instruction set", "[SimdKernels]")
+{
+	const InstructionSet SET = GENERATE(InstructionSet::SSE2, InstructionSet::AVX2);
+	const size_t SIZE = GENERATE(0, 1, 7, 8, 15, 16, 17, 33, 257, 1000);
+	if (SET > SimdKernels::supported())
+		return;		// nothing to compare on this processor
+
+	struct RestoreActive {
+		InstructionSet previous = SimdKernels::active();
+		~RestoreActive() { SimdKernels::setActive(previous); }
+	} restore;
+
+	GIVEN(SimdKernels::name(SET) << " and " << SIZE << " counters")
+	{
+		THEN("32-bit halving keeps counters positive and returns their sum") {
+			auto scalar = randomValues<uint32_t>(SIZE, 0xFFFFFFFF, 1);
+			auto vector = scalar;
+			SimdKernels::setActive(InstructionSet::Scalar);
+			uint64_t scalarSum = SimdKernels::halve(scalar.data(), SIZE);
+			SimdKernels::setActive(SET);
+			uint64_t vectorSum = SimdKernels::halve(vector.data(), SIZE);
+
+			CHECK(vector == scalar);
+			CHECK(vectorSum == scalarSum);
+		}
+		THEN("16-bit halving keeps counters positive and returns their sum") {
+			auto scalar = randomValues<uint16_t>(SIZE, 3, 2);	// many counters become 0
+			auto vector = scalar;
+			SimdKernels::setActive(InstructionSet::Scalar);
+			uint64_t scalarSum = SimdKernels::halve(scalar.data(), SIZE);
+			SimdKernels::setActive(SET);
+			uint64_t vectorSum = SimdKernels::halve(vector.data(), SIZE);
+
+			CHECK(vector == scalar);
+			CHECK(vectorSum == scalarSum);
+			for (uint16_t counter : vector)
+				CHECK(counter >= 1);
+		}
+		THEN("prefix sums are the same, also when they wrap around") {
+			auto scalar32 = randomValues<uint32_t>(SIZE, 0xFFFFFFFF, 3);
+			auto vector32 = scalar32;
+			auto scalar16 = randomValues<uint16_t>(SIZE, 0xFFFF, 4);
+			auto vector16 = scalar16;
+			SimdKernels::setActive(InstructionSet::Scalar);
+			SimdKernels::prefixSum(scalar32.data(), SIZE);
+			SimdKernels::prefixSum(scalar16.data(), SIZE);
+			SimdKernels::setActive(SET);
+			SimdKernels::prefixSum(vector32.data(), SIZE);
+			SimdKernels::prefixSum(vector16.data(), SIZE);
+
+			CHECK(vector32 == scalar32);
+			CHECK(vector16 == scalar16);
+		}
+		THEN("merged histograms are the same") {
+			auto part = randomValues<uint32_t>(SIZE, 0xFFFFFFFF, 5);
+			std::vector<uint64_t> scalar(SIZE, 0xFFFFFFFFull), vector(SIZE, 0xFFFFFFFFull);
+			SimdKernels::setActive(InstructionSet::Scalar);
+			SimdKernels::addCounts(scalar.data(), part.data(), SIZE);
+			SimdKernels::setActive(SET);
+			SimdKernels::addCounts(vector.data(), part.data(), SIZE);
+
+			CHECK(vector == scalar);
+		}
+		THEN("upper bounds in a sorted array are the same") {
+			auto sorted = randomValues<uint32_t>(SIZE, 1000, 6);
+			SimdKernels::prefixSum(sorted.data(), SIZE);
+			for (uint32_t value : { 0u, 1u, 500u, 5000u, 100000u, 0xFFFFFFFFu }) {
+				SimdKernels::setActive(InstructionSet::Scalar);
+				size_t scalar = SimdKernels::upperBound(sorted.data(), SIZE, value);
+				SimdKernels::setActive(SET);
+				CHECK(SimdKernels::upperBound(sorted.data(), SIZE, value) == scalar);
+			}
+		}
+	}
+}
+
+SCENARIO("Inline SimdKernels give the same results as scalar code", "[SimdKernels]")
+{
+	const InstructionSet SET = GENERATE(InstructionSet::Scalar, InstructionSet::SSE2);
+	const size_t SIZE = GENERATE(4, 16, 20);
+	InstructionSet previous = SimdKernels::active();
+	SimdKernels::setActive(SET);
+
+	GIVEN(SimdKernels::name(SET) << " and " << SIZE << " sorted values")
+	{
+		std::vector<uint32_t> sorted(SIZE);
+		for (size_t i = 0; i < SIZE; i++)
+			sorted[i] = 0x7FFFFFF0u + 2 * (uint32_t)i;	// around the sign bit
+		sorted.back() = 0xFFFFFFFF;
+
+		THEN("upper bounds are like std::upper_bound") {
+			for (uint32_t value = 0x7FFFFFEEu; value != 0x80000030u; value++)
+				CHECK(SimdKernels::upperBoundShort(sorted.data(), SIZE, value)
+					== (size_t)(std::upper_bound(sorted.begin(), sorted.end(), value) - sorted.begin()));
+			CHECK(SimdKernels::upperBoundShort(sorted.data(), SIZE, 0xFFFFFFFF) == SIZE);
+		}
+		THEN("only values in the range are incremented") {
+			for (int begin = -2; begin <= (int)SIZE + 1; begin++)
+				for (int end = begin; end <= (int)SIZE + 2; end++) {
+					std::vector<uint32_t> values(SIZE, 7);
+					SimdKernels::increment(values.data(), SIZE, begin, end);
+					for (int i = 0; i < (int)SIZE; i++)
+						REQUIRE(values[i] == (begin <= i && i < end ? 8u : 7u));
+				}
+		}
+	}
+	SimdKernels::setActive(previous);
+}
+
+SCENARIO("SimdKernels compute what they are documented to", "[SimdKernels]")
+{
+	GIVEN("small arrays")
+	{
+		uint32_t counters[] = { 0, 1, 2, 3, 10, 0xFFFFFFFF };
+		uint16_t values[] = { 1, 2, 3, 0xFFFF, 5 };
+
+		THEN("halving floors at 1") {
+			CHECK(SimdKernels::halve(counters, 6) == 1 + 1 + 1 + 1 + 5 + 0x7FFFFFFFull);
+			CHECK(counters[0] == 1);
+			CHECK(counters[4] == 5);
+		}
+		THEN("prefix sums are inclusive and wrap around") {
+			SimdKernels::prefixSum(values, 5);
+			CHECK(values[0] == 1);
+			CHECK(values[2] == 6);
+			CHECK(values[3] == 5);
+			CHECK(values[4] == 10);
+		}
+	}
+	GIVEN("an instruction set the processor may not support")
+	{
+		InstructionSet previous = SimdKernels::active();
+		SimdKernels::setActive(InstructionSet::AVX2);
+
+		THEN("it is lowered to a supported one") {
+			CHECK(SimdKernels::active() <= SimdKernels::supported());
+		}
+		SimdKernels::setActive(previous);
+	}
+}
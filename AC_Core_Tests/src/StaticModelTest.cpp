@@ -0,0 +1,137 @@
+#include <catch2/catch.hpp>
+#include "CoderTestHelpers.hpp"
+#include "StaticModel.hpp"
+#include "StaticCoder.hpp"
+#include "AdaptiveScalingCoder.hpp"
+
+#include <vector>
+#pragma warning( disable : 6237 6319 )
+
+SCENARIO("StaticModel normalizes counts", "[StaticModel]")
+{
+	GIVEN("counts with frequent, rare and missing bytes")
+	{
+		uint64_t counts[256] = {};
+		counts['a'] = 1000000000;
+		counts['b'] = 3;
+		counts['c'] = 500000000;
+		for (int s = 200; s < 256; s++)
+			counts[s] = 1;
+
+		StaticModel model(counts);
+
+		THEN("every counted byte keeps a frequency and the total is fixed") {
+			CHECK(model.frequencyEnd(StaticModel::EOF_SYMBOL) == StaticModel::TOTAL_FREQUENCY);
+			CHECK(model.frequency(StaticModel::EOF_SYMBOL) >= 1);
+			CHECK(model.frequency('b') >= 1);
+			CHECK(model.frequency(255) >= 1);
+			CHECK(model.frequency('d') == 0);
+			CHECK(model.frequency('a') > model.frequency('c'));
+		}
+		THEN("every count maps to the symbol that covers it") {
+			bool allFound = true;
+			for (size_t s = 0; s < StaticModel::NUMBER_OF_SYMBOLS; s++)
+				for (size_t count = model.frequencyBegin(s); count < model.frequencyEnd(s); count++)
+					allFound &= model.findSymbol(count) == s;
+			CHECK(allFound);
+		}
+		WHEN("it is serialized") {
+			std::vector<uint8_t> table;
+			model.serialize(table);
+
+			THEN("only counted bytes are stored and the table reads back the same") {
+				CHECK(table.size() == StaticModel::BIT_SET_SIZE + 2 * (3 + 56));
+				CHECK(StaticModel::serializedSize(table.data()) == table.size());
+				StaticModel read(table.data(), table.size());
+				for (size_t s = 0; s <= StaticModel::NUMBER_OF_SYMBOLS; s++)
+					CHECK(read.frequencyBegin(s) == model.frequencyBegin(s));
+			}
+			THEN("a table without room for the end of data is refused") {
+				table[StaticModel::BIT_SET_SIZE + 1] = 0x7F;	// frequency of 'a' close to the total
+				CHECK_THROWS_AS(StaticModel(table.data(), table.size()), std::runtime_error);
+			}
+			THEN("a truncated table is refused") {
+				CHECK_THROWS_AS(StaticModel(table.data(), table.size() - 1), std::runtime_error);
+			}
+		}
+	}
+	GIVEN("no counts at all")
+	{
+		uint64_t counts[256] = {};
+		StaticModel model(counts);
+
+		THEN("the end of data takes everything") {
+			CHECK(model.frequency(StaticModel::EOF_SYMBOL) == StaticModel::TOTAL_FREQUENCY);
+		}
+	}
+}
+
+SCENARIO("StaticCoder counts bytes on many threads", "[StaticCoder]")
+{
+	const unsigned THREADS = GENERATE(1, 3, 8);
+	std::vector<uint8_t> data = skewedData(3 * 1000 * 1000 + 7);
+
+	GIVEN("a seekable source")
+	{
+		MemorySource source(data.data(), data.size());
+
+		THEN("counts are the same as counted directly") {
+			uint64_t expected[256] = {}, counts[256];
+			for (uint8_t byte : data)
+				expected[byte]++;
+			StaticCoder::countBytes(source, THREADS, counts);
+			CHECK(std::equal(counts, counts + 256, expected));
+		}
+	}
+}
+
+SCENARIO("StaticCoder decodes what it encoded", "[StaticCoder]")
+{
+	const size_t SIZE = GENERATE(0, 1, 2, 17, 100000);
+	std::vector<uint8_t> data = skewedData(SIZE);
+
+	GIVEN("encoded data")
+	{
+		std::vector<uint8_t> encoded = encodedWith(StaticCoder(2), data);
+
+		THEN("it decodes to the same data and refuses it truncated") {
+			checkDecodes(StaticCoder(), encoded, encoded.size() / 2, data);
+		}
+		THEN("it decodes the same when fed byte by byte") {
+			checkDecodesInChunks<StaticCoder::Decoder>(encoded, 1, data);
+		}
+		THEN("a truncated table is detected") {
+			std::vector<uint8_t> decoded;
+			CHECK_THROWS_AS(StaticCoder().decode(encoded.data(), StreamHeader::SIZE + 10, decoded), std::runtime_error);
+		}
+		THEN("the same data from a source that is not seekable is encoded the same") {
+			QueueSource source;
+			source.push(data.data(), data.size());
+			std::vector<uint8_t> again;
+			MemorySink sink(again);
+			StaticCoder().encode(source, sink);
+			CHECK(again == encoded);
+		}
+	}
+}
+
+SCENARIO("StaticCoder compresses about as well as the adaptive order-0 coder", "[StaticCoder]")
+{
+	std::vector<uint8_t> data = skewedData(200000);
+
+	GIVEN("data encoded with both coders")
+	{
+		std::vector<uint8_t> adaptive, frozen;
+		AdaptiveScalingCoder().encode(data.data(), data.size(), adaptive);
+		StaticCoder().encode(data.data(), data.size(), frozen);
+
+		THEN("the sizes differ by less than 1%") {
+			CAPTURE(adaptive.size(), frozen.size());
+			CHECK(frozen.size() < adaptive.size() * 101 / 100);
+		}
+		THEN("order-0 coder refuses the static stream") {
+			std::vector<uint8_t> decoded;
+			CHECK_THROWS_AS(AdaptiveScalingCoder().decode(frozen.data(), frozen.size(), decoded), std::runtime_error);
+		}
+	}
+}
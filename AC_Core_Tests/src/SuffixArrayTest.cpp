@@ -0,0 +1,62 @@
+#include <catch2/catch.hpp>
+#include "SuffixArray.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#pragma warning( disable : 6237 6319 )
+
+static std::vector<uint8_t> randomBytes(size_t size, uint32_t alphabet, uint32_t seed)
+{
+	std::vector<uint8_t> data(size);
+	uint32_t state = seed;
+	for (uint8_t& byte : data) {
+		state = state * 1103515245 + 12345;
+		byte = (uint8_t)((state >> 16) % alphabet);
+	}
+	return data;
+}
+
+// Sorts suffixes by comparing them, a shorter one first if it is a prefix.
+static std::vector<int32_t> naiveSuffixArray(const std::vector<uint8_t>& data)
+{
+	std::vector<int32_t> sa(data.size() + 1);
+	for (size_t i = 0; i < sa.size(); i++)
+		sa[i] = (int32_t)i;
+	std::sort(sa.begin(), sa.end(), [&](int32_t a, int32_t b) {
+		return std::lexicographical_compare(data.begin() + a, data.end(), data.begin() + b, data.end());
+	});
+	return sa;
+}
+
+SCENARIO("suffixArray sorts all suffixes", "[SuffixArray]")
+{
+	const uint32_t ALPHABET = GENERATE(1, 2, 4, 256);
+	const size_t SIZE = GENERATE(0, 1, 2, 3, 10, 100, 5000);
+
+	GIVEN(SIZE << " bytes of an alphabet of " << ALPHABET)
+	{
+		std::vector<uint8_t> data = randomBytes(SIZE, ALPHABET, (uint32_t)SIZE + ALPHABET);
+		std::vector<int32_t> sa;
+		suffixArray(data.data(), data.size(), sa);
+
+		THEN("it is the same as from comparing them") {
+			CHECK(sa == naiveSuffixArray(data));
+			CHECK(sa[0] == (int32_t)SIZE);
+		}
+	}
+	GIVEN("repetitive text")
+	{
+		const char* text = "abracadabra abracadabra mississippi mississippi abracadabra ";
+		std::vector<uint8_t> data;
+		for (int i = 0; i < 50; i++)
+			data.insert(data.end(), text, text + strlen(text) - i % 3);
+
+		std::vector<int32_t> sa = { 7, 7, 7 };	// reused
+		suffixArray(data.data(), data.size(), sa);
+
+		THEN("it is the same as from comparing them") {
+			CHECK(sa == naiveSuffixArray(data));
+		}
+	}
+}
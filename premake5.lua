@@ -33,6 +33,11 @@ workspace "Arithmetic Coder"
         --buildoptions {"-stdlib=libc++"}
     filter {}
 
+    -- std::thread support (block mode)
+    filter "system:linux"
+        links "pthread"
+    filter {}
+
     -- AC_Core project cotains logic and algorithms for arithmetic coding.
     -- It also manages filesystem for input and output data.
     project "AC_Core"
@@ -75,6 +80,34 @@ workspace "Arithmetic Coder"
         }
 
 
+    -- Benchmark of the coders on synthetic corpora and user files.
+    -- Run with --help to see the options; results can be saved to JSON.
+    project "AC_Bench"
+        location "AC_Bench"
+        kind "ConsoleApp"
+        language "C++"
+        cppdialect "C++17"
+        targetname "ac_bench"
+
+        files {
+            "%{prj.name}/src/**.hpp",
+            "%{prj.name}/src/**.cpp"
+        }
+
+        includedirs {
+            "AC_Core/src",
+            "AC_CLI/vendor"
+        }
+
+        links {
+            "AC_Core"
+        }
+
+        filter "Release"
+            optimize "Speed"
+        filter {}
+
+
     group "Tests"
 
         -- Tests project for AC_Core. It produces executable with